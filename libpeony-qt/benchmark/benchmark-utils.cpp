@@ -0,0 +1,98 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#include "benchmark-utils.h"
+
+#include <QFile>
+#include <QJsonDocument>
+
+#include <sys/resource.h>
+
+void BenchmarkUtils::resetPeakRss()
+{
+    //writing 5 resets the peak resident set size of process.
+    QFile file("/proc/self/clear_refs");
+    if (file.open(QIODevice::WriteOnly))
+        file.write("5");
+}
+
+qint64 BenchmarkUtils::peakRssKb()
+{
+    QFile file("/proc/self/status");
+    if (file.open(QIODevice::ReadOnly)) {
+        for (auto line : file.readAll().split('\n')) {
+            if (line.startsWith("VmHWM:"))
+                return line.mid(6).trimmed().split(' ').first().toLongLong();
+        }
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+QString BenchmarkUtils::resultKey(const QJsonObject &object, const QStringList &keyFields)
+{
+    QStringList values;
+    for (auto field : keyFields) {
+        values<<object.value(field).toVariant().toString();
+    }
+    return values.join("|");
+}
+
+QHash<QString, double> BenchmarkUtils::loadBaseline(const QString &path, const QStringList &keyFields)
+{
+    QHash<QString, double> baseline;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return baseline;
+
+    for (auto line : file.readAll().split('\n')) {
+        auto object = QJsonDocument::fromJson(line).object();
+        if (object.isEmpty() || !object.value("successed").toBool())
+            continue;
+        auto key = resultKey(object, keyFields);
+        double ms = object.value("time_to_complete_ms").toDouble();
+        if (!baseline.contains(key) || ms < baseline.value(key))
+            baseline.insert(key, ms);
+    }
+    return baseline;
+}
+
+bool BenchmarkUtils::checkBaseline(const QHash<QString, double> &bestTimes, const QString &path, const QStringList &keyFields,
+                                   double tolerance, QTextStream &err)
+{
+    auto baseline = loadBaseline(path, keyFields);
+    bool regressed = false;
+    for (auto key : bestTimes.keys()) {
+        if (!baseline.contains(key))
+            continue;
+        double current = bestTimes.value(key);
+        double previous = baseline.value(key);
+        if (current > previous * (1 + tolerance)) {
+            err<<"regression: "<<key<<" "<<previous<<"ms -> "<<current<<"ms"<<endl;
+            regressed = true;
+        }
+    }
+    return !regressed;
+}
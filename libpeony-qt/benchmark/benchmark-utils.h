@@ -0,0 +1,76 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#ifndef BENCHMARKUTILS_H
+#define BENCHMARKUTILS_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QJsonObject>
+#include <QTextStream>
+
+/*!
+ * \brief The BenchmarkUtils class
+ * <br>
+ * The helpers shared by the headless benchmarks, which print one JSON object
+ * per run, and compare the best time to complete of each scenario with a
+ * previous output.
+ * </br>
+ * \note a benchmark includes benchmark-utils.pri to use it.
+ */
+class BenchmarkUtils
+{
+public:
+    /*!
+     * \brief resetPeakRss
+     * reset the peak resident set size of process before a run, since linux 4.0.
+     */
+    static void resetPeakRss();
+    static qint64 peakRssKb();
+
+    /*!
+     * \brief resultKey
+     * \param object, the JSON object of a run.
+     * \param keyFields, the fields identifying the scenario of run.
+     * \return the key of runs which are compared with each other.
+     */
+    static QString resultKey(const QJsonObject &object, const QStringList &keyFields);
+    /*!
+     * \brief loadBaseline
+     * \return the best time to complete of each key in a previous output,
+     * the failed runs are skipped.
+     */
+    static QHash<QString, double> loadBaseline(const QString &path, const QStringList &keyFields);
+    /*!
+     * \brief checkBaseline
+     * \param bestTimes, the best time to complete of each key in this output.
+     * \param tolerance, the ratio a time may be slower than the baseline.
+     * \return false if any key is slower than the baseline more than tolerance,
+     * the regressions are printed to err.
+     */
+    static bool checkBaseline(const QHash<QString, double> &bestTimes, const QString &path, const QStringList &keyFields,
+                              double tolerance, QTextStream &err);
+};
+
+#endif // BENCHMARKUTILS_H
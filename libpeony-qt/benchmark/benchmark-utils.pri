@@ -0,0 +1,5 @@
+INCLUDEPATH += $$PWD
+
+HEADERS += $$PWD/benchmark-utils.h
+
+SOURCES += $$PWD/benchmark-utils.cpp
@@ -49,6 +49,7 @@
 #include <QPushButton>
 
 #include "clipboard-utils.h"
+#include "thumbnail-shadow.h"
 
 #include <QTextLayout>
 #include <QFileInfo>
@@ -137,7 +138,7 @@ void IconViewDelegate::paint(QPainter *painter, const QStyleOptionViewItem &opti
 
     auto text = opt.text;
     opt.text = nullptr;
-    style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, opt.widget);
+    ThumbnailShadow::paintItem(painter, opt, index.data(FileItemModel::UriRole).toString(), opt.widget);
     opt.text = text;
     //auto textSize = IconViewTextHelper::getTextSizeForIndex(opt, index, 2, 2);
     painter->save();
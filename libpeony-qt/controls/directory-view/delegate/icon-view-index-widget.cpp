@@ -39,6 +39,7 @@
 #include "file-info.h"
 #include "file-item-proxy-filter-sort-model.h"
 #include "file-item.h"
+#include "thumbnail-shadow.h"
 
 #include <QDebug>
 
@@ -165,7 +166,7 @@ void IconViewIndexWidget::paintEvent(QPaintEvent *e)
     opt.rect = rawRect;
     auto tmp = opt.text;
     opt.text = nullptr;
-    QApplication::style()->drawControl(QStyle::CE_ItemViewItem, &opt, &p, opt.widget);
+    ThumbnailShadow::paintItem(&p, opt, m_index.data(Qt::UserRole).toString(), opt.widget);
     if (b_elide_text)
     {
         int  charWidth = opt.fontMetrics.averageCharWidth();
@@ -31,6 +31,7 @@
 #include "file-utils.h"
 
 #include "global-settings.h"
+#include "thumbnail-manager.h"
 
 #include <QMouseEvent>
 
@@ -107,6 +108,10 @@ IconView::IconView(QWidget *parent) : QListView(parent)
     m_editValid = false;
 
     setMouseTracking(true);//追踪鼠标
+
+    m_visible_uris_timer.setSingleShot(true);
+    m_visible_uris_timer.setInterval(100);
+    connect(&m_visible_uris_timer, &QTimer::timeout, this, &IconView::reportVisibleUris);
 }
 
 IconView::~IconView()
@@ -355,6 +360,50 @@ void IconView::paintEvent(QPaintEvent *e)
         });
     }
     QListView::paintEvent(e);
+
+    //scrolling, resizing and model changes all repaint the view.
+    if (!m_visible_uris_timer.isActive())
+        m_visible_uris_timer.start();
+}
+
+void IconView::reportVisibleUris()
+{
+    if (!m_sort_filter_proxy_model)
+        return;
+
+    QStringList uris;
+    QRect viewportRect = viewport()->rect();
+    int rowCount = m_sort_filter_proxy_model->rowCount();
+
+    //items are laid out line by line, the first visible row could be found by bisection.
+    int low = 0;
+    int high = rowCount;
+    while (low < high) {
+        int mid = (low + high)/2;
+        if (visualRect(m_sort_filter_proxy_model->index(mid, 0)).bottom() < viewportRect.top()) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    for (int row = low; row < rowCount; row++) {
+        auto index = m_sort_filter_proxy_model->index(row, 0);
+        auto rect = visualRect(index);
+        if (rect.top() > viewportRect.bottom())
+            break;
+        if (!rect.intersects(viewportRect))
+            continue;
+        auto item = m_sort_filter_proxy_model->itemFromIndex(index);
+        if (item)
+            uris<<item->uri();
+    }
+
+    if (uris == m_visible_uris)
+        return;
+
+    m_visible_uris = uris;
+    ThumbnailManager::getInstance()->setVisibleUris(this, uris);
 }
 
 void IconView::resizeEvent(QResizeEvent *e)
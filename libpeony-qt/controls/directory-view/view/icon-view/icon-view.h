@@ -159,9 +159,17 @@ protected:
 
 private Q_SLOTS:
     void slotRename();
+    /*!
+     * \brief reportVisibleUris
+     * tell ThumbnailManager which files are in viewport, so that their thumbnails
+     * are generated first.
+     */
+    void reportVisibleUris();
 
 private:
     QTimer m_repaint_timer;
+    QTimer m_visible_uris_timer;
+    QStringList m_visible_uris;
 
     bool  m_editValid;
     bool  m_ctrl_key_pressed;
@@ -32,6 +32,7 @@
 #include "list-view-style.h"
 
 #include "global-settings.h"
+#include "thumbnail-manager.h"
 
 #include <QHeaderView>
 
@@ -101,6 +102,10 @@ ListView::ListView(QWidget *parent) : QTreeView(parent)
     setMouseTracking(true);//追踪鼠标
 
     m_rubberBand = new QRubberBand(QRubberBand::Shape::Rectangle, this);
+
+    m_visible_uris_timer.setSingleShot(true);
+    m_visible_uris_timer.setInterval(100);
+    connect(&m_visible_uris_timer, &QTimer::timeout, this, &ListView::reportVisibleUris);
 }
 
 void ListView::scrollTo(const QModelIndex &index, QAbstractItemView::ScrollHint hint)
@@ -445,6 +450,39 @@ void ListView::resizeEvent(QResizeEvent *e)
 //    //setViewportMargins(0, header()->height(), 0, height);
 //}
 
+void ListView::paintEvent(QPaintEvent *e)
+{
+    QTreeView::paintEvent(e);
+
+    //scrolling, resizing and model changes all repaint the view.
+    if (!m_visible_uris_timer.isActive())
+        m_visible_uris_timer.start();
+}
+
+void ListView::reportVisibleUris()
+{
+    if (!m_proxy_model)
+        return;
+
+    QStringList uris;
+    QRect viewportRect = viewport()->rect();
+    auto index = indexAt(viewportRect.topLeft());
+    while (index.isValid()) {
+        if (visualRect(index).top() > viewportRect.bottom())
+            break;
+        auto item = m_proxy_model->itemFromIndex(index.sibling(index.row(), 0));
+        if (item)
+            uris<<item->uri();
+        index = indexBelow(index);
+    }
+
+    if (uris == m_visible_uris)
+        return;
+
+    m_visible_uris = uris;
+    ThumbnailManager::getInstance()->setVisibleUris(this, uris);
+}
+
 void ListView::wheelEvent(QWheelEvent *e)
 {
     if (e->modifiers() & Qt::ControlModifier) {
@@ -127,6 +127,7 @@ protected:
     void dropEvent(QDropEvent *e) override;
 
     void resizeEvent(QResizeEvent *e) override;
+    void paintEvent(QPaintEvent *e) override;
 
 //    void updateGeometries() override;
 
@@ -138,11 +139,18 @@ protected:
 
 private Q_SLOTS:
     void slotRename();
+    /*!
+     * \brief reportVisibleUris
+     * \see IconView::reportVisibleUris().
+     */
+    void reportVisibleUris();
 private:
     FileItemModel *m_model = nullptr;
     FileItemProxyFilterSortModel *m_proxy_model = nullptr;
 
     QTimer* m_renameTimer;
+    QTimer m_visible_uris_timer;
+    QStringList m_visible_uris;
     bool  m_editValid;
     bool  m_ctrl_key_pressed;
 
@@ -95,7 +95,9 @@ void BasicPropertiesPage::init()
         m_watcher->startMonitor();
 
         m_thumbnail_watcher = std::make_shared<FileWatcher>("thumbnail:///");
-        connect(m_thumbnail_watcher.get(), &FileWatcher::fileChanged, this, [=](const QString &uri){
+        connect(ThumbnailManager::getInstance(), &ThumbnailManager::thumbnailReady, this, [=](const QString &uri){
+            if (!m_info || uri != m_info->uri())
+                return;
             auto icon = ThumbnailManager::getInstance()->tryGetThumbnail(uri);
             m_iconButton->setIcon(icon);
             //QMessageBox::information(0, 0, "icon updated");
@@ -1,7 +1,9 @@
 INCLUDEPATH += $$PWD
 
 HEADERS += \
-    $$PWD/border-shadow-effect.h
+    $$PWD/border-shadow-effect.h \
+    $$PWD/thumbnail-shadow.h
 
 SOURCES += \
-    $$PWD/border-shadow-effect.cpp
+    $$PWD/border-shadow-effect.cpp \
+    $$PWD/thumbnail-shadow.cpp
@@ -0,0 +1,121 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "thumbnail-shadow.h"
+#include "thumbnail-manager.h"
+
+#include <QApplication>
+#include <QPainter>
+#include <QStyle>
+#include <qdrawutil.h>
+
+//qt's global function
+extern void qt_blurImage(QImage &blurImage, qreal radius, bool quality, int transposed);
+
+//the blur radius of a 128px thumbnail, smaller thumbnails get a smaller shadow.
+#define THUMBNAIL_SHADOW_RADIUS 4
+
+QHash<int, QPixmap> ThumbnailShadow::m_nine_patches;
+
+/*!
+ * \brief ThumbnailShadow::ninePatch
+ * \param radius
+ * \return an image of 7 extents per side, whose center 5 extents square is
+ * the shadow caster. The caster is cleared after blurring, so only the shadow
+ * out of the thumbnail is drawn, even if the thumbnail is translucent when
+ * it is painted. An extent is twice of the blur radius.
+ */
+const QPixmap &ThumbnailShadow::ninePatch(int radius)
+{
+    auto it = m_nine_patches.find(radius);
+    if (it != m_nine_patches.end())
+        return it.value();
+
+    int extent = radius * 2;
+    QRect caster(extent, extent, extent * 5, extent * 5);
+    QImage img(extent * 7, extent * 7, QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::transparent);
+
+    QPainter p(&img);
+    p.fillRect(caster, Qt::gray);
+    p.end();
+
+    qt_blurImage(img, radius, false, false);
+
+    p.begin(&img);
+    p.setCompositionMode(QPainter::CompositionMode_Clear);
+    p.fillRect(caster, Qt::transparent);
+    p.end();
+
+    return m_nine_patches.insert(radius, QPixmap::fromImage(img)).value();
+}
+
+void ThumbnailShadow::paint(QPainter *painter, const QRect &rect)
+{
+    if (rect.isEmpty())
+        return;
+
+    int radius = qBound(1, qMin(rect.width(), rect.height()) * THUMBNAIL_SHADOW_RADIUS / 128, THUMBNAIL_SHADOW_RADIUS);
+    int extent = radius * 2;
+    const QPixmap &patch = ninePatch(radius);
+
+    QRect target = rect.adjusted(-extent, -extent, extent, extent);
+    //a corner covers one extent out of the caster and two inside,
+    //the edges are stretched from the middle extent.
+    int sourceMargin = extent * 3;
+    int targetMargin = qMin(sourceMargin, qMin(target.width(), target.height()) / 2);
+
+    qDrawBorderPixmap(painter,
+                      target, QMargins(targetMargin, targetMargin, targetMargin, targetMargin),
+                      patch, patch.rect(), QMargins(sourceMargin, sourceMargin, sourceMargin, sourceMargin));
+}
+
+void ThumbnailShadow::paintItemShadow(QPainter *painter, const QStyleOptionViewItem &option, const QString &uri)
+{
+    if (option.icon.isNull() || !Peony::ThumbnailManager::getInstance()->thumbnailHasShadow(uri))
+        return;
+
+    auto style = option.widget? option.widget->style(): QApplication::style();
+    auto decorationRect = style->subElementRect(QStyle::SE_ItemViewItemDecoration, &option, option.widget);
+    auto pixmapSize = option.icon.actualSize(decorationRect.size());
+    auto pixmapRect = QStyle::alignedRect(option.direction, option.decorationAlignment, pixmapSize, decorationRect);
+
+    paint(painter, pixmapRect);
+}
+
+void ThumbnailShadow::paintItem(QPainter *painter, const QStyleOptionViewItem &option, const QString &uri, const QWidget *widget)
+{
+    auto style = widget? widget->style(): QApplication::style();
+    if (option.icon.isNull() || !Peony::ThumbnailManager::getInstance()->thumbnailHasShadow(uri)) {
+        style->drawControl(QStyle::CE_ItemViewItem, &option, painter, widget);
+        return;
+    }
+
+    //the panel would cover the shadow if it was painted by CE_ItemViewItem.
+    style->drawPrimitive(QStyle::PE_PanelItemViewItem, &option, painter, widget);
+    paintItemShadow(painter, option, uri);
+
+    auto opt = option;
+    opt.state &= ~(QStyle::State_Selected | QStyle::State_MouseOver);
+    opt.backgroundBrush = Qt::NoBrush;
+    style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, widget);
+}
@@ -0,0 +1,87 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef THUMBNAILSHADOW_H
+#define THUMBNAILSHADOW_H
+
+#include <QPixmap>
+#include <QHash>
+#include <QStyleOptionViewItem>
+#include <peony-core_global.h>
+
+class QPainter;
+
+/*!
+ * \brief The ThumbnailShadow class
+ * \details
+ * This class paints the drop shadow of thumbnails in icon views.
+ *
+ * Thumbnails are stored as their plain scaled images, the shadow is painted
+ * under them when the item is painted. A shadow is drawn from a blurred
+ * nine-patch, which is cached once for each blur radius, so no image is
+ * blurred for a thumbnail, and the shadow matches the size the thumbnail
+ * is painted at.
+ *
+ * \note
+ * It must be used in main thread.
+ * \see ThumbnailManager::thumbnailHasShadow().
+ */
+class PEONYCORESHARED_EXPORT ThumbnailShadow
+{
+public:
+    /*!
+     * \brief paint
+     * \param painter
+     * \param rect, the rect of thumbnail, the shadow is painted around it.
+     */
+    static void paint(QPainter *painter, const QRect &rect);
+
+    /*!
+     * \brief paintItemShadow
+     * \param painter
+     * \param option, the option the item will be drawn with.
+     * \param uri, the uri of item.
+     * Paint the shadow under the decoration of option if uri has a thumbnail
+     * needing one. Call it before the item is drawn.
+     * \see paintItem().
+     */
+    static void paintItemShadow(QPainter *painter, const QStyleOptionViewItem &option, const QString &uri);
+
+    /*!
+     * \brief paintItem
+     * \param painter
+     * \param option
+     * \param uri, the uri of item.
+     * \param widget, the widget passed to QStyle.
+     * Draw the item of option like QStyle::CE_ItemViewItem does, with the shadow
+     * of its thumbnail painted over the hover and selection panel but under the
+     * decoration. Use it instead of paintItemShadow() and drawControl().
+     */
+    static void paintItem(QPainter *painter, const QStyleOptionViewItem &option, const QString &uri, const QWidget *widget);
+
+private:
+    static const QPixmap &ninePatch(int radius);
+
+    static QHash<int, QPixmap> m_nine_patches;
+};
+
+#endif // THUMBNAILSHADOW_H
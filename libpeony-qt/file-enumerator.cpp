@@ -25,6 +25,7 @@
 #include "file-info-manager.h"
 
 #include "file-info-job.h"
+#include "local-file-enumerator.h"
 
 #include "mount-operation.h"
 
@@ -155,10 +156,9 @@ void FileEnumerator::setEnumerateDirectory(GFile *file)
     }
 }
 
-//try not to use this function for now, some info can not get correctly
 void FileEnumerator::setEnumerateWithInfoJob(bool query)
 {
-    m_with_info_job = query;   
+    m_with_info_job = query;
 }
 
 QString FileEnumerator::getEnumerateUri()
@@ -185,7 +185,14 @@ void FileEnumerator::cancel()
     g_object_unref(m_cancellable);
     m_cancellable = g_cancellable_new();
 
+    if (m_local_enumerator) {
+        m_local_enumerator->cancel();
+        m_local_enumerator->deleteLater();
+        m_local_enumerator = nullptr;
+    }
+
     m_children_uris->clear();
+    m_cached_infos.clear();
 
     Q_EMIT this->cancelled();
     //Q_EMIT enumerateFinished(false);
@@ -257,7 +264,7 @@ void FileEnumerator::enumerateSync()
     GFile *target = enumerateTargetFile();
 
     GFileEnumerator *enumerator = g_file_enumerate_children(target,
-                                  G_FILE_ATTRIBUTE_STANDARD_NAME,
+                                  m_with_info_job? PEONY_FILE_INFO_QUERY_ATTRIBUTES: G_FILE_ATTRIBUTE_STANDARD_NAME,
                                   G_FILE_QUERY_INFO_NONE,
                                   m_cancellable,
                                   nullptr);
@@ -372,18 +379,57 @@ void FileEnumerator::enumerateAsync()
     connect(infoJob, &FileInfoJob::queryAsyncFinished, this, [=](){
         //auto uri = g_file_get_uri(m_root_file);
         //auto path = g_file_get_path(m_root_file);
-        g_file_enumerate_children_async(m_root_file,
-                                        m_with_info_job? "*": G_FILE_ATTRIBUTE_STANDARD_NAME,
-                                        G_FILE_QUERY_INFO_NONE,
-                                        G_PRIORITY_DEFAULT,
-                                        m_cancellable,
-                                        GAsyncReadyCallback(find_children_async_ready_callback),
-                                        this);
-
+        if (m_with_info_job && m_accept_partial_info && LocalFileEnumerator::isSupported(m_root_file)) {
+            enumerateLocalChildrenAsync();
+        } else {
+            enumerateChildrenAsync();
+        }
     });
     infoJob->queryAsync();
 }
 
+void FileEnumerator::enumerateChildrenAsync()
+{
+    g_file_enumerate_children_async(m_root_file,
+                                    m_with_info_job? PEONY_FILE_INFO_QUERY_ATTRIBUTES: G_FILE_ATTRIBUTE_STANDARD_NAME,
+                                    G_FILE_QUERY_INFO_NONE,
+                                    G_PRIORITY_DEFAULT,
+                                    m_cancellable,
+                                    GAsyncReadyCallback(find_children_async_ready_callback),
+                                    this);
+}
+
+void FileEnumerator::enumerateLocalChildrenAsync()
+{
+    if (m_local_enumerator) {
+        m_local_enumerator->cancel();
+        m_local_enumerator->deleteLater();
+    }
+
+    m_local_enumerator = new LocalFileEnumerator(m_root_file, this);
+    auto localEnumerator = m_local_enumerator;
+    connect(localEnumerator, &LocalFileEnumerator::childrenFound, this, [=](const QList<std::shared_ptr<FileInfo>> &infos) {
+        //hold the infos until enumerating finished, see m_cached_infos.
+        m_cached_infos<<infos;
+        for (auto info : infos) {
+            *m_cache_uris<<info->uri();
+        }
+    });
+    connect(localEnumerator, &LocalFileEnumerator::finished, this, [=](bool successed) {
+        localEnumerator->deleteLater();
+        if (m_local_enumerator == localEnumerator)
+            m_local_enumerator = nullptr;
+
+        if (successed) {
+            Q_EMIT enumerateFinished(true);
+        } else {
+            qDebug()<<"native enumeration failed, fall back to gio:"<<m_uri;
+            enumerateChildrenAsync();
+        }
+    });
+    localEnumerator->start();
+}
+
 void FileEnumerator::enumerateChildren(GFileEnumerator *enumerator)
 {
     GFileInfo *info = nullptr;
@@ -412,6 +458,8 @@ void FileEnumerator::enumerateChildren(GFileEnumerator *enumerator)
             *m_children_uris<<uri;
         }
 
+        fillChildInfo(uri, info);
+
         g_free(uri);
         g_object_unref(info);
         info = g_file_enumerator_next_file(enumerator, m_cancellable, nullptr);
@@ -419,6 +467,24 @@ void FileEnumerator::enumerateChildren(GFileEnumerator *enumerator)
     Q_EMIT enumerateFinished(true);
 }
 
+void FileEnumerator::fillChildInfo(const QString &uri, GFileInfo *info)
+{
+    if (!m_with_info_job)
+        return;
+
+    auto fileInfo = FileInfo::fromUri(uri);
+    //hold the info until enumerating finished, see m_cached_infos.
+    m_cached_infos<<fileInfo;
+
+    //some vfs enumerator only return the name of children,
+    //leave their info empty and let the holder query it later.
+    if (!g_file_info_has_attribute(info, G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME))
+        return;
+
+    FileInfoJob infoJob(fileInfo);
+    infoJob.refreshInfoContents(info);
+}
+
 GAsyncReadyCallback FileEnumerator::mount_mountable_callback(GFile *file,
         GAsyncResult *res,
         FileEnumerator *p_this)
@@ -610,12 +676,7 @@ GAsyncReadyCallback FileEnumerator::enumerator_next_files_async_ready_callback(G
             *(p_this->m_cache_uris)<<uri;
         }
 
-        if (p_this->m_with_info_job) {
-            auto fileInfo = FileInfo::fromUri(uri);
-            FileInfoJob infoJob(fileInfo);
-            infoJob.refreshInfoContents(info);
-            p_this->m_cached_infos<<fileInfo;
-        }
+        p_this->fillChildInfo(uri, info);
 
         g_free(uri);
         files_count++;
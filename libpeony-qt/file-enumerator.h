@@ -35,6 +35,7 @@ namespace Peony {
 
 class FileInfo;
 class GErrorWrapper;
+class LocalFileEnumerator;
 
 /*!
  * \brief The FileEnumerator class
@@ -55,7 +56,42 @@ public:
     void setEnumerateDirectory(QString uri);
     void setEnumerateDirectory(GFile *file);
 
+    /*!
+     * \brief setEnumerateWithInfoJob
+     * \param query
+     * <br>
+     * If true, the enumerator requests the same attributes as FileInfoJob
+     * in every g_file_enumerator_next_files_async() batch, and fills the
+     * children's FileInfo directly from the batch. The children infos are
+     * ready when childrenUpdated() or enumerateFinished() is sent, so there
+     * is no need to start a FileInfoJob for each child.
+     * </br>
+     * \note
+     * Some vfs enumerators (such as search://) only return the file name.
+     * The infos of those children keep empty, check FileInfo::isEmptyInfo()
+     * and query them with FileInfoJob as before.
+     */
     void setEnumerateWithInfoJob(bool query = true);
+    bool isEnumerateWithInfoJob() {
+        return m_with_info_job;
+    }
+
+    /*!
+     * \brief setAcceptPartialInfo
+     * \param accept
+     * <br>
+     * If true, and the directory is a local one enumerated with info job,
+     * enumerateAsync() uses the native LocalFileEnumerator instead of gio.
+     * It is much faster for large directories, but the children infos are
+     * only partially filled, the holder must complete the infos which are
+     * not FileInfo::isLoaded() with FileInfoJob when it needs the rest,
+     * such as metadata and the icons of special directories.
+     * </br>
+     * \see LocalFileEnumerator.
+     */
+    void setAcceptPartialInfo(bool accept = true) {
+        m_accept_partial_info = accept;
+    }
 
     QString getEnumerateUri();
 
@@ -164,6 +200,14 @@ protected:
      * \param enumerator, handle of enum next file.
      */
     void enumerateChildren(GFileEnumerator *enumerator);
+    /*!
+     * \brief fillChildInfo, fill the shared info of a child with enumerated data.
+     * \param uri, child uri.
+     * \param info, the GFileInfo returned by enumerator.
+     * \note only works when enumerate with info job.
+     * \see setEnumerateWithInfoJob().
+     */
+    void fillChildInfo(const QString &uri, GFileInfo *info);
     /*!
      * \brief enumerateTargetFile
      * \return target uri which original uri point to.
@@ -235,6 +279,18 @@ protected:
             GAsyncResult *res,
             FileEnumerator *p_this);
 
+    /*!
+     * \brief enumerateChildrenAsync, start the gio enumeration of m_root_file.
+     * \see enumerateAsync().
+     */
+    void enumerateChildrenAsync();
+    /*!
+     * \brief enumerateLocalChildrenAsync, start the native enumeration of m_root_file.
+     * it falls back to enumerateChildrenAsync() if the directory could not be read natively.
+     * \see setAcceptPartialInfo().
+     */
+    void enumerateLocalChildrenAsync();
+
 private:
     QString m_uri;
 
@@ -249,6 +305,9 @@ private:
     bool m_auto_delete = false;
 
     bool m_with_info_job = false;
+    bool m_accept_partial_info = false;
+
+    LocalFileEnumerator *m_local_enumerator = nullptr;
 
     /*!
      * \brief m_cached_infos
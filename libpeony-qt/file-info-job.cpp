@@ -27,13 +27,11 @@
 
 #include "file-info-manager.h"
 #include "file-label-model.h"
+#include "mime-type-cache.h"
 
 #include <gio/gdesktopappinfo.h>
-#include <global-settings.h>
 
 #include <QDebug>
-#include <QDateTime>
-#include <QIcon>
 #include <QUrl>
 #include <QLocale>
 
@@ -89,7 +87,7 @@ bool FileInfoJob::querySync()
     GError *err = nullptr;
 
     auto _info = g_file_query_info(info->m_file,
-                                   "standard::*," "time::*," "access::*," "mountable::*," "metadata::*," G_FILE_ATTRIBUTE_ID_FILE,
+                                   PEONY_FILE_INFO_QUERY_ATTRIBUTES,
                                    G_FILE_QUERY_INFO_NONE,
                                    nullptr,
                                    &err);
@@ -174,7 +172,7 @@ void FileInfoJob::queryAsync()
         return;
     }
     g_file_query_info_async(info->m_file,
-                            "standard::*," "time::*," "access::*," "mountable::*," "metadata::*," G_FILE_ATTRIBUTE_ID_FILE,
+                            PEONY_FILE_INFO_QUERY_ATTRIBUTES,
                             G_FILE_QUERY_INFO_NONE,
                             G_PRIORITY_DEFAULT,
                             m_cancellable,
@@ -196,6 +194,16 @@ void FileInfoJob::refreshInfoContents(GFileInfo *new_info)
     } else {
         return;
     }
+
+    info->m_is_loaded = true;
+
+    QString oldDisplayName = info->m_display_name;
+    bool oldIsDir = info->isDir();
+    auto updateNameSerial = [=]() {
+        if (info->m_display_name != oldDisplayName || info->isDir() != oldIsDir)
+            info->m_name_serial++;
+    };
+
     GFileType type = g_file_info_get_file_type (new_info);
     switch (type) {
     case G_FILE_TYPE_DIRECTORY:
@@ -236,19 +244,10 @@ void FileInfoJob::refreshInfoContents(GFileInfo *new_info)
     info->m_display_name = QString (g_file_info_get_display_name(new_info));
     GIcon *g_icon = g_file_info_get_icon (new_info);
     if (G_IS_ICON(g_icon)) {
-        const gchar* const* icon_names = g_themed_icon_get_names(G_THEMED_ICON (g_icon));
-        if (icon_names) {
-            auto p = icon_names;
-            while (*p) {
-                QIcon icon = QIcon::fromTheme(*p);
-                if (!icon.isNull()) {
-                    info->m_icon_name = QString (*p);
-                    break;
-                } else {
-                    p++;
-                }
-            }
-        }
+        //resolving an icon name in theme is expensive and can only be done in ui thread,
+        //it is resolved when the icon name is used, see FileInfo::iconName().
+        info->m_themed_icon_names = MimeTypeCache::iconNames(g_icon);
+        info->m_themed_icon_names_pending = true;
         //g_object_unref(g_icon);
     }
 
@@ -281,22 +280,10 @@ void FileInfoJob::refreshInfoContents(GFileInfo *new_info)
 
     info->m_mime_type_string = info->m_content_type;
     if (!info->m_mime_type_string.isEmpty()) {
-        char *content_type = g_content_type_get_description (info->m_mime_type_string.toUtf8().constData());
-        info->m_file_type = content_type;
-        g_free (content_type);
-        content_type = nullptr;
+        info->m_file_type = MimeTypeCache::getInstance()->attributes(info->m_mime_type_string).description;
     }
 
-    char *size_full = strtok(g_format_size_full(info->m_size, G_FORMAT_SIZE_IEC_UNITS),"iB");
-    info->m_file_size = size_full;
-    g_free(size_full);
-
-    auto systemTimeFormat = GlobalSettings::getInstance()->getSystemTimeFormat();
-    QDateTime date = QDateTime::fromMSecsSinceEpoch(info->m_modified_time*1000);
-    info->m_modified_date = date.toString(systemTimeFormat);
-
-    date = QDateTime::fromMSecsSinceEpoch(info->m_access_time*1000);
-    info->m_access_date = date.toString(systemTimeFormat);
+    //the display strings of size and times are formatted lazily by FileInfo.
 
     m_info->m_meta_info = FileMetaInfo::fromGFileInfo(m_info->uri(), new_info);
     // update peony qt color list after meta info updated.
@@ -305,6 +292,7 @@ void FileInfoJob::refreshInfoContents(GFileInfo *new_info)
     auto customIconName = m_info->m_meta_info.get()->getMetaInfoString("custom-icon");
     if (!customIconName.isEmpty() && !customIconName.startsWith("/")) {
         m_info->m_icon_name = customIconName;
+        m_info->m_themed_icon_names_pending = false;
     }
 
     if (info->isDesktopFile()) {
@@ -312,7 +300,7 @@ void FileInfoJob::refreshInfoContents(GFileInfo *new_info)
         QUrl url = info->uri();
         GDesktopAppInfo *desktop_info = g_desktop_app_info_new_from_filename(url.path().toUtf8());
         if (!desktop_info) {
-            m_info->m_mutex.unlock();
+            updateNameSerial();
             info->updated();
             return;
         }
@@ -349,6 +337,7 @@ void FileInfoJob::refreshInfoContents(GFileInfo *new_info)
     info->m_target_uri = g_file_info_get_attribute_string(new_info, G_FILE_ATTRIBUTE_STANDARD_TARGET_URI);
     info->m_symlink_target = g_file_info_get_symlink_target(new_info);
 
+    updateNameSerial();
     Q_EMIT info->updated();
 //    m_info->m_mutex.unlock();
 }
@@ -30,6 +30,14 @@
 #include <memory>
 #include <gio/gio.h>
 
+/*!
+ * \brief PEONY_FILE_INFO_QUERY_ATTRIBUTES
+ * The attributes FileInfoJob::refreshInfoContents() relies on.
+ * FileEnumerator requests the same set while enumerating with info job,
+ * so that a FileInfo can be filled directly from the enumerated batches.
+ */
+#define PEONY_FILE_INFO_QUERY_ATTRIBUTES "standard::*," "time::*," "access::*," "mountable::*," "metadata::*," G_FILE_ATTRIBUTE_ID_FILE
+
 namespace Peony {
 
 class FileInfo;
@@ -22,24 +22,47 @@
 
 #include "file-info-manager.h"
 #include "thumbnail-manager.h"
-#include <QMap>
+#include <QHash>
+#include <QReadWriteLock>
+#include <QAtomicInteger>
 #include <QDebug>
 
+#ifndef PEONY_FILE_INFO_MANAGER_SHARD_COUNT
+#define PEONY_FILE_INFO_MANAGER_SHARD_COUNT 32
+#endif
+
 using namespace Peony;
 
+namespace {
+
+struct FileInfoShard {
+    QReadWriteLock lock;
+    QHash<QString, std::weak_ptr<FileInfo>> infos;
+};
+
+}
+
 static FileInfoManager* global_file_info_manager = nullptr;
-static QMap<QString, std::weak_ptr<FileInfo>> *global_info_list = nullptr;
+static FileInfoShard *global_info_shards = nullptr;
 
-static QMutex m_op_lock;
+static QAtomicInteger<quint64> global_lookup_count;
+static QAtomicInteger<quint64> global_hit_count;
+static QAtomicInteger<quint64> global_insert_count;
+static QAtomicInteger<quint64> global_swept_count;
+
+static FileInfoShard &shardOf(const QString &uri)
+{
+    return global_info_shards[qHash(uri) % PEONY_FILE_INFO_MANAGER_SHARD_COUNT];
+}
 
 FileInfoManager::FileInfoManager()
 {
-    global_info_list = new QMap<QString, std::weak_ptr<FileInfo>>();
+    global_info_shards = new FileInfoShard[PEONY_FILE_INFO_MANAGER_SHARD_COUNT];
 }
 
 FileInfoManager::~FileInfoManager()
 {
-    delete global_info_list;
+    delete[] global_info_shards;
 }
 
 FileInfoManager *FileInfoManager::getInstance()
@@ -51,32 +74,74 @@ FileInfoManager *FileInfoManager::getInstance()
 
 std::shared_ptr<FileInfo> FileInfoManager::findFileInfoByUri(const QString &uri)
 {
-    Q_ASSERT(global_info_list);
-    m_op_lock.lock();
-    auto info = global_info_list->value(uri).lock();//.lock();
-    m_op_lock.unlock();
+    Q_ASSERT(global_info_shards);
+    auto &shard = shardOf(uri);
+
+    global_lookup_count.fetchAndAddRelaxed(1);
+    shard.lock.lockForRead();
+    auto info = shard.infos.value(uri).lock();
+    shard.lock.unlock();
+
+    if (info)
+        global_hit_count.fetchAndAddRelaxed(1);
     return info;
 }
 
 std::shared_ptr<FileInfo> FileInfoManager::insertFileInfo(std::shared_ptr<FileInfo> info)
 {
-    Q_ASSERT(global_info_list);
+    Q_ASSERT(global_info_shards);
+    auto &shard = shardOf(info->uri());
 
-    m_op_lock.lock();
+    shard.lock.lockForWrite();
+    auto existedInfo = shard.infos.value(info->uri()).lock();
+    if (!existedInfo) {
+        shard.infos.insert(info->uri(), info);
+        global_insert_count.fetchAndAddRelaxed(1);
+    }
+    shard.lock.unlock();
 
-    if (global_info_list->value(info->uri()).lock()) {
+    //NOTE: the newly info might be destroyed once we return the existed one,
+    //so do not release it while holding the shard lock. It is marked as
+    //duplicated, its destructor skips the clean up of uri.
+    if (existedInfo) {
         //qDebug()<<"has info yet"<<info->uri();
-        info = global_info_list->value(info->uri()).lock();
-    } else {
-        global_info_list->insert(info->uri(), info);
+        info->m_is_duplicated = true;
+        return existedInfo;
     }
+    return info;
+}
 
-    m_op_lock.unlock();
+void FileInfoManager::removeFileInfo(const QString &uri)
+{
+    if (!global_info_shards || uri.isEmpty())
+        return;
+    auto &shard = shardOf(uri);
 
-    return info;
+    shard.lock.lockForWrite();
+    auto it = shard.infos.find(uri);
+    if (it != shard.infos.end() && it.value().expired()) {
+        shard.infos.erase(it);
+        global_swept_count.fetchAndAddRelaxed(1);
+    }
+    shard.lock.unlock();
 }
 
 void FileInfoManager::showState()
 {
-    qDebug()<<global_info_list->keys().count()<<global_info_list->values().count();
+    int entries = 0;
+    int living = 0;
+    for (int i = 0; i < PEONY_FILE_INFO_MANAGER_SHARD_COUNT; i++) {
+        auto &shard = global_info_shards[i];
+        shard.lock.lockForRead();
+        entries += shard.infos.count();
+        for (auto info : shard.infos) {
+            if (!info.expired())
+                living++;
+        }
+        shard.lock.unlock();
+    }
+
+    qDebug()<<"file info manager: entries"<<entries<<"living"<<living
+            <<"lookups"<<global_lookup_count.load()<<"hits"<<global_hit_count.load()
+            <<"inserts"<<global_insert_count.load()<<"swept"<<global_swept_count.load();
 }
@@ -39,37 +39,67 @@ namespace Peony {
  * use FileInfo::fromUri(), FileInfo::fromPath() or FileInfo::fromGFile()
  * for getting the corresponding shared data.
  * </br>
- * \note The memory management is based on std smart pointer, but it is not regular.
- * Because hash table always hold a use count of shared data. If you want to use
- * shared data of this class instance, you should remenmber this point:
- * When releasing your info resources, you aslo need to add an additional judgment that whether
- * there is no other member but you and manager instance hold this shared data.
- * If true, you should aslo remove the element in manager's hash for really releasing resources.
- * Otherwise, it might cause an one-time memory leak.
- * \see FileInfo, FileInfoJob, FileEnumerator; FileInfo::~FileInfo(), FileInfoJob::~FileInfoJob(),
- * FileEnumerator::~FileEnumerator().
- * \bug
- * Even though I try my best to make share the file info data, it seems that the info is not be shared
- * sometimes. Maybe there were some wrong in other classes?
+ * <br>
+ * The table is split into several shards by the hash of uri, every shard has
+ * its own read-write lock. Lookups of different uris rarely contend, and
+ * concurrent lookups in same shard only take the read lock.
+ * </br>
+ * \note The manager only holds weak references of infos. When a FileInfo
+ * is destroyed, its expired entry is swept from the table by removeFileInfo(),
+ * so the table size is bounded by the living infos.
+ * \see FileInfo, FileInfoJob, FileEnumerator; FileInfo::~FileInfo().
  */
 class PEONYCORESHARED_EXPORT FileInfoManager
 {
     friend class FileInfo;
 public:
     static FileInfoManager *getInstance();
-    std::shared_ptr<FileInfo> findFileInfoByUri(const QString &uri); //{return global_info_list->value(uri);}
+    std::shared_ptr<FileInfo> findFileInfoByUri(const QString &uri);
 
+    /*!
+     * \brief lock
+     * \deprecated
+     * the table is protected by its shards' locks, there is no need to
+     * hold a global lock around findFileInfoByUri() any more.
+     */
     void lock() {
         m_mutex.lock();
     }
+    /*!
+     * \brief unlock
+     * \deprecated
+     * \see lock().
+     */
     void unlock() {
         m_mutex.unlock();
     }
 
+    /*!
+     * \brief showState
+     * <br>
+     * Print the count of entries and the lookup/insert/sweep counters
+     * of the table.
+     * </br>
+     */
     void showState();
 
 protected:
-    std::shared_ptr<FileInfo> insertFileInfo(std::shared_ptr<FileInfo> info); //{global_info_list->insert(info->uri(), info);}
+    /*!
+     * \brief insertFileInfo
+     * \param info
+     * \return the living info in table if there is one, otherwise the param itself.
+     */
+    std::shared_ptr<FileInfo> insertFileInfo(std::shared_ptr<FileInfo> info);
+    /*!
+     * \brief removeFileInfo
+     * \param uri
+     * <br>
+     * Remove the entry of uri if it was expired. This is called in FileInfo's destructor.
+     * A newer info of the same uri might have been inserted before the old one destroyed,
+     * that entry will be kept.
+     * </br>
+     */
+    void removeFileInfo(const QString &uri);
 
 private:
     FileInfoManager();
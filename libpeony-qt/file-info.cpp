@@ -27,10 +27,15 @@
 #include "file-meta-info.h"
 #include "file-utils.h"
 #include "thumbnail-manager.h"
+#include "mime-type-cache.h"
+#include "global-settings.h"
 
 #include <QUrl>
 #include <QDir>
 #include <QDebug>
+#include <QDateTime>
+#include <QThread>
+#include <QCoreApplication>
 
 using namespace Peony;
 
@@ -71,10 +76,17 @@ FileInfo::FileInfo(const QString &uri, QObject *parent) : QObject (parent)
 
 FileInfo::~FileInfo()
 {
-    ThumbnailManager::getInstance()->releaseThumbnail(m_uri);
     //qDebug()<<"~FileInfo"<<m_uri;
     disconnect();
 
+    //the thumbnail and manager entry of uri belong to the info in manager.
+    if (!m_is_duplicated) {
+        ThumbnailManager::getInstance()->releaseThumbnail(m_uri);
+
+        //sweep the expired entry, so that the manager won't keep dead uris.
+        FileInfoManager::getInstance()->removeFileInfo(m_uri);
+    }
+
     g_object_unref(m_cancellable);
     g_object_unref(m_file);
 
@@ -87,10 +99,8 @@ FileInfo::~FileInfo()
 std::shared_ptr<FileInfo> FileInfo::fromUri(QString uri)
 {
     FileInfoManager *info_manager = FileInfoManager::getInstance();
-    info_manager->lock();
     std::shared_ptr<FileInfo> info = info_manager->findFileInfoByUri(uri);
     if (info != nullptr) {
-        info_manager->unlock();
         return info;
     } else {
         std::shared_ptr<FileInfo> newly_info = std::make_shared<FileInfo>();
@@ -116,8 +126,9 @@ std::shared_ptr<FileInfo> FileInfo::fromUri(QString uri)
             }
         }
 
+        //another thread might insert the same uri meanwhile,
+        //insertFileInfo() will return the one in manager.
         newly_info = info_manager->insertFileInfo(newly_info);
-        info_manager->unlock();
         return newly_info;
     }
 }
@@ -149,44 +160,84 @@ h264:   application/octet-stream
 **/
 bool FileInfo::isVideoFile()
 {
-    if (nullptr != m_mime_type_string)
-    {
-        if (m_mime_type_string.startsWith("video")
-            || m_mime_type_string.endsWith("vnd.trolltech.linguist")
-            || m_mime_type_string.endsWith("vnd.adobe.flash.movie")
-            || m_mime_type_string.endsWith("vnd.rn-realmedia")
-            || m_mime_type_string.endsWith("vnd.ms-asf")
-            || m_mime_type_string.endsWith("octet-stream"))
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
-    }
-    else
-    {
+    if (m_mime_type_string.isEmpty())
         return false;
-    }
+
+    return MimeTypeCache::getInstance()->attributes(m_mime_type_string).isVideo;
 }
 
 
 bool FileInfo::isOfficeFile()
 {
-    int idx = 0;
-    QString mtype = nullptr;
-
-    for (idx = 0; office_mime_types[idx] != "end"; idx++)
-    {
-        mtype = office_mime_types[idx];
-        if (m_mime_type_string.contains(mtype))
-        {
-            return true;
-        }
+    if (m_mime_type_string.isEmpty())
+        return false;
+
+    return MimeTypeCache::getInstance()->attributes(m_mime_type_string).isOffice;
+}
+
+QString FileInfo::iconName()
+{
+    if (m_themed_icon_names_pending && QThread::currentThread() == qApp->thread()) {
+        m_themed_icon_names_pending = false;
+        auto iconName = MimeTypeCache::getInstance()->themeIconName(m_themed_icon_names);
+        if (!iconName.isEmpty())
+            m_icon_name = iconName;
     }
+    return m_icon_name;
+}
 
-    return false;
+QString FileInfo::fileSize()
+{
+    if (isEmptyInfo())
+        return m_file_size;
+
+    if (m_file_size.isNull() || m_formatted_size != m_size) {
+        char *size_full = strtok(g_format_size_full(m_size, G_FORMAT_SIZE_IEC_UNITS),"iB");
+        m_file_size = size_full;
+        g_free(size_full);
+        m_formatted_size = m_size;
+    }
+    return m_file_size;
+}
+
+QString FileInfo::modifiedDate()
+{
+    if (isEmptyInfo())
+        return m_modified_date;
+
+    auto systemTimeFormat = GlobalSettings::getInstance()->getSystemTimeFormat();
+    if (systemTimeFormat != m_formatted_time_format) {
+        m_formatted_time_format = systemTimeFormat;
+        m_modified_date = nullptr;
+        m_access_date = nullptr;
+    }
+
+    if (m_modified_date.isNull() || m_formatted_modified_time != m_modified_time) {
+        QDateTime date = QDateTime::fromMSecsSinceEpoch(m_modified_time*1000);
+        m_modified_date = date.toString(systemTimeFormat);
+        m_formatted_modified_time = m_modified_time;
+    }
+    return m_modified_date;
+}
+
+QString FileInfo::accessDate()
+{
+    if (isEmptyInfo())
+        return m_access_date;
+
+    auto systemTimeFormat = GlobalSettings::getInstance()->getSystemTimeFormat();
+    if (systemTimeFormat != m_formatted_time_format) {
+        m_formatted_time_format = systemTimeFormat;
+        m_modified_date = nullptr;
+        m_access_date = nullptr;
+    }
+
+    if (m_access_date.isNull() || m_formatted_access_time != m_access_time) {
+        QDateTime date = QDateTime::fromMSecsSinceEpoch(m_access_time*1000);
+        m_access_date = date.toString(systemTimeFormat);
+        m_formatted_access_time = m_access_time;
+    }
+    return m_access_date;
 }
 
 const QString FileInfo::targetUri()
@@ -29,6 +29,7 @@
 #include <memory>
 #include <gio/gio.h>
 #include <QString>
+#include <QStringList>
 #include <QObject>
 
 #include <QMutex>
@@ -102,7 +103,9 @@ static char *office_mime_types[] = {
 class PEONYCORESHARED_EXPORT FileInfo : public QObject
 {
     friend class FileInfoJob;
+    friend class LocalFileEnumerator;
     friend class FileMetaInfo;
+    friend class FileInfoManager;
 
     Q_OBJECT
 public:
@@ -168,9 +171,16 @@ public:
         return m_desktop_name;
     }
 
-    QString iconName() {
-        return m_icon_name;
-    }
+    /*!
+     * \brief iconName
+     * \return the icon name of file in current icon theme.
+     * \note
+     * The themed icon names of a file are resolved lazily when this is called
+     * in ui thread, as QIcon can not be used in other threads. In other threads
+     * the icon name resolved previously is returned.
+     * \see MimeTypeCache::themeIconName().
+     */
+    QString iconName();
     QString symbolicIconName() {
         return m_symbolic_icon_name;
     }
@@ -188,15 +198,19 @@ public:
         return m_path;
     }
 
-    QString fileSize() {
-        return m_file_size;
-    }
-    QString modifiedDate() {
-        return m_modified_date;
-    }
-    QString accessDate() {
-        return m_access_date;
-    }
+    /*!
+     * \brief fileSize
+     * \return the formatted size, it is formatted when it is asked at the first
+     * time after the size changed.
+     */
+    QString fileSize();
+    /*!
+     * \brief modifiedDate
+     * \return the modified time formatted in system time format, it is formatted
+     * lazily as fileSize().
+     */
+    QString modifiedDate();
+    QString accessDate();
 
     QString type() {
         return m_content_type;
@@ -278,6 +292,29 @@ public:
         return m_display_name == nullptr || m_display_name == "";
     }
 
+    /*!
+     * \brief nameSerial
+     * \return a serial number which increases every time the display name
+     * or the directory type of this info changed.
+     * \note holders can cache the data computed from display name, such as
+     * sort keys, and use this serial to judge whether the cache is out of date.
+     */
+    quint32 nameSerial() {
+        return m_name_serial;
+    }
+
+    /*!
+     * \brief isLoaded
+     * \return true if the info was queried by FileInfoJob.
+     * \note an info filled by a fast path, such as LocalFileEnumerator, has
+     * display name, type, size and times, but not metadata and some other
+     * attributes. It is not empty but not loaded, query it with FileInfoJob
+     * when the rest is needed.
+     */
+    bool isLoaded() {
+        return m_is_loaded;
+    }
+
     AccessFlags accesses() {
         auto flags = AccessFlags();
 #if (QT_VERSION >= QT_VERSION_CHECK(5, 7, 0))
@@ -333,9 +370,24 @@ private:
 
     bool m_is_loaded = false;
 
+    /*!
+     * \brief m_is_duplicated
+     * true if the info lost the race of inserting into FileInfoManager,
+     * it must not clean up the states of uri shared with the living one.
+     */
+    bool m_is_duplicated = false;
+
     QString m_display_name = nullptr;
+    quint32 m_name_serial = 0;
     QString m_desktop_name = nullptr;
     QString m_icon_name = nullptr;
+    /*!
+     * \brief m_themed_icon_names
+     * the names of file's themed icon, which are resolved into m_icon_name
+     * by iconName() if m_themed_icon_names_pending is true.
+     */
+    QStringList m_themed_icon_names;
+    bool m_themed_icon_names_pending = false;
     QString m_symbolic_icon_name = nullptr;
     QString m_file_id = nullptr;
     QString m_path = nullptr;
@@ -351,9 +403,19 @@ private:
      */
     QString m_mime_type_string = nullptr;
     QString m_file_type = nullptr;
+
+    /*!
+     * \brief m_file_size
+     * the formatted display strings and the values they were formatted from,
+     * see fileSize(), modifiedDate() and accessDate().
+     */
     QString m_file_size = nullptr;
+    guint64 m_formatted_size = 0;
     QString m_modified_date = nullptr;
+    guint64 m_formatted_modified_time = 0;
     QString m_access_date = nullptr;
+    guint64 m_formatted_access_time = 0;
+    QString m_formatted_time_format;
 
     //access
     bool m_can_read = true;
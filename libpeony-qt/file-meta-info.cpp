@@ -37,7 +37,7 @@ std::shared_ptr<FileMetaInfo> FileMetaInfo::fromUri(const QString &uri)
     auto mgr = FileInfoManager::getInstance();
     auto info = mgr->findFileInfoByUri(uri);
     if (info)
-        return mgr->findFileInfoByUri(uri)->m_meta_info;
+        return info->m_meta_info;
     return nullptr;
 }
 
@@ -0,0 +1,189 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "file-copy-engine.h"
+#include "file-node.h"
+#include "local-file-copy.h"
+
+#include <QThreadPool>
+#include <QThread>
+#include <QRunnable>
+
+#include <algorithm>
+
+//workers of a copy, small copies on ssd and network file systems are bound by latency,
+//so there are more workers than cores.
+#ifndef PEONY_COPY_ENGINE_WORKERS
+#define PEONY_COPY_ENGINE_WORKERS 8
+#endif
+
+//files larger than this are copied serially by the operation.
+#ifndef PEONY_COPY_ENGINE_MAX_FILE_SIZE
+#define PEONY_COPY_ENGINE_MAX_FILE_SIZE 4*1024*1024
+#endif
+
+//nodes queued ahead of workers for each worker.
+#ifndef PEONY_COPY_ENGINE_QUEUE_DEPTH
+#define PEONY_COPY_ENGINE_QUEUE_DEPTH 4
+#endif
+
+namespace Peony {
+
+class FileCopyTask : public QRunnable
+{
+public:
+    FileCopyTask(FileCopyEngine *engine, FileNode *node, quint64 serial) {
+        m_engine = engine;
+        m_node = node;
+        m_serial = serial;
+        setAutoDelete(true);
+    }
+
+    void run() override {
+        m_engine->copyInWorker(m_node, m_serial);
+        m_engine->m_slots.release();
+    }
+
+private:
+    FileCopyEngine *m_engine = nullptr;
+    FileNode *m_node = nullptr;
+    quint64 m_serial = 0;
+};
+
+}
+
+using namespace Peony;
+
+struct FileCopyProgressData {
+    FileCopyEngine::ProgressCallback *callback;
+    FileNode *node;
+};
+
+FileCopyEngine::FileCopyEngine(GCancellable *cancellable, GFileCopyFlags flags)
+{
+    m_cancellable = cancellable;
+    if (m_cancellable)
+        g_object_ref(m_cancellable);
+    m_flags = flags;
+
+    int workers = qBound(2, QThread::idealThreadCount() * 2, PEONY_COPY_ENGINE_WORKERS);
+    m_pool = new QThreadPool;
+    m_pool->setMaxThreadCount(workers);
+
+    m_slot_count = workers * PEONY_COPY_ENGINE_QUEUE_DEPTH;
+    m_slots.release(m_slot_count);
+}
+
+FileCopyEngine::~FileCopyEngine()
+{
+    waitForDone();
+    delete m_pool;
+    if (m_cancellable)
+        g_object_unref(m_cancellable);
+}
+
+bool FileCopyEngine::shouldCopyInParallel(FileNode *node)
+{
+    return !node->isFolder() && node->size() <= PEONY_COPY_ENGINE_MAX_FILE_SIZE;
+}
+
+void FileCopyEngine::copy(FileNode *node)
+{
+    m_slots.acquire();
+    m_pool->start(new FileCopyTask(this, node, ++m_serial));
+}
+
+void FileCopyEngine::waitForDone()
+{
+    m_pool->waitForDone();
+}
+
+QList<FileNode *> FileCopyEngine::takeFailedNodes()
+{
+    QMutexLocker locker(&m_failed_nodes_mutex);
+    std::sort(m_failed_nodes.begin(), m_failed_nodes.end());
+
+    QList<FileNode *> nodes;
+    for (auto failedNode : m_failed_nodes) {
+        nodes<<failedNode.second;
+    }
+    m_failed_nodes.clear();
+    return nodes;
+}
+
+void FileCopyEngine::copyInWorker(FileNode *node, quint64 serial)
+{
+    if (m_cancellable && g_cancellable_is_cancelled(m_cancellable)) {
+        //nothing was written, the dest must not be rollbacked.
+        node->setState(FileNode::Unhandled);
+        if (m_released_callback)
+            m_released_callback(node);
+        return;
+    }
+
+    node->setState(FileNode::Handling);
+
+    GFile *sourceFile = g_file_new_for_uri(node->uri().toUtf8().constData());
+    GFile *destFile = g_file_new_for_uri(node->destUri().toUtf8().constData());
+
+    FileCopyProgressData data;
+    data.callback = &m_progress_callback;
+    data.node = node;
+
+    GError *err = nullptr;
+    LocalFileCopy::copy(sourceFile,
+                        destFile,
+                        m_flags,
+                        m_cancellable,
+                        m_progress_callback? progress_callback: nullptr,
+                        &data,
+                        &err);
+
+    g_object_unref(sourceFile);
+    g_object_unref(destFile);
+
+    if (!err) {
+        node->setState(FileNode::Handled);
+        if (m_finished_callback)
+            m_finished_callback(node);
+        if (m_released_callback)
+            m_released_callback(node);
+        return;
+    }
+
+    //the operation handles the other errors serially.
+    if (err->code != G_IO_ERROR_CANCELLED) {
+        if (err->code == G_IO_ERROR_EXISTS)
+            node->setState(FileNode::Unhandled);
+        QMutexLocker locker(&m_failed_nodes_mutex);
+        m_failed_nodes<<qMakePair(serial, node);
+    } else if (m_released_callback) {
+        m_released_callback(node);
+    }
+    g_error_free(err);
+}
+
+void FileCopyEngine::progress_callback(goffset current_num_bytes, goffset total_num_bytes, gpointer data)
+{
+    auto progressData = static_cast<FileCopyProgressData *>(data);
+    (*progressData->callback)(progressData->node, current_num_bytes, total_num_bytes);
+}
@@ -0,0 +1,142 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef FILECOPYENGINE_H
+#define FILECOPYENGINE_H
+
+#include "peony-core_global.h"
+
+#include <QMutex>
+#include <QSemaphore>
+#include <QList>
+#include <QPair>
+#include <gio/gio.h>
+
+#include <functional>
+
+class QThreadPool;
+
+namespace Peony {
+
+class FileNode;
+
+/*!
+ * \brief The FileCopyEngine class
+ * <br>
+ * FileCopyEngine copies the files of a prepared FileNode tree on a bounded
+ * worker pool, so that copying many small files is not bound by the latency
+ * of every single copy. The operation still walks the tree in its own thread,
+ * creates the directories before their children are queued, and copies
+ * large files itself.
+ * </br>
+ * <br>
+ * A worker only does the plain copy. It sets the node state to Handling
+ * before copying and Handled once it is done. A node which went into error
+ * is not handled by the worker, it is kept by the engine and the operation
+ * copies it again serially with its own conflict and error handling, see
+ * takeFailedNodes(). A canceled copy leaves the node Handling, so the
+ * partial file is rollbacked. A node whose destination existed is set back
+ * to Unhandled, because the existing file does not belong to the operation.
+ * </br>
+ * \note
+ * The nodes queued must live until waitForDone() returned.
+ */
+class PEONYCORESHARED_EXPORT FileCopyEngine
+{
+public:
+    /*!
+     * \brief ProgressCallback
+     * called in worker threads with the bytes copied of node.
+     */
+    typedef std::function<void(FileNode *node, goffset current, goffset total)> ProgressCallback;
+    /*!
+     * \brief FinishedCallback
+     * called in worker threads once node was copied.
+     */
+    typedef std::function<void(FileNode *node)> FinishedCallback;
+    /*!
+     * \brief ReleasedCallback
+     * called in worker threads once the engine does not use node any more,
+     * unless node went into error and is kept for takeFailedNodes().
+     */
+    typedef std::function<void(FileNode *node)> ReleasedCallback;
+
+    explicit FileCopyEngine(GCancellable *cancellable, GFileCopyFlags flags);
+    ~FileCopyEngine();
+
+    void setProgressCallback(ProgressCallback callback) {
+        m_progress_callback = callback;
+    }
+    void setFinishedCallback(FinishedCallback callback) {
+        m_finished_callback = callback;
+    }
+    void setReleasedCallback(ReleasedCallback callback) {
+        m_released_callback = callback;
+    }
+
+    /*!
+     * \brief shouldCopyInParallel
+     * \return true if node is a small file, large files are copied serially
+     * for they are bound by bandwidth and would compete with each other.
+     */
+    static bool shouldCopyInParallel(FileNode *node);
+
+    /*!
+     * \brief copy
+     * \param node, a file whose dest uri is resolved.
+     * queue node to the workers, it blocks while too many nodes are in flight.
+     */
+    void copy(FileNode *node);
+    void waitForDone();
+
+    /*!
+     * \brief takeFailedNodes
+     * \return the nodes went into error except cancellation, in the order they were queued.
+     */
+    QList<FileNode *> takeFailedNodes();
+
+protected:
+    void copyInWorker(FileNode *node, quint64 serial);
+    static void progress_callback(goffset current_num_bytes, goffset total_num_bytes, gpointer data);
+
+private:
+    friend class FileCopyTask;
+
+    QThreadPool *m_pool = nullptr;
+    QSemaphore m_slots;
+    int m_slot_count = 0;
+
+    GCancellable *m_cancellable = nullptr;
+    GFileCopyFlags m_flags = G_FILE_COPY_NONE;
+
+    ProgressCallback m_progress_callback;
+    FinishedCallback m_finished_callback;
+    ReleasedCallback m_released_callback;
+
+    quint64 m_serial = 0;
+    QList<QPair<quint64, FileNode *>> m_failed_nodes;
+    QMutex m_failed_nodes_mutex;
+};
+
+}
+
+#endif // FILECOPYENGINE_H
@@ -24,6 +24,9 @@
 
 #include "file-node-reporter.h"
 #include "file-node.h"
+#include "file-node-scanner.h"
+#include "file-copy-engine.h"
+#include "local-file-copy.h"
 #include "file-enumerator.h"
 #include "file-info.h"
 
@@ -33,10 +36,54 @@
 
 #include "clipboard-utils.h"
 #include <QProcess>
+#include <QMutex>
 #include <QDebug>
 
 using namespace Peony;
 
+/*!
+ * \brief The RollbackJournalEntry struct
+ * a dest made by FileCopyOperation::runPipelined(), it is deleted when rollbacking.
+ */
+struct RollbackJournalEntry {
+    QString srcUri;
+    QString destUri;
+    bool isFolder = false;
+};
+
+struct PipelinedNodeRecord {
+    int liveChildren = 0;
+    //all the children were found.
+    bool left = false;
+    //the dest folder was made by this operation.
+    bool created = false;
+};
+
+static void deleteDestRecursively(GFile *file) {
+    GFileEnumerator *enumerator = g_file_enumerate_children(file,
+                                                            G_FILE_ATTRIBUTE_STANDARD_NAME ","
+                                                            G_FILE_ATTRIBUTE_STANDARD_TYPE,
+                                                            G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                                            nullptr,
+                                                            nullptr);
+    if (enumerator) {
+        GFileInfo *info = nullptr;
+        while ((info = g_file_enumerator_next_file(enumerator, nullptr, nullptr))) {
+            GFile *child = g_file_get_child(file, g_file_info_get_name(info));
+            if (g_file_info_get_file_type(info) == G_FILE_TYPE_DIRECTORY) {
+                deleteDestRecursively(child);
+            } else {
+                g_file_delete(child, nullptr, nullptr);
+            }
+            g_object_unref(child);
+            g_object_unref(info);
+        }
+        g_file_enumerator_close(enumerator, nullptr, nullptr);
+        g_object_unref(enumerator);
+    }
+    g_file_delete(file, nullptr, nullptr);
+}
+
 static void handleDuplicate(FileNode *node) {
     QString name = node->destBaseName();
     QRegExp regExpNum("^\\(\\d+\\)");
@@ -157,20 +204,14 @@ void FileCopyOperation::progress_callback(goffset current_num_bytes,
     if (total_num_bytes < current_num_bytes)
         return;
 
-    QUrl url(p_this->m_current_src_uri);
-    auto currnet = p_this->m_current_offset + current_num_bytes;
-    auto total = p_this->m_total_szie;
-    auto fileIconName = FileUtils::getFileIconName(p_this->m_current_src_uri, false);
-    auto destFileName = FileUtils::isFileDirectory(p_this->m_current_dest_dir_uri) ?
-                p_this->m_current_dest_dir_uri + "/" + url.fileName() : p_this->m_current_dest_dir_uri;
-    qDebug()<<currnet*1.0/total;
-    Q_EMIT p_this->FileProgressCallback(p_this->m_current_src_uri, destFileName, fileIconName, currnet, total);
+    //called for every chunk, do not query files or emit signals here.
+    p_this->progress()->setHandledBytes(p_this->m_current_offset.load() + current_num_bytes);
 }
 
-void FileCopyOperation::copyRecursively(FileNode *node)
+bool FileCopyOperation::copyRecursively(FileNode *node)
 {
     if (isCancelled())
-        return;
+        return false;
 
     node->setState(FileNode::Handling);
     QString destName = "";
@@ -180,12 +221,20 @@ fallback_retry:
     QUrl destFileUrl = destFileUri;
     node->setDestUri(destFileUri);
     QString srcUri = node->uri();
-    qDebug()<<"dest file uri:"<<destFileUri;
+
+    //the conflicts known to happen are handled in order here, as the engine
+    //reports a conflict only after the whole tree was walked.
+    bool conflictExpected = m_is_duplicated_copy || m_prehandle_hash.contains(G_IO_ERROR_EXISTS);
+    if (m_copy_engine && !conflictExpected && FileCopyEngine::shouldCopyInParallel(node)) {
+        m_copy_engine->copy(node);
+        return true;
+    }
 
     GFileWrapperPtr destFile = wrapGFile(g_file_new_for_uri(destFileUri.toUtf8().constData()));
 
     m_current_src_uri = node->uri();
     m_current_dest_dir_uri = destFileUri;
+    progress()->setCurrentFile(srcUri, destFileUri, FileUtils::getFileIconName(srcUri, false));
 
     if (node->isFolder()) {
         GError *err = nullptr;
@@ -197,7 +246,7 @@ fallback_retry:
         if (err) {
             FileOperationError except;
             if (err->code == G_IO_ERROR_CANCELLED) {
-                return;
+                return false;
             }
             auto errWrapperPtr = GErrorWrapper::wrapFrom(err);
             int handle_type = prehandle(err);
@@ -293,7 +342,8 @@ fallback_retry:
             node->setState(FileNode::Handled);
         }
         //assume that make dir finished anyway
-        m_current_offset += node->size();
+        m_current_offset.fetchAndAddRelaxed(node->size());
+        progress()->setHandledBytes(m_current_offset.load());
         Q_EMIT operationProgressedOne(node->uri(), node->destUri(), node->size());
         for (auto child : *(node->children())) {
             copyRecursively(child);
@@ -301,13 +351,13 @@ fallback_retry:
     } else {
         GError *err = nullptr;
         GFileWrapperPtr sourceFile = wrapGFile(g_file_new_for_uri(node->uri().toUtf8().constData()));
-        g_file_copy(sourceFile.get()->get(),
-                    destFile.get()->get(),
-                    m_default_copy_flag,
-                    getCancellable().get()->get(),
-                    GFileProgressCallback(progress_callback),
-                    this,
-                    &err);
+        LocalFileCopy::copy(sourceFile.get()->get(),
+                            destFile.get()->get(),
+                            m_default_copy_flag,
+                            getCancellable().get()->get(),
+                            GFileProgressCallback(progress_callback),
+                            this,
+                            &err);
 
         if (err) {
             switch (err->code) {
@@ -323,7 +373,7 @@ fallback_retry:
                 break;
             }
             case G_IO_ERROR_CANCELLED:
-                return;
+                return false;
             case G_IO_ERROR_EXISTS:
                 char* destFileName = g_file_get_uri(destFile.get()->get());
                 if (NULL != destFileName) {
@@ -372,25 +422,25 @@ fallback_retry:
                 break;
             }
             case OverWriteOne: {
-                g_file_copy(sourceFile.get()->get(),
-                            destFile.get()->get(),
-                            GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_OVERWRITE),
-                            getCancellable().get()->get(),
-                            GFileProgressCallback(progress_callback),
-                            this,
-                            nullptr);
+                LocalFileCopy::copy(sourceFile.get()->get(),
+                                    destFile.get()->get(),
+                                    GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_OVERWRITE),
+                                    getCancellable().get()->get(),
+                                    GFileProgressCallback(progress_callback),
+                                    this,
+                                    nullptr);
                 node->setState(FileNode::Handled);
                 node->setErrorResponse(OverWriteOne);
                 break;
             }
             case OverWriteAll: {
-                g_file_copy(sourceFile.get()->get(),
-                            destFile.get()->get(),
-                            GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_OVERWRITE),
-                            getCancellable().get()->get(),
-                            GFileProgressCallback(progress_callback),
-                            this,
-                            nullptr);
+                LocalFileCopy::copy(sourceFile.get()->get(),
+                                    destFile.get()->get(),
+                                    GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_OVERWRITE),
+                                    getCancellable().get()->get(),
+                                    GFileProgressCallback(progress_callback),
+                                    this,
+                                    nullptr);
                 node->setState(FileNode::Handled);
                 node->setErrorResponse(OverWriteOne);
                 m_prehandle_hash.insert(err->code, OverWriteOne);
@@ -443,11 +493,13 @@ fallback_retry:
         } else {
             node->setState(FileNode::Handled);
         }
-        m_current_offset += node->size();
+        m_current_offset.fetchAndAddRelaxed(node->size());
+        progress()->setHandledBytes(m_current_offset.load());
         fileSync(srcUri, destFileUri);
         Q_EMIT operationProgressedOne(node->uri(), node->destUri(), node->size());
     }
     destFile.reset();
+    return false;
 }
 
 void FileCopyOperation::rollbackNodeRecursively(FileNode *node)
@@ -511,6 +563,13 @@ void FileCopyOperation::run()
 
     Q_EMIT operationRequestShowWizard();
 
+    if (m_pipelined_preparation) {
+        runPipelined();
+        syncPendingFiles();
+        Q_EMIT operationFinished();
+        return;
+    }
+
     goffset *total_size = new goffset(0);
 
     QList<FileNode*> nodes;
@@ -523,12 +582,39 @@ void FileCopyOperation::run()
 
     Q_EMIT operationPrepared();
 
-    m_total_szie = *total_size;
+    m_total_szie.store(*total_size);
+    progress()->setTotalBytes(*total_size);
     delete total_size;
 
+    FileCopyEngine copyEngine(getCancellable().get()->get(), m_default_copy_flag);
+    copyEngine.setProgressCallback([=](FileNode *node, goffset current, goffset total) {
+        Q_UNUSED(node);
+        if (total < current)
+            return;
+        progress()->setHandledBytes(m_current_offset.load() + current);
+    });
+    copyEngine.setFinishedCallback([=](FileNode *node) {
+        m_current_offset.fetchAndAddRelaxed(node->size());
+        progress()->setHandledBytes(m_current_offset.load());
+        //the icon is left to the previous one, it is not worth a query for a small file.
+        progress()->setCurrentFile(node->uri(), node->destUri());
+        fileSync(node->uri(), node->destUri());
+        Q_EMIT operationProgressedOne(node->uri(), node->destUri(), node->size());
+    });
+
+    m_copy_engine = &copyEngine;
     for (auto node : nodes) {
         copyRecursively(node);
     }
+    copyEngine.waitForDone();
+    m_copy_engine = nullptr;
+
+    //the files went into error are handled one by one, as they need user's response.
+    for (auto node : copyEngine.takeFailedNodes()) {
+        if (isCancelled())
+            break;
+        copyRecursively(node);
+    }
     Q_EMIT operationProgressed();
 
     if (isCancelled()) {
@@ -553,10 +639,180 @@ void FileCopyOperation::run()
 
     nodes.clear();
 
+    syncPendingFiles();
     Q_EMIT operationFinished();
     //notifyFileWatcherOperationFinished();
 }
 
+void FileCopyOperation::runPipelined()
+{
+    FileNodeScanner scanner(m_source_uris, m_reporter);
+    scanner.start();
+
+    QList<FileNode*> roots;
+    QHash<FileNode*, PipelinedNodeRecord> records;
+    QList<RollbackJournalEntry> journal;
+    //the workers of engine release nodes and journal too.
+    QMutex recordsMutex;
+
+    //must be called with recordsMutex locked.
+    auto journalNode = [&](FileNode *node, bool checkConflict) {
+        //the dest is deleted with its created parent.
+        if (node->parent() && records.value(node->parent()).created)
+            return;
+        if (node->isFolder()) {
+            if (!records.value(node).created)
+                return;
+        } else {
+            if (node->state() != FileNode::Handling && node->state() != FileNode::Handled)
+                return;
+            if (checkConflict && m_conflict_files.contains(node->destUri()))
+                return;
+        }
+        RollbackJournalEntry entry;
+        entry.srcUri = node->uri();
+        entry.destUri = node->destUri();
+        entry.isFolder = node->isFolder();
+        journal<<entry;
+    };
+
+    //must be called with recordsMutex locked.
+    auto releaseNode = [&](FileNode *node) {
+        while (node) {
+            FileNode *parent = node->parent();
+            records.remove(node);
+            if (!parent)
+                break;
+            delete node;
+
+            auto &record = records[parent];
+            record.liveChildren--;
+            if (!record.left || record.liveChildren > 0)
+                break;
+            node = parent;
+        }
+    };
+
+    FileCopyEngine copyEngine(getCancellable().get()->get(), m_default_copy_flag);
+    copyEngine.setProgressCallback([=](FileNode *node, goffset current, goffset total) {
+        Q_UNUSED(node);
+        if (total < current)
+            return;
+        progress()->setHandledBytes(m_current_offset.load() + current);
+    });
+    copyEngine.setFinishedCallback([&](FileNode *node) {
+        m_current_offset.fetchAndAddRelaxed(node->size());
+        progress()->setHandledBytes(m_current_offset.load());
+        //the icon is left to the previous one, it is not worth a query for a small file.
+        progress()->setCurrentFile(node->uri(), node->destUri());
+        fileSync(node->uri(), node->destUri());
+        Q_EMIT operationProgressedOne(node->uri(), node->destUri(), node->size());
+
+        //a file copied by engine never overwrites, it is not a conflict file.
+        QMutexLocker locker(&recordsMutex);
+        journalNode(node, false);
+    });
+    copyEngine.setReleasedCallback([&](FileNode *node) {
+        QMutexLocker locker(&recordsMutex);
+        releaseNode(node);
+    });
+
+    m_copy_engine = &copyEngine;
+    while (true) {
+        auto entry = scanner.take();
+        m_total_szie.store(scanner.scannedSize());
+        progress()->setTotalBytes(m_total_szie.load());
+        if (entry.type == FileNodeScanner::ScanFinished) {
+            Q_EMIT operationPrepared();
+            break;
+        }
+
+        FileNode *node = entry.node;
+        if (entry.type == FileNodeScanner::LeaveFolder) {
+            QMutexLocker locker(&recordsMutex);
+            auto &record = records[node];
+            record.left = true;
+            if (record.liveChildren == 0)
+                releaseNode(node);
+            continue;
+        }
+
+        {
+            QMutexLocker locker(&recordsMutex);
+            records.insert(node, PipelinedNodeRecord());
+            if (node->parent()) {
+                records[node->parent()].liveChildren++;
+            } else {
+                roots<<node;
+            }
+        }
+
+        //the children of a folder are not in its children list,
+        //so only the dest folder is made here.
+        bool isFolder = node->isFolder();
+        //the node belongs to engine once it is queued, it may be released already.
+        if (copyRecursively(node))
+            continue;
+
+        if (isFolder) {
+            QMutexLocker locker(&recordsMutex);
+            records[node].created = node->state() == FileNode::Handled && node->responseType() != OverWriteOne;
+            journalNode(node, true);
+            continue;
+        }
+
+        QMutexLocker locker(&recordsMutex);
+        journalNode(node, true);
+        releaseNode(node);
+    }
+    copyEngine.waitForDone();
+    m_copy_engine = nullptr;
+
+    //the files went into error are handled one by one, as they need user's response.
+    //their parents are still alive as they were not released.
+    for (auto node : copyEngine.takeFailedNodes()) {
+        if (!isCancelled())
+            copyRecursively(node);
+        QMutexLocker locker(&recordsMutex);
+        journalNode(node, true);
+        releaseNode(node);
+    }
+    Q_EMIT operationProgressed();
+
+    if (isCancelled()) {
+        Q_EMIT operationStartRollbacked();
+        for (int i = journal.count() - 1; i >= 0; i--) {
+            auto entry = journal.at(i);
+            GFile *destFile = g_file_new_for_uri(entry.destUri.toUtf8().constData());
+            if (entry.isFolder) {
+                deleteDestRecursively(destFile);
+            } else {
+                g_file_delete(destFile, nullptr, nullptr);
+            }
+            g_object_unref(destFile);
+            operationRollbackedOne(entry.destUri, entry.srcUri);
+        }
+    }
+
+    setHasError(false);
+
+    //the nodes skipped after cancelling were never released.
+    for (auto node : records.keys()) {
+        if (node->parent())
+            delete node;
+    }
+    records.clear();
+
+    for (auto node : roots) {
+        if (!isCancelled())
+            m_info->m_node_map.insert(node->uri(), node->destUri());
+        delete node;
+    }
+    roots.clear();
+
+    m_info->m_dest_uris = m_info->m_node_map.values();
+}
+
 void FileCopyOperation::cancel()
 {
     if (m_reporter) {
@@ -27,10 +27,13 @@
 
 #include "file-operation.h"
 
+#include <QAtomicInteger>
+
 namespace Peony {
 
 class FileNodeReporter;
 class FileNode;
+class FileCopyEngine;
 
 /*!
  * \brief The FileCopyOperation class
@@ -49,6 +52,21 @@ public:
         return m_info;
     }
 
+    /*!
+     * \brief setPipelinedPreparation
+     * \param pipelined
+     * <br>
+     * If true, which is default, the source trees are scanned by a FileNodeScanner
+     * while the found files are copied, the total size is refined as the scan
+     * proceeds. Otherwise the whole trees are enumerated before the first byte
+     * is copied.
+     * </br>
+     * \see runPipelined().
+     */
+    void setPipelinedPreparation(bool pipelined) {
+        m_pipelined_preparation = pipelined;
+    }
+
 public Q_SLOTS:
     void cancel() override;
 
@@ -60,9 +78,17 @@ protected:
     /*!
      * \brief copyRecursively
      * \param node
-     * \see FileMoveOperation::copyRecursively()
+     * <br>
+     * While the tree is walked, small files are queued to m_copy_engine
+     * after their parent directory was created, the others are copied here.
+     * A duplicated copy, or a copy after the conflicts were answered for all,
+     * is not queued, so the conflicts are still handled in order.
+     * </br>
+     * \return true if node was queued to m_copy_engine. A queued node belongs
+     * to the engine and may be released before this returns, do not touch it.
+     * \see FileMoveOperation::copyRecursively(), FileCopyEngine.
      */
-    void copyRecursively(FileNode *node);
+    bool copyRecursively(FileNode *node);
     /*!
      * \brief rollbackNodeRecursively
      * \param node
@@ -73,6 +99,21 @@ protected:
      */
     void rollbackNodeRecursively(FileNode *node);
 
+    /*!
+     * \brief runPipelined
+     * <br>
+     * Copy the nodes in the order FileNodeScanner finds them. A node is deleted
+     * once it and its children were handled, so the memory is bounded by the
+     * scanner queue and the depth of trees rather than the count of files.
+     * The roots are kept for the undo information.
+     * </br>
+     * \note
+     * As the nodes are gone when the operation is cancelled, the created dests
+     * are recorded in a journal while copying, a created folder is recorded
+     * instead of its children. The rollback walks the journal backwards.
+     */
+    void runPipelined();
+
 private:
     /*!
      * \brief m_is_duplicated_copy
@@ -96,8 +137,19 @@ private:
     QString m_current_src_uri = nullptr;
     QString m_current_dest_dir_uri = nullptr;
 
-    goffset m_current_offset = 0;
-    goffset m_total_szie = 0;
+    /*!
+     * \brief m_current_offset
+     * bytes of the handled nodes, it is also updated by the workers of m_copy_engine.
+     */
+    QAtomicInteger<qint64> m_current_offset;
+    /*!
+     * \brief m_total_szie
+     * total bytes of the operation, it grows while the sources are scanned.
+     */
+    QAtomicInteger<qint64> m_total_szie;
+    bool m_pipelined_preparation = true;
+
+    FileCopyEngine *m_copy_engine = nullptr;
 
     GFileCopyFlags m_default_copy_flag = GFileCopyFlags(G_FILE_COPY_NOFOLLOW_SYMLINKS);
 
@@ -138,6 +138,7 @@ end:
 //        }
 //    }
 
+    syncPendingFiles();
     operationFinished();
     //notifyFileWatcherOperationFinished();
 }
@@ -23,6 +23,7 @@
 #include "file-move-operation.h"
 #include "file-node-reporter.h"
 #include "file-node.h"
+#include "local-file-copy.h"
 #include "file-enumerator.h"
 #include "file-info.h"
 
@@ -115,14 +116,8 @@ void FileMoveOperation::progress_callback(goffset current_num_bytes,
     if (total_num_bytes < current_num_bytes)
         return;
 
-    QUrl url(p_this->m_current_src_uri);
-    auto currnet = p_this->m_current_offset + current_num_bytes;
-    auto total = p_this->m_total_szie;
-    auto fileIconName = FileUtils::getFileIconName(p_this->m_current_src_uri, false);
-    auto destFileName = FileUtils::isFileDirectory(p_this->m_current_dest_dir_uri) ?
-                p_this->m_current_dest_dir_uri + "/" + url.fileName() : p_this->m_current_dest_dir_uri;
-
-    Q_EMIT p_this->FileProgressCallback(p_this->m_current_src_uri, destFileName, fileIconName, currnet, total);
+    //called for every chunk, do not query files or emit signals here.
+    p_this->progress()->setHandledBytes(p_this->m_current_offset + current_num_bytes);
     //format: move srcUri to destDirUri: curent_bytes(count) of total_bytes(count).
 }
 
@@ -167,6 +162,7 @@ void FileMoveOperation::move()
 
         char *dest_uri = g_file_get_uri(destFile.get()->get());
         file->setDestUri(dest_uri);
+        progress()->setCurrentFile(srcUri, file->destUri(), FileUtils::getFileIconName(srcUri, false));
 
         g_free(dest_uri);
         g_free(base_name);
@@ -561,16 +557,14 @@ void FileMoveOperation::copyRecursively(FileNode *node)
     g_free(dest_dir_uri);
     g_object_unref(dest_parent);
     QString destName = "";
+    progress()->setCurrentFile(node->uri(), node->destUri(), FileUtils::getFileIconName(node->uri(), false));
 
 fallback_retry:
     if (node->isFolder()) {
         auto realDestUri = node->resolveDestFileUri(m_dest_dir_uri);
         destFile = wrapGFile(g_file_new_for_uri(realDestUri.toUtf8().constData()));
         GError *err = nullptr;
-        auto fileIconName = FileUtils::getFileIconName(m_current_src_uri, false);
-        auto destFileName = FileUtils::isFileDirectory(m_current_dest_dir_uri) ? nullptr : m_current_dest_dir_uri;
         //NOTE: mkdir doesn't have a progress callback.
-        Q_EMIT FileProgressCallback(m_current_src_uri, destFileName, fileIconName, node->size(), node->size());
         g_file_make_directory(destFile.get()->get(),getCancellable().get()->get(), &err);
         if (err) {
             setHasError(true);
@@ -679,11 +673,9 @@ fallback_retry:
             //node->setState(FileNode::Handled);
         }
 
-        fileIconName = FileUtils::getFileIconName(m_current_src_uri, false);
-        destFileName = FileUtils::isFileDirectory(m_current_dest_dir_uri) ? nullptr : m_current_dest_dir_uri;
         //assume that make dir finished anyway
         m_current_offset += node->size();
-        Q_EMIT FileProgressCallback(m_current_src_uri, destFileName, fileIconName, m_current_offset, m_total_szie);
+        progress()->setHandledBytes(m_current_offset);
         Q_EMIT operationProgressedOne(node->uri(), node->destUri(), node->size());
         for (auto child : *(node->children())) {
             copyRecursively(child);
@@ -693,13 +685,13 @@ fallback_retry:
         GFileWrapperPtr sourceFile = wrapGFile(g_file_new_for_uri(node->uri().toUtf8().constData()));
         auto realDestUri = node->resolveDestFileUri(m_dest_dir_uri);
         destFile = wrapGFile(g_file_new_for_uri(realDestUri.toUtf8().constData()));
-        g_file_copy(sourceFile.get()->get(),
-                    destFile.get()->get(),
-                    m_default_copy_flag,
-                    getCancellable().get()->get(),
-                    GFileProgressCallback(progress_callback),
-                    this,
-                    &err);
+        LocalFileCopy::copy(sourceFile.get()->get(),
+                            destFile.get()->get(),
+                            m_default_copy_flag,
+                            getCancellable().get()->get(),
+                            GFileProgressCallback(progress_callback),
+                            this,
+                            &err);
 
         if (err) {
             setHasError(true);
@@ -757,25 +749,25 @@ fallback_retry:
                 break;
             }
             case OverWriteOne: {
-                g_file_copy(sourceFile.get()->get(),
-                            destFile.get()->get(),
-                            GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_OVERWRITE),
-                            getCancellable().get()->get(),
-                            GFileProgressCallback(progress_callback),
-                            this,
-                            nullptr);
+                LocalFileCopy::copy(sourceFile.get()->get(),
+                                    destFile.get()->get(),
+                                    GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_OVERWRITE),
+                                    getCancellable().get()->get(),
+                                    GFileProgressCallback(progress_callback),
+                                    this,
+                                    nullptr);
                 //node->setState(FileNode::Handled);
                 node->setErrorResponse(OverWriteOne);
                 break;
             }
             case OverWriteAll: {
-                g_file_copy(sourceFile.get()->get(),
-                            destFile.get()->get(),
-                            GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_OVERWRITE),
-                            getCancellable().get()->get(),
-                            GFileProgressCallback(progress_callback),
-                            this,
-                            nullptr);
+                LocalFileCopy::copy(sourceFile.get()->get(),
+                                    destFile.get()->get(),
+                                    GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_OVERWRITE),
+                                    getCancellable().get()->get(),
+                                    GFileProgressCallback(progress_callback),
+                                    this,
+                                    nullptr);
                 //node->setState(FileNode::Handled);
                 node->setErrorResponse(OverWriteOne);
                 m_prehandle_hash.insert(err->code, OverWriteOne);
@@ -803,13 +795,13 @@ fallback_retry:
                 }
                 auto handledDestFileUri = node->resolveDestFileUri(m_dest_dir_uri);
                 auto handledDestFile = wrapGFile(g_file_new_for_uri(handledDestFileUri.toUtf8()));
-                g_file_copy(sourceFile.get()->get(),
-                            handledDestFile.get()->get(),
-                            GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_BACKUP),
-                            getCancellable().get()->get(),
-                            GFileProgressCallback(progress_callback),
-                            this,
-                            nullptr);
+                LocalFileCopy::copy(sourceFile.get()->get(),
+                                    handledDestFile.get()->get(),
+                                    GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_BACKUP),
+                                    getCancellable().get()->get(),
+                                    GFileProgressCallback(progress_callback),
+                                    this,
+                                    nullptr);
                 //node->setState(FileNode::Handled);
                 node->setErrorResponse(BackupOne);
                 setHasError(false);
@@ -836,9 +828,7 @@ fallback_retry:
         }
         fileSync(node->uri(), realDestUri);
         m_current_offset += node->size();
-        auto fileIconName = FileUtils::getFileIconName(m_current_src_uri, false);
-        auto destFileName = FileUtils::isFileDirectory(node->destUri()) ? nullptr : node->destUri();
-        Q_EMIT FileProgressCallback(node->uri(), destFileName, fileIconName, m_current_offset, m_total_szie);
+        progress()->setHandledBytes(m_current_offset);
         Q_EMIT operationProgressedOne(node->uri(), node->destUri(), node->size());
     }
     destFile.reset();
@@ -891,6 +881,7 @@ void FileMoveOperation::moveForceUseFallback()
     operationPrepared();
 
     m_total_szie = *total_size;
+    progress()->setTotalBytes(m_total_szie);
     delete total_size;
 
     for (auto node : nodes) {
@@ -1010,6 +1001,7 @@ start:
     }
     qDebug()<<"finished";
 end:
+    syncPendingFiles();
     Q_EMIT operationFinished();
     //notifyFileWatcherOperationFinished();
 }
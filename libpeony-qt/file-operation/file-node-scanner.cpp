@@ -0,0 +1,168 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "file-node-scanner.h"
+#include "file-node.h"
+#include "file-node-reporter.h"
+
+//entries queued ahead of the operation, it bounds the nodes in memory.
+#ifndef PEONY_FILE_NODE_SCANNER_QUEUE_SIZE
+#define PEONY_FILE_NODE_SCANNER_QUEUE_SIZE 4096
+#endif
+
+using namespace Peony;
+
+FileNodeScanner::FileNodeScanner(const QStringList &uris, FileNodeReporter *reporter, QObject *parent) : QThread(parent)
+{
+    m_uris = uris;
+    m_reporter = reporter;
+}
+
+FileNodeScanner::~FileNodeScanner()
+{
+    cancel();
+    wait();
+
+    for (auto entry : m_queue) {
+        if (entry.type == NodeFound)
+            delete entry.node;
+    }
+}
+
+FileNodeScanner::Entry FileNodeScanner::take()
+{
+    QMutexLocker locker(&m_mutex);
+    while (m_queue.isEmpty()) {
+        m_not_empty.wait(&m_mutex);
+    }
+
+    Entry entry = m_queue.dequeue();
+    m_not_full.wakeOne();
+    return entry;
+}
+
+void FileNodeScanner::cancel()
+{
+    QMutexLocker locker(&m_mutex);
+    m_canceled = true;
+    m_not_full.wakeAll();
+}
+
+bool FileNodeScanner::isCanceled()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_canceled || (m_reporter && m_reporter->isOperationCancelled());
+}
+
+bool FileNodeScanner::put(EntryType type, FileNode *node)
+{
+    QMutexLocker locker(&m_mutex);
+    //the operation might be canceled from ui thread, it is polled while waiting.
+    while (type != ScanFinished && m_queue.count() >= PEONY_FILE_NODE_SCANNER_QUEUE_SIZE) {
+        if (m_canceled || (m_reporter && m_reporter->isOperationCancelled()))
+            break;
+        m_not_full.wait(&m_mutex, 100);
+    }
+
+    if (type != ScanFinished && (m_canceled || (m_reporter && m_reporter->isOperationCancelled()))) {
+        if (type == NodeFound)
+            delete node;
+        return false;
+    }
+
+    Entry entry;
+    entry.type = type;
+    entry.node = node;
+    m_queue.enqueue(entry);
+    m_not_empty.wakeOne();
+    return true;
+}
+
+void FileNodeScanner::run()
+{
+    for (auto uri : m_uris) {
+        if (isCanceled())
+            break;
+
+        FileNode *node = new FileNode(uri, nullptr, m_reporter);
+        m_scanned_size.fetchAndAddRelaxed(node->size());
+        bool isFolder = node->isFolder();
+        if (!put(NodeFound, node))
+            break;
+        if (isFolder) {
+            scanChildren(node);
+            if (!put(LeaveFolder, node))
+                break;
+        }
+    }
+
+    put(ScanFinished, nullptr);
+}
+
+void FileNodeScanner::scanChildren(FileNode *node)
+{
+    if (isCanceled())
+        return;
+
+    GFile *file = g_file_new_for_uri(node->uri().toUtf8().constData());
+    GFileEnumerator *enumerator = g_file_enumerate_children(file,
+                                                            G_FILE_ATTRIBUTE_STANDARD_NAME ","
+                                                            G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+                                                            G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                                                            G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                                            nullptr,
+                                                            nullptr);
+    if (!enumerator) {
+        g_object_unref(file);
+        return;
+    }
+
+    while (!isCanceled()) {
+        GFileInfo *info = g_file_enumerator_next_file(enumerator, nullptr, nullptr);
+        if (!info)
+            break;
+
+        GFile *child = g_file_get_child(file, g_file_info_get_name(info));
+        char *childUri = g_file_get_uri(child);
+        bool isFolder = g_file_info_get_file_type(info) == G_FILE_TYPE_DIRECTORY;
+        goffset size = g_file_info_get_size(info);
+        g_object_unref(child);
+        g_object_unref(info);
+
+        auto childNode = new FileNode(childUri, node, isFolder, size, m_reporter);
+        g_free(childUri);
+        m_scanned_size.fetchAndAddRelaxed(childNode->size());
+
+        //the node belongs to the operation once it was queued.
+        if (!put(NodeFound, childNode))
+            break;
+        if (isFolder) {
+            scanChildren(childNode);
+            if (!put(LeaveFolder, childNode))
+                break;
+        }
+    }
+
+    g_file_enumerator_close(enumerator, nullptr, nullptr);
+    g_object_unref(enumerator);
+    g_object_unref(file);
+}
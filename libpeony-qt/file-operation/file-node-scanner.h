@@ -0,0 +1,118 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef FILENODESCANNER_H
+#define FILENODESCANNER_H
+
+#include "peony-core_global.h"
+
+#include <QThread>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QStringList>
+#include <QAtomicInteger>
+#include <gio/gio.h>
+
+namespace Peony {
+
+class FileNode;
+class FileNodeReporter;
+
+/*!
+ * \brief The FileNodeScanner class
+ * <br>
+ * FileNodeScanner walks the source trees of an operation in its own thread,
+ * and feeds the nodes to the operation through a bounded queue, so that the
+ * operation can handle the first files while the others are still being
+ * found, and the whole tree is never held in memory.
+ * </br>
+ * <br>
+ * The nodes come in depth first order, a folder comes before its children
+ * and is followed by a LeaveFolder entry once all its children were queued.
+ * The children are not appended to the children list of their parent, the
+ * operation owns every node it took, and a folder must be kept until its
+ * children were handled, for they resolve their dest uris through it.
+ * </br>
+ * \see FileNode::findChildrenRecursively().
+ */
+class PEONYCORESHARED_EXPORT FileNodeScanner : public QThread
+{
+    Q_OBJECT
+public:
+    enum EntryType {
+        NodeFound,
+        LeaveFolder,
+        ScanFinished
+    };
+
+    struct Entry {
+        EntryType type = ScanFinished;
+        FileNode *node = nullptr;
+    };
+
+    explicit FileNodeScanner(const QStringList &uris, FileNodeReporter *reporter, QObject *parent = nullptr);
+    ~FileNodeScanner() override;
+
+    /*!
+     * \brief take
+     * \return the next entry, it blocks until there is one. The last entry is
+     * ScanFinished, which is also returned after the scanner was canceled.
+     */
+    Entry take();
+
+    /*!
+     * \brief cancel
+     * stop scanning, the nodes found but not queued are deleted.
+     */
+    void cancel();
+
+    /*!
+     * \brief scannedSize
+     * \return the total size of nodes found so far, it is refined while scanning.
+     */
+    qint64 scannedSize() {
+        return m_scanned_size.load();
+    }
+
+protected:
+    void run() override;
+    void scanChildren(FileNode *node);
+    bool put(EntryType type, FileNode *node);
+    bool isCanceled();
+
+private:
+    QStringList m_uris;
+    FileNodeReporter *m_reporter = nullptr;
+
+    QQueue<Entry> m_queue;
+    QMutex m_mutex;
+    QWaitCondition m_not_empty;
+    QWaitCondition m_not_full;
+    bool m_canceled = false;
+
+    QAtomicInteger<qint64> m_scanned_size;
+};
+
+}
+
+#endif // FILENODESCANNER_H
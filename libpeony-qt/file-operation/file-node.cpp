@@ -61,8 +61,27 @@ FileNode::FileNode(QString uri, FileNode *parent, FileNodeReporter *reporter)
     m_children = new QList<FileNode*>();
 }
 
+FileNode::FileNode(QString uri, FileNode *parent, bool isFolder, goffset size, FileNodeReporter *reporter)
+{
+    m_uri = uri;
+    m_parent = parent;
+    m_reporter = reporter;
+    m_basename = m_uri.split("/").last();
+    m_dest_basename = m_basename;
+
+    m_is_folder = isFolder;
+    m_size = size;
+    if (uri == "file:///proc/kcore")
+        m_size = 0;
+
+    if (m_reporter) {
+        m_reporter->sendNodeFound(m_uri, m_size);
+    }
+
+    m_children = new QList<FileNode*>();
+}
+
 FileNode::~FileNode() {
-    qDebug()<<"delete node:"<<m_uri;
     m_uri.clear();
     m_basename.clear();
     m_dest_uri.clear();
@@ -69,6 +69,14 @@ public:
     };
 
     FileNode(QString uri, FileNode* parent, FileNodeReporter *reporter = nullptr);
+    /*!
+     * \brief FileNode
+     * \param isFolder
+     * \param size
+     * construct a node whose type and size are known already, such as
+     * a child found by FileNodeScanner, it does not query the file again.
+     */
+    FileNode(QString uri, FileNode* parent, bool isFolder, goffset size, FileNodeReporter *reporter = nullptr);
     ~FileNode();
 
     //FIXME: do i need add cancel function?
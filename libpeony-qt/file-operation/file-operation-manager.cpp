@@ -207,10 +207,11 @@ start:
    }
 
    // begin
-   proc->connect(operation, &FileOperation::operationPreparedOne, proc, &ProgressBar::onElementFoundOne);
+   //the found and handled files are counted in the progress channel, see FileOperation::progress().
    proc->connect(operation, &FileOperation::operationPrepared, proc, &ProgressBar::onElementFoundAll);
-   proc->connect(operation, &FileOperation::operationProgressedOne, proc, &ProgressBar::onFileOperationProgressedOne);
+   //copy and move report their bytes through the progress channel too.
    proc->connect(operation, &FileOperation::FileProgressCallback, proc, &ProgressBar::updateProgress);
+   proc->setProgress(operation->progress());
    proc->connect(operation, &FileOperation::operationProgressed, proc, &ProgressBar::onFileOperationProgressedAll);
    proc->connect(operation, &FileOperation::operationAfterProgressedOne, proc, &ProgressBar::onElementClearOne);
    proc->connect(operation, &FileOperation::operationAfterProgressed, proc, &ProgressBar::switchToRollbackPage);
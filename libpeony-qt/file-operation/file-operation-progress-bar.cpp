@@ -34,6 +34,11 @@
 
 #include <QVector4D>
 
+//interval of sampling the progress channel of operation, in milliseconds.
+#ifndef PEONY_PROGRESS_BAR_SAMPLE_INTERVAL
+#define PEONY_PROGRESS_BAR_SAMPLE_INTERVAL 100
+#endif
+
 QPushButton* btn;
 
 static QPixmap drawSymbolicColoredPixmap (const QPixmap&);
@@ -585,6 +590,56 @@ ProgressBar::~ProgressBar()
 
 }
 
+void ProgressBar::setProgress(std::shared_ptr<Peony::FileOperationProgress> progress)
+{
+    m_progress = progress;
+    m_sampled_file_serial = 0;
+    m_sampled_bytes = -1;
+
+    if (!m_sample_timer) {
+        m_sample_timer = new QTimer(this);
+        m_sample_timer->setInterval(PEONY_PROGRESS_BAR_SAMPLE_INTERVAL);
+        connect(m_sample_timer, &QTimer::timeout, this, &ProgressBar::sampleProgress);
+    }
+    m_sample_timer->start();
+}
+
+void ProgressBar::sampleProgress()
+{
+    if (!m_progress)
+        return;
+
+    bool fileChanged = false;
+    quint32 serial = m_progress->currentFileSerial();
+    if (serial != m_sampled_file_serial) {
+        m_sampled_file_serial = serial;
+        fileChanged = true;
+
+        auto file = m_progress->currentFile();
+        QUrl srcUrl = file.srcUri;
+        m_src_uri = srcUrl.toDisplayString();
+        if (!file.destUri.isEmpty()) {
+            QUrl destUrl = file.destUri;
+            m_dest_uri = destUrl.toDisplayString();
+        }
+        if (!file.iconName.isEmpty() && file.iconName != getIcon().name()) {
+            setIcon(file.iconName);
+        }
+    }
+
+    m_total_count = m_progress->foundFiles();
+    m_current_count = m_progress->handledFiles() + 1;
+    m_total_size = m_progress->foundBytes();
+
+    qint64 total = m_progress->totalBytes();
+    qint64 current = m_progress->handledBytes();
+    if (total <= 0 || (current == m_sampled_bytes && !fileChanged))
+        return;
+
+    m_sampled_bytes = current;
+    updateValue(qMin(1.0, current * 1.0 / total));
+}
+
 void ProgressBar::paintEvent(QPaintEvent *event)
 {
     double x = 0;
@@ -701,35 +756,15 @@ void ProgressBar::updateValue(double value)
     update();
 }
 
-void ProgressBar::onElementFoundOne(const QString &uri, const qint64 &size)
-{
-    ++m_total_count;
-    m_total_size += size;
-    QUrl url = uri;
-    m_src_uri = url.toDisplayString();
-    //char* format_size = g_format_size (quint64(m_total_size));
-    //Calculated by 1024 bytes
-    char* format_size = strtok(g_format_size_full(quint64(m_total_size),G_FORMAT_SIZE_IEC_UNITS),"iB");
-
-    g_free(format_size);
-}
-
 void ProgressBar::onElementFoundAll()
 {
 
 }
 
-void ProgressBar::onFileOperationProgressedOne(const QString &uri, const QString &destUri, const qint64 &size)
-{
-    ++m_current_count;
-
-    Q_UNUSED(uri);
-    Q_UNUSED(size);
-    Q_UNUSED(destUri);
-}
-
 void ProgressBar::updateProgress(const QString &srcUri, const QString &destUri, const QString& fIcon, const quint64& current, const quint64& total)
 {
+    if (m_progress)
+        m_total_size = m_progress->foundBytes();
     if (current >= m_total_size) {
         return;
     }
@@ -765,7 +800,8 @@ void ProgressBar::onElementClearOne(const QString &uri)
 
 void ProgressBar::switchToRollbackPage()
 {
-
+    if (m_sample_timer)
+        m_sample_timer->stop();
 }
 
 void ProgressBar::onStartSync()
@@ -775,6 +811,9 @@ void ProgressBar::onStartSync()
 
 void ProgressBar::onFinished()
 {
+    if (m_sample_timer)
+        m_sample_timer->stop();
+    m_progress = nullptr;
     hide();
     Q_EMIT finished(this);
 }
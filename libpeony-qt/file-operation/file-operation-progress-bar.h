@@ -25,6 +25,11 @@
 #include <QWidget>
 #include <QHBoxLayout>
 #include <QListWidget>
+#include <memory>
+
+#include "file-operation-progress.h"
+
+class QTimer;
 
 class ProgressBar;
 class OtherButton;
@@ -99,6 +104,17 @@ public:
     QIcon& getIcon();
     bool getStatus();
 
+    /*!
+     * \brief setProgress
+     * \param progress
+     * <br>
+     * Sample the progress channel of operation at a fixed rate, instead of
+     * updating for every progress signal.
+     * </br>
+     * \see Peony::FileOperation::progress().
+     */
+    void setProgress(std::shared_ptr<Peony::FileOperationProgress> progress);
+
 private:
     ~ProgressBar();
 
@@ -114,9 +130,7 @@ protected:
 public Q_SLOTS:
     void onCancelled();
     void updateValue(double);
-    void onElementFoundOne (const QString &uri, const qint64 &size);
     void onElementFoundAll ();
-    void onFileOperationProgressedOne(const QString &uri, const QString &destUri, const qint64 &size);
     void updateProgress(const QString &srcUri, const QString &destUri, const QString& fIcon, const quint64& current, const quint64& total);
     void onFileOperationProgressedAll();
     void onElementClearOne(const QString &uri);
@@ -125,6 +139,9 @@ public Q_SLOTS:
     void onFinished();
     void onFileRollbacked(const QString &destUri, const QString &srcUri);
 
+protected Q_SLOTS:
+    void sampleProgress();
+
 private:
     int m_min_width = 400;
     int m_fix_height = 62;
@@ -152,6 +169,11 @@ private:
     qint32 m_current_size = 0;
 
     bool m_is_stopping = false;
+
+    std::shared_ptr<Peony::FileOperationProgress> m_progress = nullptr;
+    QTimer *m_sample_timer = nullptr;
+    quint32 m_sampled_file_serial = 0;
+    qint64 m_sampled_bytes = -1;
 };
 
 class MainProgressBar : public QWidget
@@ -0,0 +1,50 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "file-operation-progress.h"
+
+using namespace Peony;
+
+void FileOperationProgress::setHandledBytes(qint64 bytes)
+{
+    qint64 handled = m_handled_bytes.load();
+    while (bytes > handled) {
+        if (m_handled_bytes.testAndSetRelaxed(handled, bytes))
+            break;
+        handled = m_handled_bytes.load();
+    }
+}
+
+void FileOperationProgress::setCurrentFile(const QString &srcUri, const QString &destUri, const QString &iconName)
+{
+    QMutexLocker locker(&m_current_file_mutex);
+    m_current_file.srcUri = srcUri;
+    m_current_file.destUri = destUri;
+    m_current_file.iconName = iconName;
+    m_current_file_serial.fetchAndAddRelaxed(1);
+}
+
+FileOperationProgress::CurrentFile FileOperationProgress::currentFile()
+{
+    QMutexLocker locker(&m_current_file_mutex);
+    return m_current_file;
+}
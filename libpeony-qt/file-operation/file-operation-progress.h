@@ -0,0 +1,124 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef FILEOPERATIONPROGRESS_H
+#define FILEOPERATIONPROGRESS_H
+
+#include "peony-core_global.h"
+
+#include <QString>
+#include <QMutex>
+#include <QAtomicInteger>
+
+namespace Peony {
+
+/*!
+ * \brief The FileOperationProgress class
+ * <br>
+ * FileOperationProgress is the progress channel between a running operation
+ * and its progress bar. The operation updates the byte and file counters
+ * from its worker threads without posting any event to ui thread, and the
+ * progress bar samples them at a fixed rate.
+ * </br>
+ * <br>
+ * The current file is set once per node, its icon should be computed by
+ * the operation at that time, rather than in a gio progress callback.
+ * </br>
+ * \see FileOperation::progress(), ProgressBar::setProgress().
+ */
+class PEONYCORESHARED_EXPORT FileOperationProgress
+{
+public:
+    struct CurrentFile {
+        QString srcUri;
+        QString destUri;
+        //might be empty, keep the previous icon in that case.
+        QString iconName;
+    };
+
+    void setTotalBytes(qint64 bytes) {
+        m_total_bytes.store(bytes);
+    }
+    qint64 totalBytes() {
+        return m_total_bytes.load();
+    }
+
+    /*!
+     * \brief setHandledBytes
+     * \param bytes
+     * the handled bytes only grow, the workers copying in parallel might
+     * report a smaller value than the other one did.
+     */
+    void setHandledBytes(qint64 bytes);
+    qint64 handledBytes() {
+        return m_handled_bytes.load();
+    }
+
+    /*!
+     * \brief addFoundFile
+     * \param size
+     * count a file found while the operation is prepared, and its size.
+     */
+    void addFoundFile(qint64 size) {
+        m_found_files.fetchAndAddRelaxed(1);
+        m_found_bytes.fetchAndAddRelaxed(size);
+    }
+    quint64 foundFiles() {
+        return m_found_files.load();
+    }
+    qint64 foundBytes() {
+        return m_found_bytes.load();
+    }
+
+    void addHandledFile() {
+        m_handled_files.fetchAndAddRelaxed(1);
+    }
+    quint64 handledFiles() {
+        return m_handled_files.load();
+    }
+
+    void setCurrentFile(const QString &srcUri, const QString &destUri, const QString &iconName = nullptr);
+    CurrentFile currentFile();
+    /*!
+     * \brief currentFileSerial
+     * \return a serial which is changed every time current file is set,
+     * so the sampler can skip reading it if nothing changed.
+     */
+    quint32 currentFileSerial() {
+        return m_current_file_serial.load();
+    }
+
+private:
+    QAtomicInteger<qint64> m_total_bytes;
+    QAtomicInteger<qint64> m_handled_bytes;
+    QAtomicInteger<quint64> m_found_files;
+    QAtomicInteger<qint64> m_found_bytes;
+    QAtomicInteger<quint64> m_handled_files;
+
+    QMutex m_current_file_mutex;
+    CurrentFile m_current_file;
+    QAtomicInteger<quint32> m_current_file_serial;
+};
+
+}
+
+#endif // FILEOPERATIONPROGRESS_H
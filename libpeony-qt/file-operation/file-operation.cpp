@@ -25,6 +25,11 @@
 #include <file-info-job.h>
 #include <file-info.h>
 
+#include <gio/gunixmounts.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
 #include "file-operation.h"
 #include "file-operation-manager.h"
 
@@ -36,7 +41,17 @@ using namespace Peony;
 FileOperation::FileOperation(QObject *parent) : QObject (parent)
 {
     m_cancellable_wrapper = wrapGCancellable(g_cancellable_new());
+    m_progress = std::make_shared<FileOperationProgress>();
     setAutoDelete(true);
+
+    //the files are counted in the emitting thread, the progress bar samples them.
+    connect(this, &FileOperation::operationPreparedOne, this, [=](const QString &srcUri, const qint64 &size) {
+        Q_UNUSED(srcUri)
+        m_progress->addFoundFile(size);
+    }, Qt::DirectConnection);
+    connect(this, &FileOperation::operationProgressedOne, this, [=]() {
+        m_progress->addHandledFile();
+    }, Qt::DirectConnection);
 }
 
 FileOperation::~FileOperation()
@@ -75,6 +90,9 @@ bool FileOperation::makeFileNameValidForDestFS(QString &srcPath, QString &destPa
 
 void FileOperation::fileSync(QString srcFile, QString destDir)
 {
+    if (m_durability_policy == SyncOnEject)
+        return;
+
     if (srcFile.endsWith("/")) {
         srcFile.chop(1);
     }
@@ -86,52 +104,90 @@ void FileOperation::fileSync(QString srcFile, QString destDir)
         destFile = destDir + "/" + srcFile.split("/").back();
     }
 
-    if (!FileUtils::isFileExsit(destFile)) {
-        qDebug() << "file:" << destFile << " is not existed!";
+    // mount root is empty in root filesystem
+    QString srcMountRoot = enclosingMountRoot(srcFile.left(srcFile.lastIndexOf("/")));
+    QString destMountRoot = enclosingMountRoot(destFile.left(destFile.lastIndexOf("/")));
+    if (destMountRoot.isEmpty() || srcMountRoot == destMountRoot) {
         return;
     }
 
-    bool needSync = false;
-    GFile* srcGfile = g_file_new_for_uri(srcFile.toUtf8().constData());
-    GFile* destGfile = g_file_new_for_uri(destFile.toUtf8().constData());
-    GMount* srcMount = g_file_find_enclosing_mount(srcGfile, nullptr, nullptr);
-    GMount* destMount = g_file_find_enclosing_mount(destGfile, nullptr, nullptr);
-
-    // xxxMount is null in root filesystem
-    if ((srcMount != destMount) && (NULL != destMount)) {
-        needSync = true;
+    GFile *destGfile = g_file_new_for_uri(destFile.toUtf8().constData());
+    char *path = g_file_get_path(destGfile);
+    g_object_unref(destGfile);
+    if (!path) {
+        return;
     }
 
-    if (needSync) {
-        auto path = g_file_get_path(destGfile);
-        qDebug() << "sync -- src: " << srcFile << "  ===  " << destDir << "  ===  " << destFile << "  path:" << path;
-        if (path) {
-            QProcess p;
-            auto shellPath = g_shell_quote(path);
-            qDebug() << "start execute: " << QString("sync -f %1").arg(shellPath);
-            p.start(QString("sync -f %1").arg(shellPath));
-            g_free(path);
-            g_free(shellPath);
-            p.waitForFinished(-1);
-            qDebug() << "execute: " << QString("sync -f %1  ok!!!").arg(shellPath);
+    if (m_durability_policy == SyncEachFile) {
+        //the file might not exist if it was skipped.
+        int fd = open(path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+        if (fd >= 0) {
+            fdatasync(fd);
+            close(fd);
+        }
+    } else {
+        char *dirPath = g_path_get_dirname(path);
+        QMutexLocker locker(&m_sync_mutex);
+        if (!m_pending_sync_paths.contains(destMountRoot)) {
+            m_pending_sync_paths.insert(destMountRoot, dirPath);
         }
+        g_free(dirPath);
     }
+    g_free(path);
+}
 
-    if (nullptr != srcMount) {
-        g_object_unref(srcMount);
+void FileOperation::syncPendingFiles()
+{
+    QHash<QString, QString> paths;
+    {
+        QMutexLocker locker(&m_sync_mutex);
+        paths.swap(m_pending_sync_paths);
     }
 
-    if (nullptr != destMount) {
-        g_object_unref(destMount);
+    if (paths.isEmpty())
+        return;
+
+    Q_EMIT operationStartSnyc();
+
+    //one syncfs() per file system, instead of a sync per written file.
+    for (auto path : paths) {
+        int fd = open(path.toUtf8().constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0)
+            continue;
+        syncfs(fd);
+        close(fd);
     }
+}
 
-    if (nullptr != srcGfile) {
-        g_object_unref(srcGfile);
+QString FileOperation::enclosingMountRoot(const QString &dirUri)
+{
+    {
+        QMutexLocker locker(&m_sync_mutex);
+        auto it = m_mount_root_cache.constFind(dirUri);
+        if (it != m_mount_root_cache.constEnd())
+            return it.value();
     }
 
-    if (nullptr != destGfile) {
-        g_object_unref(destGfile);
+    //GVolumeMonitor can only be used in main thread, but this is called by
+    //the workers, so the mount table is read instead. As the volume monitor
+    //does, only the mounts shown to user are taken, such as usb sticks.
+    QString mountRoot = "";
+    GFile *dir = g_file_new_for_uri(dirUri.toUtf8().constData());
+    char *dirPath = g_file_get_path(dir);
+    g_object_unref(dir);
+    if (dirPath) {
+        GUnixMountEntry *entry = g_unix_mount_for(dirPath, nullptr);
+        if (entry) {
+            if (g_unix_mount_guess_should_display(entry))
+                mountRoot = g_unix_mount_get_mount_path(entry);
+            g_unix_mount_free(entry);
+        }
+        g_free(dirPath);
     }
+
+    QMutexLocker locker(&m_sync_mutex);
+    m_mount_root_cache.insert(dirUri, mountRoot);
+    return mountRoot;
 }
 
 void FileOperation::notifyFileWatcherOperationFinished()
@@ -24,6 +24,7 @@
 #define FILEOPERATION_H
 
 #include <QHash>
+#include <QMutex>
 #include <QObject>
 #include <QMetaType>
 #include <QRunnable>
@@ -32,6 +33,7 @@
 #include "gobject-template.h"
 #include "peony-core_global.h"
 #include "file-operation-error-handler.h"
+#include "file-operation-progress.h"
 
 namespace Peony {
 
@@ -63,6 +65,19 @@ class PEONYCORESHARED_EXPORT FileOperation : public QObject, public QRunnable
     Q_OBJECT
 
 public:
+    /*!
+     * \brief The DurabilityPolicy enum
+     * <br>
+     * How the files written to another mount, such as a usb stick, are synced.
+     * </br>
+     * \see fileSync(), syncPendingFiles().
+     */
+    enum DurabilityPolicy {
+        SyncEachFile, /*! fdatasync() every file once it was written. */
+        SyncAtEnd, /*! syncfs() every dest file system once when the operation is finishing. */
+        SyncOnEject /*! leave it to SyncThread, which syncs before the device is unmounted or ejected. */
+    };
+
     explicit FileOperation(QObject *parent = nullptr);
     ~FileOperation();
     virtual void run();
@@ -111,6 +126,31 @@ public:
         return m_is_cancelled;
     }
 
+    /*!
+     * \brief setDurabilityPolicy
+     * \param policy
+     * the default policy is SyncAtEnd.
+     */
+    void setDurabilityPolicy(DurabilityPolicy policy) {
+        m_durability_policy = policy;
+    }
+    DurabilityPolicy durabilityPolicy() {
+        return m_durability_policy;
+    }
+
+    /*!
+     * \brief progress
+     * \return the progress channel of this operation.
+     * \details
+     * Operations which copy data report their progress through the channel instead
+     * of FileProgressCallback() signal, as a gio progress callback might be called
+     * many times for a single file. The channel is shared, so it can be sampled
+     * safely after the operation finished.
+     */
+    std::shared_ptr<FileOperationProgress> progress() {
+        return m_progress;
+    }
+
 Q_SIGNALS:
     /*!
      * \brief invalidOperation
@@ -298,13 +338,38 @@ public Q_SLOTS:
     virtual void cancel();
 
 protected:
+    /*!
+     * \brief fileSync
+     * \param srcFile
+     * \param destFile
+     * <br>
+     * Make the written dest file durable according to the durability policy, if it
+     * is on a mount other than the source's. The mounts are looked up once per directory.
+     * </br>
+     * \note
+     * This might be called by the workers of an operation at the same time.
+     */
     void fileSync (QString srcFile, QString destFile);
+    /*!
+     * \brief syncPendingFiles
+     * sync the file systems written by the operation in SyncAtEnd policy,
+     * call it before operationFinished() is sent.
+     */
+    void syncPendingFiles();
     bool makeFileNameValidForDestFS (QString& srcPath, QString& destPath, QString* newFileName);
 
     GCancellableWrapperPtr getCancellable() {
         return m_cancellable_wrapper;
     }
 
+    /*!
+     * \brief enclosingMountRoot
+     * \param dirUri
+     * \return the path of the mount dirUri belongs to, or empty string for root file system
+     * and the other mounts not shown to user, or for a dir without local path.
+     * \note it reads the mount table, GVolumeMonitor is not used as this is called by the workers.
+     */
+    QString enclosingMountRoot(const QString &dirUri);
     /*!
      * \brief notifyFileWatcherOperationFinished
      * tell views operation finished.
@@ -316,6 +381,14 @@ private:
     bool                        m_reversible = false;
     bool                        m_is_cancelled = false;
     GCancellableWrapperPtr      m_cancellable_wrapper = nullptr;
+    std::shared_ptr<FileOperationProgress> m_progress = nullptr;
+
+    DurabilityPolicy            m_durability_policy = SyncAtEnd;
+    QMutex                      m_sync_mutex;
+    //dir uri to its mount path.
+    QHash<QString, QString>     m_mount_root_cache;
+    //mount path to a local dir path on it, which is synced in syncPendingFiles().
+    QHash<QString, QString>     m_pending_sync_paths;
 };
 
 }
@@ -7,9 +7,13 @@ PKGCONFIG += gio-unix-2.0
 HEADERS += \
     $$PWD/file-node.h                           \
     $$PWD/file-operation.h                      \
+    $$PWD/file-operation-progress.h             \
     $$PWD/file-node-reporter.h                  \
+    $$PWD/file-node-scanner.h                   \
     $$PWD/file-link-operation.h                 \
     $$PWD/file-copy-operation.h                 \
+    $$PWD/file-copy-engine.h                    \
+    $$PWD/local-file-copy.h                     \
     $$PWD/file-move-operation.h                 \
     $$PWD/file-trash-operation.h                \
     $$PWD/file-count-operation.h                \
@@ -28,10 +32,14 @@ HEADERS += \
 SOURCES += \
     $$PWD/file-node.cpp                         \
     $$PWD/file-operation.cpp                    \
+    $$PWD/file-operation-progress.cpp           \
     $$PWD/file-node-reporter.cpp                \
+    $$PWD/file-node-scanner.cpp                 \
     $$PWD/file-link-operation.cpp               \
     $$PWD/file-move-operation.cpp               \
     $$PWD/file-copy-operation.cpp               \
+    $$PWD/file-copy-engine.cpp                  \
+    $$PWD/local-file-copy.cpp                   \
     $$PWD/file-trash-operation.cpp              \
     $$PWD/file-count-operation.cpp              \
     $$PWD/file-delete-operation.cpp             \
@@ -316,6 +316,7 @@ cancel:
 
     fileSync(m_uri, destUri);
 
+    syncPendingFiles();
     Q_EMIT operationFinished();
     //notifyFileWatcherOperationFinished();
 }
@@ -0,0 +1,277 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "local-file-copy.h"
+
+#include <QScopedArrayPointer>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/fs.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#ifndef FICLONE
+#define FICLONE _IOW(0x94, 9, int)
+#endif
+
+//bytes copied between two progress reports and cancellation checks.
+#ifndef PEONY_LOCAL_COPY_CHUNK_SIZE
+#define PEONY_LOCAL_COPY_CHUNK_SIZE 8*1024*1024
+#endif
+
+//buffer of read/write copy, when copy_file_range() is not supported.
+#ifndef PEONY_LOCAL_COPY_BUFFER_SIZE
+#define PEONY_LOCAL_COPY_BUFFER_SIZE 256*1024
+#endif
+
+using namespace Peony;
+
+static ssize_t copy_file_range_compat(int fdIn, loff_t *offIn, int fdOut, loff_t *offOut, size_t length)
+{
+#ifdef __NR_copy_file_range
+    return syscall(__NR_copy_file_range, fdIn, offIn, fdOut, offOut, length, 0);
+#else
+    Q_UNUSED(fdIn)
+    Q_UNUSED(offIn)
+    Q_UNUSED(fdOut)
+    Q_UNUSED(offOut)
+    Q_UNUSED(length)
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+static bool isCopyFileRangeUnsupported(int err)
+{
+    //EXDEV before linux 5.3, EINVAL and EOPNOTSUPP for some file systems.
+    return err == ENOSYS || err == EXDEV || err == EINVAL || err == EOPNOTSUPP || err == ETXTBSY;
+}
+
+static void setErrorFromErrno(GError **error, int err, GFile *file)
+{
+    char *name = g_file_get_parse_name(file);
+    g_set_error(error, G_IO_ERROR, g_io_error_from_errno(err), "Error copying file %s: %s", name, g_strerror(err));
+    g_free(name);
+}
+
+gboolean LocalFileCopy::copy(GFile *source,
+                             GFile *destination,
+                             GFileCopyFlags flags,
+                             GCancellable *cancellable,
+                             GFileProgressCallback progress_callback,
+                             gpointer progress_callback_data,
+                             GError **error)
+{
+    char *sourcePath = g_file_get_path(source);
+    char *destPath = g_file_get_path(destination);
+    bool local = sourcePath && destPath && g_file_is_native(source) && g_file_is_native(destination);
+
+    struct stat sourceStat;
+    struct stat destStat;
+    bool destExists = false;
+    if (local) {
+        int ret = (flags & G_FILE_COPY_NOFOLLOW_SYMLINKS)? lstat(sourcePath, &sourceStat): stat(sourcePath, &sourceStat);
+        local = ret == 0 && S_ISREG(sourceStat.st_mode);
+        destExists = lstat(destPath, &destStat) == 0;
+    }
+    //the others are reported or handled by gio in its own way, an existed
+    //destination is replaced by gio, which keeps it until the copy is done.
+    if (!local || destExists || (flags & (G_FILE_COPY_BACKUP | G_FILE_COPY_ALL_METADATA))) {
+        g_free(sourcePath);
+        g_free(destPath);
+        return g_file_copy(source, destination, flags, cancellable, progress_callback, progress_callback_data, error);
+    }
+
+    if (g_cancellable_set_error_if_cancelled(cancellable, error)) {
+        g_free(sourcePath);
+        g_free(destPath);
+        return false;
+    }
+
+    int sourceFd = open(sourcePath, O_RDONLY|O_CLOEXEC|O_NOFOLLOW);
+    if (sourceFd < 0) {
+        setErrorFromErrno(error, errno, source);
+        g_free(sourcePath);
+        g_free(destPath);
+        return false;
+    }
+
+    //the destination is created here, so it is removed if the copy failed.
+    mode_t destMode = (flags & G_FILE_COPY_TARGET_DEFAULT_PERMS)? 0666: sourceStat.st_mode & 0777;
+    int destFd = open(destPath, O_WRONLY|O_CREAT|O_EXCL|O_CLOEXEC, destMode);
+    if (destFd < 0) {
+        int err = errno;
+        close(sourceFd);
+        setErrorFromErrno(error, err, destination);
+        g_free(sourcePath);
+        g_free(destPath);
+        return false;
+    }
+
+    goffset size = sourceStat.st_size;
+    int err = 0;
+    if (ioctl(destFd, FICLONE, sourceFd) == 0) {
+        if (progress_callback)
+            progress_callback(size, size, progress_callback_data);
+    } else {
+        //a file with less blocks than its size has holes.
+        bool sparse = goffset(sourceStat.st_blocks) * 512 < size;
+        err = copyData(sourceFd, destFd, size, sparse, cancellable, progress_callback, progress_callback_data);
+    }
+
+    if (err == 0) {
+        if (close(destFd) != 0)
+            err = errno;
+    } else {
+        close(destFd);
+    }
+    close(sourceFd);
+
+    //as g_file_copy() does, copy the attributes copied with file, such as the
+    //permissions, the modified time and the extended attributes. failing to
+    //copy them is not a hard error.
+    if (err == 0)
+        g_file_copy_attributes(source, destination, flags, cancellable, nullptr);
+
+    if (err != 0) {
+        unlink(destPath);
+        if (err == ECANCELED) {
+            g_cancellable_set_error_if_cancelled(cancellable, error);
+        } else {
+            setErrorFromErrno(error, err, destination);
+        }
+    }
+
+    g_free(sourcePath);
+    g_free(destPath);
+    return err == 0;
+}
+
+int LocalFileCopy::copyData(int sourceFd, int destFd, goffset size, bool sparse,
+                            GCancellable *cancellable,
+                            GFileProgressCallback progress_callback,
+                            gpointer progress_callback_data)
+{
+    bool useCopyFileRange = true;
+    goffset offset = 0;
+    while (offset < size) {
+        goffset dataStart = offset;
+        goffset dataEnd = size;
+        if (sparse) {
+            dataStart = lseek(sourceFd, offset, SEEK_DATA);
+            if (dataStart < 0) {
+                //ENXIO: only a hole is left. others: holes are not supported.
+                if (errno == ENXIO)
+                    break;
+                sparse = false;
+                dataStart = offset;
+            } else {
+                dataEnd = lseek(sourceFd, dataStart, SEEK_HOLE);
+                if (dataEnd < 0)
+                    dataEnd = size;
+            }
+        }
+
+        dataEnd = qMin(dataEnd, size);
+        if (dataStart >= dataEnd)
+            break;
+
+        int err = copyRange(sourceFd, destFd, dataStart, dataEnd - dataStart, size,
+                            useCopyFileRange, cancellable, progress_callback, progress_callback_data);
+        if (err != 0)
+            return err;
+        offset = dataEnd;
+    }
+
+    //keep the trailing hole, the file is also extended to the size of source.
+    if (sparse && ftruncate(destFd, size) != 0)
+        return errno;
+
+    if (progress_callback)
+        progress_callback(size, size, progress_callback_data);
+    return 0;
+}
+
+int LocalFileCopy::copyRange(int sourceFd, int destFd, goffset offset, goffset length, goffset size,
+                             bool &useCopyFileRange,
+                             GCancellable *cancellable,
+                             GFileProgressCallback progress_callback,
+                             gpointer progress_callback_data)
+{
+    QScopedArrayPointer<char> buffer;
+    goffset end = offset + length;
+    while (offset < end) {
+        if (g_cancellable_is_cancelled(cancellable))
+            return ECANCELED;
+
+        size_t chunk = size_t(qMin(goffset(PEONY_LOCAL_COPY_CHUNK_SIZE), end - offset));
+        if (useCopyFileRange) {
+            loff_t inOffset = offset;
+            loff_t outOffset = offset;
+            ssize_t copied = copy_file_range_compat(sourceFd, &inOffset, destFd, &outOffset, chunk);
+            if (copied > 0) {
+                offset += copied;
+            } else if (copied == 0) {
+                //the source was truncated meanwhile.
+                return 0;
+            } else if (errno == EINTR) {
+                continue;
+            } else if (isCopyFileRangeUnsupported(errno)) {
+                useCopyFileRange = false;
+                continue;
+            } else {
+                return errno;
+            }
+        } else {
+            if (!buffer)
+                buffer.reset(new char[PEONY_LOCAL_COPY_BUFFER_SIZE]);
+            chunk = qMin(chunk, size_t(PEONY_LOCAL_COPY_BUFFER_SIZE));
+            ssize_t readBytes = pread(sourceFd, buffer.data(), chunk, offset);
+            if (readBytes < 0) {
+                if (errno == EINTR)
+                    continue;
+                return errno;
+            }
+            if (readBytes == 0)
+                return 0;
+            ssize_t written = 0;
+            while (written < readBytes) {
+                ssize_t ret = pwrite(destFd, buffer.data() + written, readBytes - written, offset + written);
+                if (ret < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    return errno;
+                }
+                written += ret;
+            }
+            offset += readBytes;
+        }
+
+        if (progress_callback)
+            progress_callback(offset, size, progress_callback_data);
+    }
+    return 0;
+}
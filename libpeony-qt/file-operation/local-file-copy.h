@@ -0,0 +1,79 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef LOCALFILECOPY_H
+#define LOCALFILECOPY_H
+
+#include "peony-core_global.h"
+
+#include <gio/gio.h>
+
+namespace Peony {
+
+/*!
+ * \brief The LocalFileCopy class
+ * <br>
+ * LocalFileCopy copies a regular file between two local paths in kernel,
+ * without moving the data through user space buffers. It tries a reflink
+ * (FICLONE) first, which shares the extents on btrfs and xfs, then
+ * copy_file_range(), which copies in kernel and lets network file systems
+ * copy on server side. The holes of a sparse file are skipped with
+ * SEEK_DATA/SEEK_HOLE, so they stay holes in the copy.
+ * </br>
+ * <br>
+ * copy() has the same signature and error domain as g_file_copy(), it falls
+ * back to g_file_copy() for the others, such as remote files, symbolic links,
+ * special files, an existed destination or a backup copy. As g_file_copy(),
+ * the attributes copied with file are set on the copy, and all the metadata
+ * with G_FILE_COPY_ALL_METADATA, which is left to gio.
+ * </br>
+ */
+class PEONYCORESHARED_EXPORT LocalFileCopy
+{
+public:
+    static gboolean copy(GFile *source,
+                         GFile *destination,
+                         GFileCopyFlags flags,
+                         GCancellable *cancellable,
+                         GFileProgressCallback progress_callback,
+                         gpointer progress_callback_data,
+                         GError **error);
+
+protected:
+    /*!
+     * \brief copyData
+     * \return 0 if all the data was copied, or an errno.
+     */
+    static int copyData(int sourceFd, int destFd, goffset size, bool sparse,
+                        GCancellable *cancellable,
+                        GFileProgressCallback progress_callback,
+                        gpointer progress_callback_data);
+    static int copyRange(int sourceFd, int destFd, goffset offset, goffset length, goffset size,
+                         bool &useCopyFileRange,
+                         GCancellable *cancellable,
+                         GFileProgressCallback progress_callback,
+                         gpointer progress_callback_data);
+};
+
+}
+
+#endif // LOCALFILECOPY_H
@@ -41,6 +41,8 @@
 #define DEFAULT_WINDOW_SIZE         "default-window-size"
 #define DEFAULT_SIDEBAR_WIDTH       "default-sidebar-width"
 #define SHOW_TRASH_DIALOG           "showTrashDialog"
+//memory budget of thumbnails in MiB
+#define THUMBNAIL_MEMORY_BUDGET     "thumbnail-memory-budget"
 
 #define DEFAULT_VIEW_ID             "directory-view/default-view-id"
 #define DEFAULT_VIEW_ZOOM_LEVEL     "directory-view/default-view-zoom-level"
@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core widgets gui concurrent xml KWindowSystem
+QT       += core widgets gui gui-private concurrent xml dbus KWindowSystem
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += printsupport
 
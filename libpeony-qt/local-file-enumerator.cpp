@@ -0,0 +1,430 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "local-file-enumerator.h"
+#include "file-info.h"
+
+#include "mime-type-cache.h"
+
+#include <QTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+#include <QtConcurrent>
+#include <QDebug>
+
+#include <vector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+
+#if defined(__linux__) && defined(SYS_getdents64)
+#define PEONY_HAS_NATIVE_ENUMERATION
+#endif
+
+#ifndef PEONY_LOCAL_ENUMERATOR_BUFFER_SIZE
+#define PEONY_LOCAL_ENUMERATOR_BUFFER_SIZE (64 * 1024)
+#endif
+
+#ifndef PEONY_LOCAL_ENUMERATOR_FILL_SIZE
+//children infos filled in one event loop iteration.
+#define PEONY_LOCAL_ENUMERATOR_FILL_SIZE 2000
+#endif
+
+#ifndef PEONY_LOCAL_ENUMERATOR_POLL_INTERVAL
+#define PEONY_LOCAL_ENUMERATOR_POLL_INTERVAL 16
+#endif
+
+namespace Peony {
+
+/*!
+ * \brief The LocalFileEnumeratorState struct
+ * the state shared by LocalFileEnumerator and its worker,
+ * the worker holds it so that the enumerator can be deleted at any time.
+ */
+struct LocalFileEnumeratorState {
+    QMutex mutex;
+    QList<QVector<LocalFileEntry>> batches;
+    bool done = false;
+    bool successed = false;
+    QAtomicInt cancelled;
+};
+
+}
+
+using namespace Peony;
+
+#ifdef PEONY_HAS_NATIVE_ENUMERATION
+
+struct linux_dirent64 {
+    quint64 d_ino;
+    qint64 d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+struct LocalFileStat {
+    quint32 mode = 0;
+    quint32 uid = 0;
+    quint32 gid = 0;
+    quint64 size = 0;
+    quint64 modifiedTime = 0;
+    quint64 accessTime = 0;
+    quint64 device = 0;
+    quint64 inode = 0;
+};
+
+static bool statAt(int dirfd, const char *name, bool follow, LocalFileStat *st)
+{
+#ifdef STATX_BASIC_STATS
+    struct statx buf;
+    int flags = AT_NO_AUTOMOUNT | AT_STATX_DONT_SYNC;
+    if (!follow)
+        flags |= AT_SYMLINK_NOFOLLOW;
+    unsigned int mask = STATX_TYPE | STATX_MODE | STATX_UID | STATX_GID | STATX_SIZE | STATX_MTIME | STATX_ATIME | STATX_INO;
+    if (statx(dirfd, name, flags, mask, &buf) != 0)
+        return false;
+
+    st->mode = buf.stx_mode;
+    st->uid = buf.stx_uid;
+    st->gid = buf.stx_gid;
+    st->size = buf.stx_size;
+    st->modifiedTime = buf.stx_mtime.tv_sec;
+    st->accessTime = buf.stx_atime.tv_sec;
+    st->device = makedev(buf.stx_dev_major, buf.stx_dev_minor);
+    st->inode = buf.stx_ino;
+#else
+    struct stat buf;
+    if (fstatat(dirfd, name, &buf, follow? 0: AT_SYMLINK_NOFOLLOW) != 0)
+        return false;
+
+    st->mode = buf.st_mode;
+    st->uid = buf.st_uid;
+    st->gid = buf.st_gid;
+    st->size = buf.st_size;
+    st->modifiedTime = buf.st_mtime;
+    st->accessTime = buf.st_atime;
+    st->device = buf.st_dev;
+    st->inode = buf.st_ino;
+#endif
+    return true;
+}
+
+static bool hasPermission(const LocalFileStat &st, uid_t euid, const QVector<gid_t> &groups,
+                          mode_t ownerBit, mode_t groupBit, mode_t otherBit)
+{
+    if (st.uid == euid)
+        return st.mode & ownerBit;
+    if (groups.contains(st.gid))
+        return st.mode & groupBit;
+    return st.mode & otherBit;
+}
+
+static QString contentTypeOf(const LocalFileEntry &entry, quint32 mode)
+{
+    if (S_ISDIR(mode))
+        return "inode/directory";
+    if (S_ISLNK(mode))
+        //a broken symlink.
+        return "inode/symlink";
+    if (S_ISCHR(mode))
+        return "inode/chardevice";
+    if (S_ISBLK(mode))
+        return "inode/blockdevice";
+    if (S_ISFIFO(mode))
+        return "inode/fifo";
+    if (S_ISSOCK(mode))
+        return "inode/socket";
+
+    //guess by name only, like standard::fast-content-type.
+    //FileInfoJob will sniff the content if it is needed.
+    char *type = g_content_type_guess(entry.name.constData(), nullptr, 0, nullptr);
+    QString contentType = type;
+    g_free(type);
+    return contentType;
+}
+
+static void statEntry(int dirfd, const QByteArray &dirPath, uid_t euid, const QVector<gid_t> &groups, LocalFileEntry &entry)
+{
+    QByteArray path = dirPath;
+    if (!path.endsWith('/'))
+        path += '/';
+    path += entry.name;
+
+    char *uri = g_filename_to_uri(path.constData(), nullptr, nullptr);
+    entry.uri = uri;
+    g_free(uri);
+
+    char *displayName = g_filename_display_name(entry.name.constData());
+    entry.displayName = displayName;
+    g_free(displayName);
+
+    LocalFileStat st;
+    if (entry.dType == DT_LNK) {
+        entry.isSymlink = true;
+        entry.statted = statAt(dirfd, entry.name.constData(), true, &st);
+        if (!entry.statted)
+            entry.statted = statAt(dirfd, entry.name.constData(), false, &st);
+    } else {
+        //d_type tells us it is not a symlink, one stat is enough.
+        entry.statted = statAt(dirfd, entry.name.constData(), false, &st);
+        if (entry.statted && S_ISLNK(st.mode)) {
+            //the file system does not support d_type.
+            entry.isSymlink = true;
+            LocalFileStat target;
+            if (statAt(dirfd, entry.name.constData(), true, &target))
+                st = target;
+        }
+    }
+
+    if (!entry.statted) {
+        //leave the rest to FileInfoJob.
+        entry.isDir = entry.dType == DT_DIR;
+        if (entry.isDir)
+            entry.contentType = "inode/directory";
+        return;
+    }
+
+    entry.isDir = S_ISDIR(st.mode);
+    entry.contentType = contentTypeOf(entry, st.mode);
+    entry.size = st.size;
+    entry.modifiedTime = st.modifiedTime;
+    entry.accessTime = st.accessTime;
+    entry.device = st.device;
+    entry.inode = st.inode;
+
+    //acl and capabilities are not considered here, FileInfoJob gives the accurate value.
+    if (euid == 0) {
+        entry.canRead = true;
+        entry.canWrite = true;
+        entry.canExecute = entry.isDir || (st.mode & (S_IXUSR | S_IXGRP | S_IXOTH));
+    } else {
+        entry.canRead = hasPermission(st, euid, groups, S_IRUSR, S_IRGRP, S_IROTH);
+        entry.canWrite = hasPermission(st, euid, groups, S_IWUSR, S_IWGRP, S_IWOTH);
+        entry.canExecute = hasPermission(st, euid, groups, S_IXUSR, S_IXGRP, S_IXOTH);
+    }
+}
+
+static void readDirectory(const QByteArray &dirPath, std::shared_ptr<LocalFileEnumeratorState> state)
+{
+    int dirfd = open(dirPath.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirfd < 0) {
+        QMutexLocker locker(&state->mutex);
+        state->done = true;
+        state->successed = false;
+        return;
+    }
+
+    uid_t euid = geteuid();
+    QVector<gid_t> groups;
+    groups<<getegid();
+    int groupCount = getgroups(0, nullptr);
+    if (groupCount > 0) {
+        QVector<gid_t> supplementaryGroups(groupCount);
+        groupCount = getgroups(groupCount, supplementaryGroups.data());
+        for (int i = 0; i < groupCount; i++) {
+            groups<<supplementaryGroups.at(i);
+        }
+    }
+
+    std::vector<char> buffer(PEONY_LOCAL_ENUMERATOR_BUFFER_SIZE);
+    bool hasEntries = false;
+    bool hasError = false;
+    while (!state->cancelled.load()) {
+        long nread = syscall(SYS_getdents64, dirfd, buffer.data(), buffer.size());
+        if (nread < 0) {
+            if (errno == EINTR)
+                continue;
+            qDebug()<<"getdents64 failed:"<<dirPath<<errno;
+            hasError = true;
+            break;
+        }
+        if (nread == 0)
+            break;
+
+        QVector<LocalFileEntry> batch;
+        for (long pos = 0; pos < nread;) {
+            auto dirent = reinterpret_cast<linux_dirent64 *>(buffer.data() + pos);
+            pos += dirent->d_reclen;
+            if (qstrcmp(dirent->d_name, ".") == 0 || qstrcmp(dirent->d_name, "..") == 0)
+                continue;
+
+            LocalFileEntry entry;
+            entry.name = dirent->d_name;
+            entry.dType = dirent->d_type;
+            batch<<entry;
+        }
+
+        if (batch.isEmpty())
+            continue;
+
+        QtConcurrent::blockingMap(batch, [&](LocalFileEntry &entry) {
+            statEntry(dirfd, dirPath, euid, groups, entry);
+        });
+
+        hasEntries = true;
+        QMutexLocker locker(&state->mutex);
+        state->batches<<batch;
+    }
+
+    close(dirfd);
+
+    QMutexLocker locker(&state->mutex);
+    state->done = true;
+    //the children already found can not be taken back, so a failure
+    //after that is treated as the end of directory.
+    state->successed = !state->cancelled.load() && (!hasError || hasEntries);
+}
+
+#endif
+
+LocalFileEnumerator::LocalFileEnumerator(GFile *dir, QObject *parent) : QObject(parent)
+{
+    char *path = g_file_get_path(dir);
+    m_path = path;
+    g_free(path);
+
+    m_state = std::make_shared<LocalFileEnumeratorState>();
+
+    m_fill_timer = new QTimer(this);
+    m_fill_timer->setInterval(PEONY_LOCAL_ENUMERATOR_POLL_INTERVAL);
+    connect(m_fill_timer, &QTimer::timeout, this, &LocalFileEnumerator::fillPendingChildren);
+}
+
+LocalFileEnumerator::~LocalFileEnumerator()
+{
+    cancel();
+}
+
+bool LocalFileEnumerator::isSupported(GFile *dir)
+{
+#ifdef PEONY_HAS_NATIVE_ENUMERATION
+    return dir && g_file_is_native(dir) && g_file_has_uri_scheme(dir, "file");
+#else
+    Q_UNUSED(dir);
+    return false;
+#endif
+}
+
+void LocalFileEnumerator::start()
+{
+#ifdef PEONY_HAS_NATIVE_ENUMERATION
+    auto path = m_path;
+    auto state = m_state;
+    QtConcurrent::run([=]() {
+        readDirectory(path, state);
+    });
+#else
+    m_state->done = true;
+    m_state->successed = false;
+#endif
+    m_fill_timer->start();
+}
+
+void LocalFileEnumerator::cancel()
+{
+    m_state->cancelled.store(1);
+    m_fill_timer->stop();
+}
+
+void LocalFileEnumerator::fillPendingChildren()
+{
+    QList<QVector<LocalFileEntry>> batches;
+    bool done = false;
+    bool successed = false;
+    m_state->mutex.lock();
+    int count = 0;
+    while (!m_state->batches.isEmpty() && count < PEONY_LOCAL_ENUMERATOR_FILL_SIZE) {
+        count += m_state->batches.first().count();
+        batches<<m_state->batches.takeFirst();
+    }
+    done = m_state->done && m_state->batches.isEmpty();
+    successed = m_state->successed;
+    //fill the rest in next event loop iteration if there is a backlog.
+    m_fill_timer->setInterval(m_state->batches.isEmpty()? PEONY_LOCAL_ENUMERATOR_POLL_INTERVAL: 0);
+    m_state->mutex.unlock();
+
+    QList<std::shared_ptr<FileInfo>> infos;
+    for (const auto &batch : batches) {
+        for (const auto &entry : batch) {
+            infos<<fillChildInfo(entry);
+        }
+    }
+
+    if (!infos.isEmpty())
+        Q_EMIT childrenFound(infos);
+
+    if (done) {
+        m_fill_timer->stop();
+        Q_EMIT finished(successed);
+    }
+}
+
+std::shared_ptr<FileInfo> LocalFileEnumerator::fillChildInfo(const LocalFileEntry &entry)
+{
+    auto info = FileInfo::fromUri(entry.uri);
+    //do not replace a complete info with a partial one,
+    //its holder keeps it up to date.
+    if (info->isLoaded())
+        return info;
+
+    QString oldDisplayName = info->m_display_name;
+    bool oldIsDir = info->isDir();
+
+    info->m_display_name = entry.displayName;
+    info->m_is_dir = entry.isDir;
+    info->m_is_symbol_link = entry.isSymlink;
+    info->m_can_read = entry.canRead;
+    info->m_can_write = entry.canWrite;
+    info->m_can_excute = entry.canExecute;
+
+    info->m_path = QString::fromUtf8(m_path.endsWith('/')? m_path + entry.name: m_path + '/' + entry.name);
+    info->m_content_type = entry.contentType;
+    info->m_mime_type_string = entry.contentType;
+    if (!entry.contentType.isEmpty()) {
+        auto attributes = MimeTypeCache::getInstance()->attributes(entry.contentType);
+        info->m_file_type = attributes.description;
+        //resolved lazily, see FileInfo::iconName().
+        info->m_themed_icon_names = attributes.iconNames;
+        info->m_themed_icon_names_pending = true;
+    }
+
+    if (entry.statted) {
+        info->m_file_id = QString("l%1:%2").arg(entry.device).arg(entry.inode);
+        info->m_size = entry.size;
+        info->m_modified_time = entry.modifiedTime;
+        info->m_access_time = entry.accessTime;
+    }
+
+    if (info->m_display_name != oldDisplayName || info->isDir() != oldIsDir)
+        info->m_name_serial++;
+
+    Q_EMIT info->updated();
+    return info;
+}
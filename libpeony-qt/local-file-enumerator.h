@@ -0,0 +1,132 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef LOCALFILEENUMERATOR_H
+#define LOCALFILEENUMERATOR_H
+
+#include "peony-core_global.h"
+
+#include <QObject>
+#include <memory>
+
+#include <gio/gio.h>
+
+class QTimer;
+
+namespace Peony {
+
+class FileInfo;
+struct LocalFileEnumeratorState;
+
+/*!
+ * \brief The LocalFileEntry struct
+ * <br>
+ * A directory entry read by LocalFileEnumerator. It is filled on
+ * worker threads and turned into FileInfo on the main thread.
+ * </br>
+ */
+struct LocalFileEntry {
+    QByteArray name;
+    unsigned char dType = 0;
+
+    QString uri;
+    QString displayName;
+    QString contentType;
+
+    bool statted = false;
+    bool isDir = false;
+    bool isSymlink = false;
+    bool canRead = true;
+    bool canWrite = false;
+    bool canExecute = false;
+
+    quint64 size = 0;
+    quint64 modifiedTime = 0;
+    quint64 accessTime = 0;
+    quint64 device = 0;
+    quint64 inode = 0;
+};
+
+/*!
+ * \brief The LocalFileEnumerator class
+ * <br>
+ * LocalFileEnumerator is the native backend of FileEnumerator for local directories.
+ * It reads the directory entries in large batches with getdents64 on a worker thread,
+ * and stats each batch with statx on the global thread pool. Only the fields views
+ * need are requested, and the entry type reported by the directory is used to skip
+ * the second stat of non-symlinks. The children infos are filled on main thread in
+ * small slices, so that a directory with hundreds thousands of files does not block
+ * the event loop.
+ * </br>
+ * \note
+ * The fast path can not answer everything gio does, such as metadata, the icon of
+ * special directories, desktop file names and the accurate access rights. The infos
+ * filled by this class are not loaded (see FileInfo::isLoaded()), the holder should
+ * complete them with FileInfoJob lazily, for example when they are shown.
+ * \see FileEnumerator::setAcceptPartialInfo().
+ */
+class LocalFileEnumerator : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LocalFileEnumerator(GFile *dir, QObject *parent = nullptr);
+    ~LocalFileEnumerator();
+
+    /*!
+     * \brief isSupported
+     * \param dir
+     * \return true if dir is a local directory and the native syscalls are available.
+     */
+    static bool isSupported(GFile *dir);
+
+    void start();
+
+public Q_SLOTS:
+    void cancel();
+
+Q_SIGNALS:
+    /*!
+     * \brief childrenFound
+     * \param infos, the filled infos of newly found children.
+     */
+    void childrenFound(const QList<std::shared_ptr<Peony::FileInfo>> &infos);
+    /*!
+     * \brief finished
+     * \param successed
+     * \retval false, if the directory could not be read natively,
+     * the caller should fall back to gio.
+     */
+    void finished(bool successed);
+
+protected:
+    void fillPendingChildren();
+    std::shared_ptr<FileInfo> fillChildInfo(const LocalFileEntry &entry);
+
+private:
+    QByteArray m_path;
+    std::shared_ptr<LocalFileEnumeratorState> m_state;
+    QTimer *m_fill_timer = nullptr;
+};
+
+}
+
+#endif // LOCALFILEENUMERATOR_H
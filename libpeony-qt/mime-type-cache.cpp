@@ -0,0 +1,127 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "mime-type-cache.h"
+#include "file-info.h"
+
+#include <QIcon>
+#include <QStringList>
+
+using namespace Peony;
+
+static MimeTypeCache *global_instance = nullptr;
+
+MimeTypeCache *MimeTypeCache::getInstance()
+{
+    if (!global_instance)
+        global_instance = new MimeTypeCache;
+    return global_instance;
+}
+
+const MimeTypeAttributes MimeTypeCache::attributes(const QString &contentType)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_attributes.constFind(contentType);
+    if (it != m_attributes.constEnd())
+        return it.value();
+
+    MimeTypeAttributes attributes;
+    auto type = contentType.toUtf8();
+
+    char *description = g_content_type_get_description(type.constData());
+    attributes.description = description;
+    g_free(description);
+
+    GIcon *g_icon = g_content_type_get_icon(type.constData());
+    attributes.iconNames = iconNames(g_icon);
+    if (g_icon)
+        g_object_unref(g_icon);
+
+    attributes.isVideo = contentType.startsWith("video")
+            || contentType.endsWith("vnd.trolltech.linguist")
+            || contentType.endsWith("vnd.adobe.flash.movie")
+            || contentType.endsWith("vnd.rn-realmedia")
+            || contentType.endsWith("vnd.ms-asf")
+            || contentType.endsWith("octet-stream");
+
+    for (int idx = 0; qstrcmp(office_mime_types[idx], "end") != 0; idx++) {
+        if (contentType.contains(office_mime_types[idx])) {
+            attributes.isOffice = true;
+            break;
+        }
+    }
+
+    m_attributes.insert(contentType, attributes);
+    return attributes;
+}
+
+QStringList MimeTypeCache::iconNames(GIcon *icon)
+{
+    QStringList names;
+    if (!G_IS_THEMED_ICON(icon))
+        return names;
+
+    const gchar* const* icon_names = g_themed_icon_get_names(G_THEMED_ICON(icon));
+    for (auto p = icon_names; p && *p; p++)
+        names<<*p;
+    return names;
+}
+
+const QString MimeTypeCache::themeIconName(const QStringList &iconNames)
+{
+    if (iconNames.isEmpty())
+        return QString();
+
+    checkIconTheme();
+    QString key = iconNames.join(';');
+    auto it = m_icon_names.constFind(key);
+    if (it != m_icon_names.constEnd())
+        return it.value();
+
+    QString iconName;
+    for (auto name : iconNames) {
+        if (!QIcon::fromTheme(name).isNull()) {
+            iconName = name;
+            break;
+        }
+    }
+    m_icon_names.insert(key, iconName);
+    return iconName;
+}
+
+void MimeTypeCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_attributes.clear();
+    m_icon_names.clear();
+}
+
+void MimeTypeCache::checkIconTheme()
+{
+    //the resolved icon names are only valid for the theme they were resolved in.
+    QString iconTheme = QIcon::themeName();
+    if (iconTheme == m_icon_theme)
+        return;
+
+    m_icon_theme = iconTheme;
+    m_icon_names.clear();
+}
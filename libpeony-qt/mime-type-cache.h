@@ -0,0 +1,114 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef MIMETYPECACHE_H
+#define MIMETYPECACHE_H
+
+#include "peony-core_global.h"
+
+#include <gio/gio.h>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QMutex>
+
+namespace Peony {
+
+/*!
+ * \brief The MimeTypeAttributes struct
+ * <br>
+ * The attributes which only depend on the content type of a file.
+ * iconNames are the names of content type's themed icon, they are not
+ * resolved in icon theme, see MimeTypeCache::themeIconName().
+ * </br>
+ */
+struct MimeTypeAttributes {
+    QString description;
+    QStringList iconNames;
+    bool isVideo = false;
+    bool isOffice = false;
+};
+
+/*!
+ * \brief The MimeTypeCache class
+ * <br>
+ * MimeTypeCache is a process-wide cache of the attributes of content types.
+ * A directory usually holds thousands of files but only a few content types,
+ * querying the description and resolving the icon of every file is a waste.
+ * FileInfoJob, LocalFileEnumerator and FileInfo look these attributes up here.
+ * </br>
+ * <br>
+ * Resolving an icon name depends on the current icon theme, the icon names
+ * are resolved again once the theme is changed.
+ * </br>
+ * \note
+ * attributes() and iconNames() are thread safe. themeIconName() uses QIcon,
+ * it must be called in ui thread.
+ */
+class PEONYCORESHARED_EXPORT MimeTypeCache
+{
+public:
+    static MimeTypeCache *getInstance();
+
+    /*!
+     * \brief attributes
+     * \param contentType
+     * \return the attributes of contentType, they are queried at the first time.
+     */
+    const MimeTypeAttributes attributes(const QString &contentType);
+
+    /*!
+     * \brief iconNames
+     * \param icon, a themed icon, such as the icon of a GFileInfo.
+     * \return the names of icon, or an empty list if it is not a themed icon.
+     */
+    static QStringList iconNames(GIcon *icon);
+
+    /*!
+     * \brief themeIconName
+     * \param iconNames
+     * \return the first name of iconNames that current icon theme has, or an empty string.
+     * \note the names of a file's icon are usually the same as its content type's,
+     * but not always, e.g. special directories, so they are cached by the names list.
+     * This must be called in ui thread.
+     */
+    const QString themeIconName(const QStringList &iconNames);
+
+    void clear();
+
+private:
+    MimeTypeCache() {}
+    ~MimeTypeCache() {}
+
+    void checkIconTheme();
+
+    QMutex m_mutex;
+    QHash<QString, MimeTypeAttributes> m_attributes;
+
+    //only used in ui thread.
+    QString m_icon_theme;
+    QHash<QString, QString> m_icon_names;
+};
+
+}
+
+#endif // MIMETYPECACHE_H
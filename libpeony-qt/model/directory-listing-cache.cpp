@@ -0,0 +1,108 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "directory-listing-cache.h"
+#include "file-info.h"
+
+
+#ifndef PEONY_DIRECTORY_LISTING_CACHE_SIZE
+#define PEONY_DIRECTORY_LISTING_CACHE_SIZE 8
+#endif
+
+#ifndef PEONY_DIRECTORY_LISTING_CACHE_MAX_CHILDREN
+#define PEONY_DIRECTORY_LISTING_CACHE_MAX_CHILDREN 200000
+#endif
+
+using namespace Peony;
+
+static DirectoryListingCache *global_instance = nullptr;
+
+DirectoryListingCache *DirectoryListingCache::getInstance()
+{
+    if (!global_instance)
+        global_instance = new DirectoryListingCache;
+    return global_instance;
+}
+
+bool DirectoryListingCache::isCacheable(const QString &uri)
+{
+    return uri.startsWith("file://");
+}
+
+bool DirectoryListingCache::isListingValid(const DirectoryListing &listing, quint64 currentModifiedTime)
+{
+    if (listing.modifiedTime == 0 || listing.modifiedTime != currentModifiedTime)
+        return false;
+
+    return listing.snapshotTime > qint64(listing.modifiedTime);
+}
+
+void DirectoryListingCache::insertListing(const QString &uri, const DirectoryListing &listing)
+{
+    removeListing(uri);
+
+    //a listing larger than whole cache would evict everything else.
+    if (listing.infos.count() > PEONY_DIRECTORY_LISTING_CACHE_MAX_CHILDREN)
+        return;
+
+    m_listings.insert(uri, listing);
+    m_lru_uris.append(uri);
+    m_total_children += listing.infos.count();
+
+    trim();
+}
+
+bool DirectoryListingCache::findListing(const QString &uri, DirectoryListing &listing)
+{
+    if (!m_listings.contains(uri))
+        return false;
+
+    listing = m_listings.value(uri);
+    m_lru_uris.removeOne(uri);
+    m_lru_uris.append(uri);
+    return true;
+}
+
+void DirectoryListingCache::removeListing(const QString &uri)
+{
+    if (!m_listings.contains(uri))
+        return;
+
+    m_total_children -= m_listings.take(uri).infos.count();
+    m_lru_uris.removeOne(uri);
+}
+
+void DirectoryListingCache::clear()
+{
+    m_listings.clear();
+    m_lru_uris.clear();
+    m_total_children = 0;
+}
+
+void DirectoryListingCache::trim()
+{
+    while (!m_lru_uris.isEmpty() &&
+           (m_lru_uris.count() > PEONY_DIRECTORY_LISTING_CACHE_SIZE ||
+            m_total_children > PEONY_DIRECTORY_LISTING_CACHE_MAX_CHILDREN)) {
+        removeListing(m_lru_uris.first());
+    }
+}
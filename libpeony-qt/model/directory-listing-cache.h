@@ -0,0 +1,110 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef DIRECTORYLISTINGCACHE_H
+#define DIRECTORYLISTINGCACHE_H
+
+#include "peony-core_global.h"
+
+#include <QHash>
+#include <QList>
+#include <QStringList>
+#include <memory>
+
+namespace Peony {
+
+class FileInfo;
+
+/*!
+ * \brief The DirectoryListing struct
+ * <br>
+ * A snapshot of a directory's children. modifiedTime is the directory's
+ * modified time when the listing was loaded, and snapshotTime is the time
+ * it was read at, both in seconds since epoch.
+ * </br>
+ */
+struct DirectoryListing {
+    QList<std::shared_ptr<FileInfo>> infos;
+    quint64 modifiedTime = 0;
+    qint64 snapshotTime = 0;
+};
+
+/*!
+ * \brief The DirectoryListingCache class
+ * <br>
+ * DirectoryListingCache keeps the children infos of recently viewed directories,
+ * so that going back, forward or re-entering a directory can show its children
+ * immediately instead of enumerating it from scratch. The cache is bounded by
+ * the count of directories and the total count of children, the least recently
+ * used listings are dropped first.
+ * </br>
+ * <br>
+ * A cached listing is only a hint. The holder should revalidate it against the
+ * current modified time of directory, see isListingValid(), and apply the diff
+ * of a new enumeration if it is not valid any more.
+ * </br>
+ * \note
+ * This class is not thread safe, use it in main thread only.
+ * \see FileItem::loadChildrenFromCache().
+ */
+class PEONYCORESHARED_EXPORT DirectoryListingCache
+{
+public:
+    static DirectoryListingCache *getInstance();
+
+    /*!
+     * \brief isCacheable
+     * \param uri
+     * \return true if the listing of uri could be cached.
+     * \note only local directories are cached for now, the modified time
+     * of remote directories is not reliable enough for revalidation.
+     */
+    static bool isCacheable(const QString &uri);
+
+    /*!
+     * \brief isListingValid
+     * \param listing
+     * \param currentModifiedTime
+     * \return true if the children of directory have not been changed since the listing was taken.
+     * \note the modified time is in seconds, a listing taken in the same second the directory
+     * was modified might miss later changes in that second, it is never considered valid.
+     */
+    static bool isListingValid(const DirectoryListing &listing, quint64 currentModifiedTime);
+
+    void insertListing(const QString &uri, const DirectoryListing &listing);
+    bool findListing(const QString &uri, DirectoryListing &listing);
+    void removeListing(const QString &uri);
+    void clear();
+
+private:
+    DirectoryListingCache() {}
+    void trim();
+
+    QHash<QString, DirectoryListing> m_listings;
+    //least recently used first.
+    QStringList m_lru_uris;
+    int m_total_children = 0;
+};
+
+}
+
+#endif // DIRECTORYLISTINGCACHE_H
@@ -32,6 +32,7 @@
 #include "file-utils.h"
 
 #include "thumbnail-manager.h"
+#include "file-watcher.h"
 
 #include "file-operation-utils.h"
 
@@ -48,6 +49,29 @@ using namespace Peony;
 FileItemModel::FileItemModel(QObject *parent) : QAbstractItemModel (parent)
 {
     setPositiveResponse(true);
+
+    //the watcher only identifies the requests of this model.
+    m_thumbnail_watcher = std::make_shared<FileWatcher>("thumbnail://");
+    connect(ThumbnailManager::getInstance(), &ThumbnailManager::thumbnailReady, this, [=](const QString &uri){
+        auto index = indexFromUri(uri);
+        if (index.isValid()) {
+            auto item = itemFromIndex(index);
+            if (item) {
+                /*!
+                  \note
+                  fix the probabilistic jamming while thumbnailing with list view.
+
+                  we have to only trigger first column index dataChanged signal,
+                  otherwise there will be probility stucked whole program.
+
+                  i'm not sure if it is a bug of qtreeview.
+                  */
+
+                //dataChanged(item->firstColumnIndex(), item->lastColumnIndex());
+                Q_EMIT dataChanged(item->firstColumnIndex(), item->firstColumnIndex());
+            }
+        }
+    });
 }
 
 FileItemModel::~FileItemModel()
@@ -109,59 +133,31 @@ FileItem *FileItemModel::itemFromIndex(const QModelIndex &index) const
 
 QModelIndex FileItemModel::firstColumnIndex(FileItem *item)
 {
-    //root children
-    if (item->m_parent == nullptr) {
-        for (int i = 0; i < m_root_item->m_children->count(); i++) {
-            //qDebug()<<i<<item->m_info->uri()<<m_root_item->m_children->at(i)->m_info->uri();
-            if (item == m_root_item->m_children->at(i)) {
-                //qDebug()<<i<<item->m_info->uri();
-                return createIndex(i, 0, item);
-            }
-        }
+    //root children has root item as parent, and root item itself has no parent.
+    FileItem *parentItem = item->m_parent? item->m_parent: m_root_item;
+    int row = parentItem->rowOfChild(item);
+    if (row < 0)
         return QModelIndex();
-    } else {
-        //has parent item
-        for (int i = 0; i < item->m_parent->m_children->count(); i++) {
-            if (item == item->m_parent->m_children->at(i))
-                return createIndex(i, 0, item);
-        }
-        return QModelIndex();
-    }
+    return createIndex(row, 0, item);
 }
 
 QModelIndex FileItemModel::lastColumnIndex(FileItem *item)
 {
-    if (!item->m_parent) {
-        for (int i = 0; i < m_root_item->m_children->count(); i++) {
-            //qDebug()<<i<<item->m_info->uri()<<m_root_item->m_children->at(i)->m_info->uri();
-            if (item == m_root_item->m_children->at(i)) {
-                //qDebug()<<i<<item->m_info->uri();
-                return createIndex(i, Other, item);
-            }
-        }
-        return QModelIndex();
-    } else {
-        //has parent item
-        for (int i = 0; i < item->m_parent->m_children->count(); i++) {
-            if (item == item->m_parent->m_children->at(i))
-                return createIndex(i, Other, item);
-        }
+    FileItem *parentItem = item->m_parent? item->m_parent: m_root_item;
+    int row = parentItem->rowOfChild(item);
+    if (row < 0)
         return QModelIndex();
-    }
+    return createIndex(row, Other, item);
 }
 
 const QModelIndex FileItemModel::indexFromUri(const QString &uri)
 {
     //FIXME: support recursively finding?
-    for (auto child : *m_root_item->m_children) {
-        GFile *left = g_file_new_for_uri(child->uri().toUtf8().constData());
-        GFile *right = g_file_new_for_uri(uri.toUtf8().constData());
-        bool equal = g_file_equal(left, right);
-        g_object_unref(left);
-        g_object_unref(right);
-        if (equal) {
-            return child->firstColumnIndex();
-        }
+    if (!m_root_item)
+        return QModelIndex();
+    auto child = m_root_item->getChildFromUri(uri);
+    if (child) {
+        return child->firstColumnIndex();
     }
     return QModelIndex();
 }
@@ -217,10 +213,16 @@ QVariant FileItemModel::data(const QModelIndex &index, int role) const
             return QVariant(item->m_info->displayName());
         }
         case Qt::DecorationRole: {
+            //the item is being shown, complete its info if it was filled partially.
+            item->loadInfoLazily();
             auto thumbnail = ThumbnailManager::getInstance()->tryGetThumbnail(item->m_info->uri());
             if (!thumbnail.isNull()) {
                 return thumbnail;
             }
+            //the thumbnail was evicted from memory, load it again since it is shown.
+            if (ThumbnailManager::getInstance()->takeEvictedThumbnail(item->m_info->uri())) {
+                ThumbnailManager::getInstance()->createThumbnail(item->m_info->uri(), m_thumbnail_watcher);
+            }
             QIcon icon = QIcon::fromTheme(item->m_info->iconName(), QIcon::fromTheme("text-x-generic"));
             return QVariant(icon);
         }
@@ -26,9 +26,12 @@
 #include <QAbstractItemModel>
 #include "peony-core_global.h"
 
+#include <memory>
+
 namespace Peony {
 
 class FileItem;
+class FileWatcher;
 class FileItemProxyFilterSortModel;
 
 /*!
@@ -140,6 +143,13 @@ public:
      */
     QModelIndex lastColumnIndex(FileItem *item);
 
+    /*!
+     * \brief indexFromUri
+     * \param uri
+     * \return the first column index of root item's child which has the uri.
+     * \note this is a constant time lookup in root item's uri index,
+     * see FileItem::getChildFromUri().
+     */
     const QModelIndex indexFromUri(const QString &uri);
 
     QModelIndex index(int row, int column, const QModelIndex &parent) const override;
@@ -265,6 +275,17 @@ public Q_SLOTS:
 
 private:
     FileItem *m_root_item = nullptr;
+
+    /*!
+     * \brief m_thumbnail_watcher
+     * <br>
+     * The only thumbnail notification channel of this model. Every item passes it
+     * to ThumbnailManager, and the model dispatches the thumbnail changed event to
+     * the crosponding index by uri.
+     * </br>
+     */
+    std::shared_ptr<FileWatcher> m_thumbnail_watcher;
+
     bool m_is_positive = false;
     bool m_can_expand = false;
 };
@@ -39,12 +39,40 @@
 
 #include <QLocale>
 #include <QCollator>
+#include <QRegularExpression>
+#include <QtConcurrent>
+
+#ifndef PEONY_PARALLEL_SORT_KEYS_THRESHOLD
+#define PEONY_PARALLEL_SORT_KEYS_THRESHOLD 2000
+#endif
 
 using namespace Peony;
 
 QLocale locale = QLocale(QLocale::system().name());
 QCollator comparer = QCollator(locale);
 
+void FileItemProxyFilterSortModel::computeSortKeys(FileItem::SortKeys &keys, bool withCollatorKey)
+{
+    static const QRegularExpression duplicatedSuffix("\\((\\d+)\\)");
+
+    keys.caseFoldedName = keys.displayName.toLower();
+
+    keys.duplicateBaseName = keys.displayName;
+    keys.duplicateBaseName.remove(duplicatedSuffix);
+
+    keys.duplicateNumber = 0;
+    auto it = duplicatedSuffix.globalMatch(keys.displayName);
+    while (it.hasNext()) {
+        keys.duplicateNumber = it.next().captured(1).toInt();
+    }
+
+    if (withCollatorKey) {
+        keys.collatorKey = std::make_shared<QCollatorSortKey>(comparer.sortKey(keys.displayName));
+    } else {
+        keys.collatorKey = nullptr;
+    }
+}
+
 FileItemProxyFilterSortModel::FileItemProxyFilterSortModel(QObject *parent) : QSortFilterProxyModel(parent)
 {
     //enable number sort, like 100 is after 99
@@ -83,6 +111,67 @@ const QModelIndex FileItemProxyFilterSortModel::indexFromUri(const QString &uri)
     return mapFromSource(sourceIndex);
 }
 
+void FileItemProxyFilterSortModel::sort(int column, Qt::SortOrder order)
+{
+    if (column == FileItemModel::FileName)
+        prepareSortKeys();
+    QSortFilterProxyModel::sort(column, order);
+}
+
+void FileItemProxyFilterSortModel::prepareSortKeys()
+{
+    FileItemModel *model = static_cast<FileItemModel*>(sourceModel());
+    if (!model || !model->m_root_item)
+        return;
+
+    bool withCollatorKey = m_use_default_name_sort_order;
+    QVector<FileItem *> staleItems;
+    for (auto item : *model->m_root_item->m_children) {
+        auto &keys = item->m_sort_keys;
+        if (keys.valid && keys.nameSerial == item->m_info->nameSerial()
+                && (!withCollatorKey || keys.collatorKey)) {
+            continue;
+        }
+        //FileInfo::displayName() might query mounts, do not call it in worker threads.
+        keys.valid = true;
+        keys.nameSerial = item->m_info->nameSerial();
+        keys.isFolder = item->hasChildren();
+        keys.displayName = item->m_info->displayName();
+        staleItems<<item;
+    }
+
+    if (staleItems.count() < PEONY_PARALLEL_SORT_KEYS_THRESHOLD) {
+        for (auto item : staleItems) {
+            computeSortKeys(item->m_sort_keys, withCollatorKey);
+        }
+        return;
+    }
+
+    //make sure the shared collator is initialized before using it in other threads.
+    if (withCollatorKey)
+        comparer.sortKey(QString());
+
+    QtConcurrent::blockingMap(staleItems, [withCollatorKey](FileItem *item) {
+        computeSortKeys(item->m_sort_keys, withCollatorKey);
+    });
+}
+
+void FileItemProxyFilterSortModel::updateSortKeys(FileItem *item) const
+{
+    bool withCollatorKey = m_use_default_name_sort_order;
+    auto &keys = item->m_sort_keys;
+    if (keys.valid && keys.nameSerial == item->m_info->nameSerial()
+            && (!withCollatorKey || keys.collatorKey)) {
+        return;
+    }
+
+    keys.valid = true;
+    keys.nameSerial = item->m_info->nameSerial();
+    keys.isFolder = item->hasChildren();
+    keys.displayName = item->m_info->displayName();
+    computeSortKeys(keys, withCollatorKey);
+}
+
 bool FileItemProxyFilterSortModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
 {
     //comment these improve code to fix disorder issue
@@ -103,13 +192,17 @@ bool FileItemProxyFilterSortModel::lessThan(const QModelIndex &left, const QMode
         FileItemModel *model = static_cast<FileItemModel*>(sourceModel());
         auto leftItem = model->itemFromIndex(left);
         auto rightItem = model->itemFromIndex(right);
-        if (!(leftItem->hasChildren() && rightItem->hasChildren())) {
+        updateSortKeys(leftItem);
+        updateSortKeys(rightItem);
+        const auto &leftKeys = leftItem->m_sort_keys;
+        const auto &rightKeys = rightItem->m_sort_keys;
+        if (!(leftKeys.isFolder && rightKeys.isFolder)) {
             //make folder always has a higher order.
-            if (!leftItem->hasChildren() && !rightItem->hasChildren()) {
+            if (!leftKeys.isFolder && !rightKeys.isFolder) {
                 goto default_sort;
             }
             if (m_folder_first) {
-                bool lesser = leftItem->hasChildren();
+                bool lesser = leftKeys.isFolder;
                 if (sortOrder() == Qt::AscendingOrder)
                     return lesser;
                 return !lesser;
@@ -119,15 +212,17 @@ bool FileItemProxyFilterSortModel::lessThan(const QModelIndex &left, const QMode
 default_sort:
         switch (sortColumn()) {
         case FileItemModel::FileName: {
-            if (FileOperationUtils::leftNameIsDuplicatedFileOfRightName(leftItem->m_info->displayName(), rightItem->m_info->displayName())) {
-                return FileOperationUtils::leftNameLesserThanRightName(leftItem->info()->displayName(), rightItem->info()->displayName());
+            //same as FileOperationUtils::leftNameIsDuplicatedFileOfRightName()
+            //and FileOperationUtils::leftNameLesserThanRightName(), but use cached keys.
+            if (leftKeys.duplicateBaseName == rightKeys.duplicateBaseName) {
+                if (leftKeys.duplicateNumber == rightKeys.duplicateNumber)
+                    return leftKeys.displayName < rightKeys.displayName;
+                return leftKeys.duplicateNumber < rightKeys.duplicateNumber;
             }
             if (m_use_default_name_sort_order) {
-                QString leftDisplayName = leftItem->m_info->displayName();
-                QString rightDisplayName = rightItem->m_info->displayName();
-                return comparer.compare(leftDisplayName, rightDisplayName) < 0;
+                return leftKeys.collatorKey->compare(*rightKeys.collatorKey) < 0;
             }
-            return leftItem->m_info->displayName().toLower() < rightItem->m_info->displayName().toLower();
+            return leftKeys.caseFoldedName < rightKeys.caseFoldedName;
         }
         case FileItemModel::FileSize: {
             return leftItem->m_info->size() < rightItem->m_info->size();
@@ -510,6 +605,9 @@ bool FileItemProxyFilterSortModel::checkFileSizeOrTypeFilter(quint64 size, bool
 
 void FileItemProxyFilterSortModel::update()
 {
+    //invalidating filter will sort again.
+    if (sortColumn() == FileItemModel::FileName)
+        prepareSortKeys();
     invalidateFilter();
 }
 
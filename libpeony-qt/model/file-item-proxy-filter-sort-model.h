@@ -29,10 +29,10 @@
 #include <QColor>
 
 #include "peony-core_global.h"
+#include "file-item.h"
 
 namespace Peony {
 
-class FileItem;
 class FileItemModel;
 
 class PEONYCORESHARED_EXPORT FileItemProxyFilterSortModel : public QSortFilterProxyModel
@@ -104,6 +104,16 @@ public:
     QStringList getAllFileUris();
     QModelIndexList getAllFileIndexes();
 
+    /*!
+     * \brief sort
+     * <br>
+     * Prepare the name sort keys of children before sorting. For a large directory
+     * the keys are computed in parallel, then lessThan() only compares the cached keys.
+     * </br>
+     * \see prepareSortKeys().
+     */
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
 public Q_SLOTS:
     void update();
 
@@ -119,6 +129,33 @@ private:
     bool checkFileSizeOrTypeFilter(quint64 sizem, bool isDir) const;
     bool checkFileNameFilter(const QString &displayName) const;
 
+    /*!
+     * \brief prepareSortKeys
+     * <br>
+     * Update the out of date sort keys of root item's children. The display names
+     * are fetched in main thread, and the other keys are computed with QtConcurrent
+     * when there are many items.
+     * </br>
+     */
+    void prepareSortKeys();
+    /*!
+     * \brief updateSortKeys
+     * \param item
+     * <br>
+     * Update the sort keys of item if they are out of date. This is used in lessThan()
+     * for the items which were not prepared, such as newly inserted or expanded ones.
+     * </br>
+     */
+    void updateSortKeys(FileItem *item) const;
+    /*!
+     * \brief computeSortKeys
+     * compute the keys derived from keys.displayName.
+     * \note this is reentrant, so it can be run in worker threads.
+     * \see FileOperationUtils::leftNameIsDuplicatedFileOfRightName(),
+     * FileOperationUtils::leftNameLesserThanRightName().
+     */
+    static void computeSortKeys(FileItem::SortKeys &keys, bool withCollatorKey);
+
 private:
     bool m_show_hidden;
     bool m_use_default_name_sort_order;
@@ -29,6 +29,7 @@
 #include "file-operation-utils.h"
 
 #include "file-item-model.h"
+#include "directory-listing-cache.h"
 
 #include "thumbnail-manager.h"
 
@@ -42,10 +43,21 @@
 #include <QMessageBox>
 #include <QUrl>
 #include <QTimer>
+#include <QSet>
+#include <QDateTime>
 #include <KWindowSystem>
 
 #include <QApplication>
 
+#ifndef PEONY_CHILDREN_INSERTION_INTERVAL
+//about one frame.
+#define PEONY_CHILDREN_INSERTION_INTERVAL 16
+#endif
+
+#ifndef PEONY_CHILDREN_INSERTION_BATCH_SIZE
+#define PEONY_CHILDREN_INSERTION_BATCH_SIZE 500
+#endif
+
 using namespace Peony;
 
 FileItem::FileItem(std::shared_ptr<Peony::FileInfo> info, FileItem *parentItem, FileItemModel *model, QObject *parent) : QObject(parent)
@@ -56,30 +68,6 @@ FileItem::FileItem(std::shared_ptr<Peony::FileInfo> info, FileItem *parentItem,
 
     m_model = model;
 
-    m_backend_enumerator = new FileEnumerator(this);
-
-    m_thumbnail_watcher = std::make_shared<Peony::FileWatcher>("thumbnail://");
-    connect(m_thumbnail_watcher.get(), &FileWatcher::fileChanged, this, [=](const QString &uri){
-        auto index = m_model->indexFromUri(uri);
-        if (index.isValid()) {
-            auto item = m_model->itemFromIndex(index);
-            if (item) {
-                /*!
-                  \note
-                  fix the probabilistic jamming while thumbnailing with list view.
-
-                  we have to only trigger first column index dataChanged signal,
-                  otherwise there will be probility stucked whole program.
-
-                  i'm not sure if it is a bug of qtreeview.
-                  */
-
-                //m_model->dataChanged(item->firstColumnIndex(), item->lastColumnIndex());
-                m_model->dataChanged(item->firstColumnIndex(), item->firstColumnIndex());
-            }
-        }
-    });
-
     // avoid call any method when model is deleted.
     setParent(m_model);
 }
@@ -90,10 +78,29 @@ FileItem::~FileItem()
     Q_EMIT cancelFindChildren();
     //disconnect();
 
+    //the pending thumbnail of a removed row is not needed any more.
+    if (m_parent && m_model)
+        ThumbnailManager::getInstance()->cancelThumbnail(m_info->uri(), thumbnailWatcher());
+
+    //keep the listing of root for going back or re-entering.
+    if (!m_parent && m_children_loaded && DirectoryListingCache::isCacheable(m_info->uri())) {
+        DirectoryListing listing;
+        for (auto child : *m_children) {
+            listing.infos<<child->m_info;
+        }
+        listing.modifiedTime = m_listing_modified_time;
+        listing.snapshotTime = m_listing_time;
+        DirectoryListingCache::getInstance()->insertListing(m_info->uri(), listing);
+    }
+
     for (auto child : *m_children) {
         delete child;
     }
     m_children->clear();
+    m_children_index.clear();
+
+    qDeleteAll(m_pending_children);
+    m_pending_children.clear();
 
     delete m_children;
 }
@@ -114,11 +121,14 @@ QVector<FileItem*> *FileItem::findChildrenSync()
     Q_EMIT m_model->findChildrenStarted();
     std::shared_ptr<Peony::FileEnumerator> enumerator = std::make_shared<Peony::FileEnumerator>();
     enumerator->setEnumerateDirectory(m_info->uri());
+    enumerator->setEnumerateWithInfoJob();
     enumerator->enumerateSync();
     auto infos = enumerator->getChildren();
     for (auto info : infos) {
         FileItem *child = new FileItem(info, this, m_model);
-        m_children->append(child);
+        appendChild(child);
+        if (!info->isEmptyInfo())
+            continue;
         FileInfoJob *job = new FileInfoJob(info);
         job->setAutoDelete();
         job->querySync();
@@ -133,6 +143,17 @@ void FileItem::findChildrenAsync()
     auto info = FileInfo::fromUri(m_info.get()->uri());
     auto infoJob = new FileInfoJob(info);
     infoJob->setAutoDelete();
+
+    bool cacheable = !m_expanded && m_model->isPositiveResponse() && !m_parent && DirectoryListingCache::isCacheable(m_info->uri());
+    if (cacheable) {
+        //take the time before the modified time, see DirectoryListingCache::isListingValid().
+        m_listing_time = QDateTime::currentMSecsSinceEpoch()/1000;
+        m_listing_modified_time = 0;
+        //the modified time comes with the info, do not query it in ui thread.
+        connect(infoJob, &FileInfoJob::queryAsyncFinished, this, [=](bool successed) {
+            onListingModifiedTimeQueried(successed? info->modifiedTime(): 0);
+        });
+    }
     infoJob->queryAsync();
 
     if (m_expanded)
@@ -140,8 +161,17 @@ void FileItem::findChildrenAsync()
 
     Q_EMIT m_model->findChildrenStarted();
     m_expanded = true;
+
+    if (cacheable && loadChildrenFromCache())
+        return;
+
     Peony::FileEnumerator *enumerator = new Peony::FileEnumerator;
     enumerator->setEnumerateDirectory(m_info->uri());
+    //children infos are filled by enumerator directly, we only need query
+    //the infos which enumerator could not fill.
+    enumerator->setEnumerateWithInfoJob();
+    //local children might be filled partially, see loadInfoLazily().
+    enumerator->setAcceptPartialInfo();
     //NOTE: entry a new root might destroyed the current enumeration work.
     //the root item will be delete, so we should cancel the previous enumeration.
     enumerator->connect(this, &FileItem::cancelFindChildren, enumerator, &FileEnumerator::cancel);
@@ -237,14 +267,24 @@ void FileItem::findChildrenAsync()
         enumerator->connect(enumerator, &Peony::FileEnumerator::enumerateFinished, this, [=](bool successed) {
             if (successed) {
                 auto infos = enumerator->getChildren();
-                m_async_count = infos.count();
-                if (infos.count() == 0) {
-                    Q_EMIT m_model->findChildrenFinished();
-                }
+                auto onChildrenReady = [=]() {
+                    if (!m_children->isEmpty())
+                        m_model->insertRows(0, m_children->count(), this->firstColumnIndex());
+                    Q_EMIT this->m_model->findChildrenFinished();
+                    Q_EMIT m_model->updated();
+                    for (auto info : infos) {
+                        ThumbnailManager::getInstance()->createThumbnail(info->uri(), thumbnailWatcher());
+                    }
+                };
 
+                m_async_count = 0;
                 for (auto info : infos) {
                     FileItem *child = new FileItem(info, this, m_model);
-                    m_children->prepend(child);
+                    prependChild(child);
+                    if (!info->isEmptyInfo())
+                        continue;
+
+                    m_async_count++;
                     FileInfoJob *job = new FileInfoJob(info);
                     job->setAutoDelete();
                     /*
@@ -260,12 +300,7 @@ void FileItem::findChildrenAsync()
                         //whatever info was updated, we need decrease the async count.
                         m_async_count--;
                         if (m_async_count == 0) {
-                            m_model->insertRows(0, m_children->count(), this->firstColumnIndex());
-                            Q_EMIT this->m_model->findChildrenFinished();
-                            Q_EMIT m_model->updated();
-                            for (auto info : infos) {
-                                ThumbnailManager::getInstance()->createThumbnail(info->uri(), m_thumbnail_watcher);
-                            }
+                            onChildrenReady();
                         }
                     });
 
@@ -275,6 +310,11 @@ void FileItem::findChildrenAsync()
 
                     job->queryAsync();
                 }
+
+                //all the children infos were filled by enumerator.
+                if (m_async_count == 0) {
+                    onChildrenReady();
+                }
             } else {
                 //qDebug() << "enumerateFinished false" <<successed;
                 Q_EMIT m_model->findChildrenFinished();
@@ -314,10 +354,10 @@ void FileItem::findChildrenAsync()
                     connect(infoJob, &FileInfoJob::queryAsyncFinished, this, [=]() {
                         m_model->dataChanged(m_model->indexFromUri(uri), m_model->indexFromUri(uri));
                         auto info = FileInfo::fromUri(uri);
-                        ThumbnailManager::getInstance()->createThumbnail(uri, m_thumbnail_watcher, true);
+                        ThumbnailManager::getInstance()->createThumbnail(uri, thumbnailWatcher(), true);
                         /*
                         if (info->isDesktopFile()) {
-                            ThumbnailManager::getInstance()->updateDesktopFileThumbnail(info->uri(), m_thumbnail_watcher);
+                            ThumbnailManager::getInstance()->updateDesktopFileThumbnail(info->uri(), thumbnailWatcher());
                         }
                         */
                     });
@@ -364,26 +404,47 @@ void FileItem::findChildrenAsync()
                 return ;
             }
 
+            QList<std::shared_ptr<FileInfo>> readyInfos;
+            QStringList queryUris;
+            for (auto uri : uris) {
+                auto info = FileInfo::fromUri(uri);
+                if (info->isEmptyInfo()) {
+                    queryUris<<uri;
+                } else {
+                    readyInfos<<info;
+                }
+            }
+
             if (isEnding) {
-                m_ending_uris.clear();
-                m_ending_uris = uris;
+                m_ending_uris = queryUris.toSet();
             }
-            for (auto uri : uris) {
+
+            //the infos filled by enumerator are ready, insert them with
+            //the staged children as one range.
+            if (!readyInfos.isEmpty()) {
+                for (auto info : readyInfos) {
+                    queueChildInsertion(new FileItem(info, this, m_model));
+                    ThumbnailManager::getInstance()->createThumbnail(info->uri(), thumbnailWatcher());
+                }
+                flushPendingChildren();
+                if (isEnding && m_ending_uris.isEmpty()) {
+                    Q_EMIT m_model->findChildrenFinished();
+                    Q_EMIT m_model->updated();
+                }
+            }
+
+            for (auto uri : queryUris) {
                 auto info = FileInfo::fromUri(uri);
                 auto infoJob = new FileInfoJob(info);
                 infoJob->setAutoDelete();
                 infoJob->connect(infoJob, &FileInfoJob::infoUpdated, this, [=]() {
-                    auto item = new FileItem(info, this, m_model);
-                    m_model->beginInsertRows(firstColumnIndex(), m_children->count(), m_children->count());
-                    m_children->append(item);
-                    m_model->endInsertRows();
-                    //Q_EMIT m_model->dataChanged(item->firstColumnIndex(), item->lastColumnIndex());
-                    //Q_EMIT m_model->updated();
-                    ThumbnailManager::getInstance()->createThumbnail(info->uri(), m_thumbnail_watcher);
-
-                    m_ending_uris.removeOne(uri);
+                    queueChildInsertion(new FileItem(info, this, m_model));
+                    ThumbnailManager::getInstance()->createThumbnail(info->uri(), thumbnailWatcher());
+
+                    m_ending_uris.remove(uri);
                     if (isEnding && m_ending_uris.isEmpty()) {
-                        //qApp->processEvents();
+                        //make sure all the children are in model before finished.
+                        flushPendingChildren();
                         Q_EMIT m_model->findChildrenFinished();
                         Q_EMIT m_model->updated();
                     }
@@ -403,72 +464,130 @@ void FileItem::findChildrenAsync()
             if (!m_model||!m_children||!m_info)
                 return;
 
-            m_watcher = std::make_shared<FileWatcher>(this->m_info->uri());
-            m_watcher->setMonitorChildrenChange(true);
-            connect(m_watcher.get(), &FileWatcher::fileCreated, this, [=](QString uri) {
-                //add new item to m_children
-                //tell the model update
-                this->onChildAdded(uri);
-                Q_EMIT this->childAdded(uri);
-                qDebug() << "positive onChildAdded:" <<uri;
-                ThumbnailManager::getInstance()->createThumbnail(uri, m_thumbnail_watcher);
-            });
-            connect(m_watcher.get(), &FileWatcher::fileDeleted, this, [=](QString uri) {
-                //check bookmark and delete
-                auto info = FileInfo::fromUri(uri);
-                if (info->isDir())
-                {
-                    BookMarkManager::getInstance()->removeBookMark(uri);
-                }
-                //remove the crosponding child
-                //tell the model update
-                this->onChildRemoved(uri);
-                Q_EMIT this->childRemoved(uri);
-                qDebug() << "childRemoved:" <<uri;
-                ThumbnailManager::getInstance()->releaseThumbnail(uri);
-            });
-            connect(m_watcher.get(), &FileWatcher::fileChanged, this, [=](const QString &uri) {
-                auto index = m_model->indexFromUri(uri);
-                if (index.isValid()) {
-                    auto infoJob = new FileInfoJob(FileInfo::fromUri(index.data(FileItemModel::UriRole).toString()));
-                    infoJob->setAutoDelete();
-                    connect(infoJob, &FileInfoJob::queryAsyncFinished, this, [=]() {
-                        m_model->dataChanged(m_model->indexFromUri(uri), m_model->indexFromUri(uri));
-                        auto info = FileInfo::fromUri(uri);
-                        if (info->isDesktopFile()) {
-                            ThumbnailManager::getInstance()->updateDesktopFileThumbnail(info->uri(), m_watcher);
-                        }
-                    });
-                    infoJob->queryAsync();
-                }
-            });
-            connect(m_watcher.get(), &FileWatcher::thumbnailUpdated, this, [=](const QString &uri) {
-                m_model->dataChanged(m_model->indexFromUri(uri), m_model->indexFromUri(uri));
-            });
-            connect(m_watcher.get(), &FileWatcher::directoryDeleted, this, [=](QString uri) {
-                //clean all the children, if item index is root index, cd up.
-                //this might use FileItemModel::setRootItem()
-                Q_EMIT this->deleted(uri);
-                this->onDeleted(uri);
-            });
-            connect(m_watcher.get(), &FileWatcher::locationChanged, this, [=](QString oldUri, QString newUri) {
-                //this might use FileItemModel::setRootItem()
-                Q_EMIT this->renamed(oldUri, newUri);
-                this->onRenamed(oldUri, newUri);
-            });
-
-            connect(m_watcher.get(), &FileWatcher::directoryUnmounted, this, [=]() {
-                m_model->setRootUri("computer:///");
-            });
-            //qDebug()<<"startMonitor";
-            connect(m_watcher.get(), &FileWatcher::requestUpdateDirectory, this, &FileItem::onUpdateDirectoryRequest);
-            m_watcher->startMonitor();
+            m_children_loaded = true;
+            setupChildrenWatcher();
         });
     }
 
     enumerator->prepare();
 }
 
+bool FileItem::loadChildrenFromCache()
+{
+    auto cache = DirectoryListingCache::getInstance();
+    DirectoryListing listing;
+    if (!cache->findListing(m_info->uri(), listing))
+        return false;
+
+    for (auto info : listing.infos) {
+        auto child = new FileItem(info, this, m_model);
+        //the attributes of children might be changed while we were away.
+        child->m_info_may_be_stale = true;
+        queueChildInsertion(child);
+    }
+    flushPendingChildren();
+    m_children_loaded = true;
+    Q_EMIT m_model->findChildrenFinished();
+    Q_EMIT m_model->updated();
+
+    for (auto info : listing.infos) {
+        ThumbnailManager::getInstance()->createThumbnail(info->uri(), thumbnailWatcher());
+    }
+
+    setupChildrenWatcher();
+
+    //the listing is shown optimistically, it is revalidated once
+    //the modified time of directory was queried.
+    m_cached_listing_modified_time = listing.modifiedTime;
+    m_cached_listing_snapshot_time = listing.snapshotTime;
+    m_cached_listing_unvalidated = true;
+
+    return true;
+}
+
+void FileItem::onListingModifiedTimeQueried(quint64 modifiedTime)
+{
+    m_listing_modified_time = modifiedTime;
+    if (!m_cached_listing_unvalidated)
+        return;
+    m_cached_listing_unvalidated = false;
+
+    DirectoryListing listing;
+    listing.modifiedTime = m_cached_listing_modified_time;
+    listing.snapshotTime = m_cached_listing_snapshot_time;
+    if (!DirectoryListingCache::isListingValid(listing, modifiedTime)) {
+        //children were created or deleted, or the directory could not be accessed now,
+        //apply the diff of a new enumeration.
+        //the diff is async, so do not trust this listing next time.
+        m_listing_modified_time = 0;
+        onUpdateDirectoryRequest();
+    }
+}
+
+void FileItem::setupChildrenWatcher()
+{
+    m_watcher = std::make_shared<FileWatcher>(this->m_info->uri());
+    m_watcher->setMonitorChildrenChange(true);
+    connect(m_watcher.get(), &FileWatcher::fileCreated, this, [=](QString uri) {
+        //add new item to m_children
+        //tell the model update
+        this->onChildAdded(uri);
+        Q_EMIT this->childAdded(uri);
+        qDebug() << "positive onChildAdded:" <<uri;
+        ThumbnailManager::getInstance()->createThumbnail(uri, thumbnailWatcher());
+    });
+    connect(m_watcher.get(), &FileWatcher::fileDeleted, this, [=](QString uri) {
+        //check bookmark and delete
+        auto info = FileInfo::fromUri(uri);
+        if (info->isDir())
+        {
+            BookMarkManager::getInstance()->removeBookMark(uri);
+        }
+        //remove the crosponding child
+        //tell the model update
+        this->onChildRemoved(uri);
+        Q_EMIT this->childRemoved(uri);
+        qDebug() << "childRemoved:" <<uri;
+        ThumbnailManager::getInstance()->releaseThumbnail(uri);
+    });
+    connect(m_watcher.get(), &FileWatcher::fileChanged, this, [=](const QString &uri) {
+        auto index = m_model->indexFromUri(uri);
+        if (index.isValid()) {
+            auto infoJob = new FileInfoJob(FileInfo::fromUri(index.data(FileItemModel::UriRole).toString()));
+            infoJob->setAutoDelete();
+            connect(infoJob, &FileInfoJob::queryAsyncFinished, this, [=]() {
+                m_model->dataChanged(m_model->indexFromUri(uri), m_model->indexFromUri(uri));
+                auto info = FileInfo::fromUri(uri);
+                if (info->isDesktopFile()) {
+                    ThumbnailManager::getInstance()->updateDesktopFileThumbnail(info->uri(), m_watcher);
+                }
+            });
+            infoJob->queryAsync();
+        }
+    });
+    connect(m_watcher.get(), &FileWatcher::thumbnailUpdated, this, [=](const QString &uri) {
+        m_model->dataChanged(m_model->indexFromUri(uri), m_model->indexFromUri(uri));
+    });
+    connect(m_watcher.get(), &FileWatcher::directoryDeleted, this, [=](QString uri) {
+        //clean all the children, if item index is root index, cd up.
+        //this might use FileItemModel::setRootItem()
+        Q_EMIT this->deleted(uri);
+        this->onDeleted(uri);
+    });
+    connect(m_watcher.get(), &FileWatcher::locationChanged, this, [=](QString oldUri, QString newUri) {
+        //this might use FileItemModel::setRootItem()
+        Q_EMIT this->renamed(oldUri, newUri);
+        this->onRenamed(oldUri, newUri);
+    });
+
+    connect(m_watcher.get(), &FileWatcher::directoryUnmounted, this, [=]() {
+        m_model->setRootUri("computer:///");
+    });
+    //qDebug()<<"startMonitor";
+    connect(m_watcher.get(), &FileWatcher::requestUpdateDirectory, this, &FileItem::onUpdateDirectoryRequest);
+    m_watcher->startMonitor();
+}
+
 QModelIndex FileItem::firstColumnIndex()
 {
     return m_model->firstColumnIndex(this);
@@ -487,14 +606,103 @@ bool FileItem::hasChildren()
 
 FileItem *FileItem::getChildFromUri(QString uri)
 {
-    for (auto item : *m_children) {
-        QUrl itemUrl = item->uri();
-        QUrl url = uri;
-        QString decodedUri = url.toDisplayString();
-        if (decodedUri == itemUrl.toDisplayString())
-            return item;
+    return m_children_index.value(normalizedUri(uri));
+}
+
+int FileItem::rowOfChild(FileItem *child)
+{
+    if (!child || child->m_parent != this)
+        return -1;
+
+    if (m_rows_dirty) {
+        for (int i = 0; i < m_children->count(); i++) {
+            m_children->at(i)->m_row = i;
+        }
+        m_rows_dirty = false;
+    }
+
+    int row = child->m_row;
+    if (row < 0 || row >= m_children->count() || m_children->at(row) != child) {
+        //should not happen, but do not trust a broken cache.
+        row = m_children->indexOf(child);
+        child->m_row = row;
+    }
+    return row;
+}
+
+void FileItem::appendChild(FileItem *child)
+{
+    child->m_row = m_children->count();
+    child->m_normalized_uri = normalizedUri(child->uri());
+    m_children->append(child);
+    m_children_index.insert(child->m_normalized_uri, child);
+}
+
+void FileItem::prependChild(FileItem *child)
+{
+    child->m_normalized_uri = normalizedUri(child->uri());
+    m_children->prepend(child);
+    m_children_index.insert(child->m_normalized_uri, child);
+    m_rows_dirty = true;
+}
+
+void FileItem::removeChild(FileItem *child)
+{
+    int row = rowOfChild(child);
+    if (row < 0)
+        return;
+
+    m_children->remove(row);
+    if (m_children_index.value(child->m_normalized_uri) == child)
+        m_children_index.remove(child->m_normalized_uri);
+    child->m_row = -1;
+
+    //rows after the removed one are shifted.
+    if (row != m_children->count())
+        m_rows_dirty = true;
+}
+
+std::shared_ptr<FileWatcher> FileItem::thumbnailWatcher()
+{
+    if (!m_model)
+        return nullptr;
+    return m_model->m_thumbnail_watcher;
+}
+
+QString FileItem::normalizedUri(const QString &uri)
+{
+    QUrl url = uri;
+    return url.toDisplayString(QUrl::StripTrailingSlash);
+}
+
+void FileItem::queueChildInsertion(FileItem *child)
+{
+    if (m_pending_children.isEmpty()) {
+        QTimer::singleShot(PEONY_CHILDREN_INSERTION_INTERVAL, this, &FileItem::flushPendingChildren);
+    }
+
+    child->m_normalized_uri = normalizedUri(child->uri());
+    m_pending_children.append(child);
+    if (m_pending_children.count() >= PEONY_CHILDREN_INSERTION_BATCH_SIZE) {
+        flushPendingChildren();
     }
-    return nullptr;
+}
+
+void FileItem::flushPendingChildren()
+{
+    if (m_pending_children.isEmpty())
+        return;
+
+    int row = m_children->count();
+    m_model->beginInsertRows(firstColumnIndex(), row, row + m_pending_children.count() - 1);
+    for (auto child : m_pending_children) {
+        appendChild(child);
+        //the child is visible in model now, duplicated created event
+        //will be handled by getChildFromUri().
+        m_waiting_add_queue.remove(child->uri());
+    }
+    m_pending_children.clear();
+    m_model->endInsertRows();
 }
 
 void FileItem::onChildAdded(const QString &uri)
@@ -519,18 +727,18 @@ void FileItem::onChildAdded(const QString &uri)
     auto info = FileInfo::fromUri(uri);
     auto infoJob = new FileInfoJob(info);
     infoJob->setAutoDelete();
-    m_waiting_add_queue.append(uri);
+    m_waiting_add_queue.insert(uri);
+    infoJob->connect(infoJob, &FileInfoJob::queryAsyncFinished, this, [=](bool successed) {
+        //a failed query never stages the child, do not block the later created event.
+        if (!successed)
+            m_waiting_add_queue.remove(uri);
+    });
     infoJob->connect(infoJob, &FileInfoJob::infoUpdated, this, [=]() {
-        auto item = new FileItem(info, this, m_model);
-        m_model->beginInsertRows(firstColumnIndex(), m_children->count(), m_children->count());
-        m_children->append(item);
-        m_model->endInsertRows();
-        qDebug() <<"successfully added child:" <<uri;
-        m_waiting_add_queue.removeOne(uri);
-        //Q_EMIT m_model->dataChanged(item->firstColumnIndex(), item->lastColumnIndex());
-        //Q_EMIT m_model->updated();
+        //uri is kept in m_waiting_add_queue until the staged child is inserted.
+        queueChildInsertion(new FileItem(info, this, m_model));
+        qDebug() <<"successfully queued child:" <<uri;
         QTimer::singleShot(1000, this, [=](){
-            ThumbnailManager::getInstance()->createThumbnail(info->uri(), m_thumbnail_watcher);
+            ThumbnailManager::getInstance()->createThumbnail(info->uri(), thumbnailWatcher());
         });
     });
     infoJob->queryAsync();
@@ -546,11 +754,23 @@ void FileItem::onChildAdded(const QString &uri)
 
 void FileItem::onChildRemoved(const QString &uri)
 {
+    //the child might be deleted before its staged insertion.
+    auto normalized = normalizedUri(uri);
+    for (int i = 0; i < m_pending_children.count(); i++) {
+        auto pendingChild = m_pending_children.at(i);
+        if (pendingChild->m_normalized_uri == normalized) {
+            m_pending_children.remove(i);
+            m_waiting_add_queue.remove(pendingChild->uri());
+            delete pendingChild;
+            break;
+        }
+    }
+
     FileItem *child = getChildFromUri(uri);
     if (child) {
-        int index = m_children->indexOf(child);
+        int index = rowOfChild(child);
         m_model->beginRemoveRows(this->firstColumnIndex(), index, index);
-        m_children->removeOne(child);
+        removeChild(child);
         qDebug() <<"successfully removed child:" <<uri;
         delete child;
         m_model->endRemoveRows();
@@ -570,17 +790,19 @@ void FileItem::onDeleted(const QString &thisUri)
     //doublue clicked twice it will be expanded. a qt's bug?
     if (m_parent) {
         if (m_parent->m_info->uri() == thisUri) {
-            m_model->removeRow(m_parent->m_children->indexOf(this), m_parent->firstColumnIndex());
-            m_parent->m_children->removeOne(this);
+            m_model->removeRow(m_parent->rowOfChild(this), m_parent->firstColumnIndex());
+            m_parent->removeChild(this);
         } else {
             //if just clear children, there will be a small problem.
             clearChildren();
-            m_model->removeRow(m_parent->m_children->indexOf(this), m_parent->firstColumnIndex());
-            m_parent->m_children->removeOne(this);
+            m_model->removeRow(m_parent->rowOfChild(this), m_parent->firstColumnIndex());
+            m_parent->removeChild(this);
             m_parent->onChildAdded(m_info->uri());
         }
         this->deleteLater();
     } else {
+        //do not cache the listing of a deleted directory.
+        m_children_loaded = false;
         //cd up.
         auto tmpItem = this;
         auto tmpUri = FileUtils::getParentUri(tmpItem->uri());
@@ -616,28 +838,25 @@ void FileItem::onUpdateDirectoryRequest()
             return;
 
         auto currentUris = enumerator->getChildrenUris();
-        QStringList rawUris;
+        QSet<QString> currentUriSet = currentUris.toSet();
+        QSet<QString> rawUris;
         QStringList removedUris;
-        QStringList addedUris;
 
         for (auto child : *m_model->m_root_item->m_children) {
             rawUris<<child->uri();
-            if (!currentUris.contains(child->uri())) {
+            if (!currentUriSet.contains(child->uri())) {
                 removedUris<<child->uri();
-                m_model->m_root_item->onChildRemoved(child->uri());
             }
         }
 
-        for (auto uri : currentUris) {
-            if (!rawUris.contains(uri)) {
-                addedUris<<uri;
-                m_model->m_root_item->onChildAdded(uri);
-            }
+        //do not modify children while iterating them.
+        for (auto uri : removedUris) {
+            m_model->m_root_item->onChildRemoved(uri);
         }
 
         for (auto uri : currentUris) {
-            if (!addedUris.contains(uri) && !removedUris.contains(uri)) {
-                //m_model->m_root_item->getChildFromUri(uri)->updateInfoAsync();
+            if (!rawUris.contains(uri)) {
+                m_model->m_root_item->onChildAdded(uri);
             }
         }
 
@@ -652,7 +871,7 @@ void FileItem::updateInfoSync()
     FileInfoJob *job = new FileInfoJob(m_info);
     if (job->querySync()) {
         m_model->dataChanged(this->firstColumnIndex(), this->lastColumnIndex());
-        ThumbnailManager::getInstance()->createThumbnail(this->uri(), m_thumbnail_watcher, true);
+        ThumbnailManager::getInstance()->createThumbnail(this->uri(), thumbnailWatcher(), true);
     }
     job->deleteLater();
 }
@@ -663,7 +882,25 @@ void FileItem::updateInfoAsync()
     job->setAutoDelete();
     job->connect(job, &FileInfoJob::infoUpdated, this, [=]() {
         m_model->dataChanged(this->firstColumnIndex(), this->lastColumnIndex());
-        ThumbnailManager::getInstance()->createThumbnail(this->uri(), m_thumbnail_watcher, true);
+        ThumbnailManager::getInstance()->createThumbnail(this->uri(), thumbnailWatcher(), true);
+    });
+    job->queryAsync();
+}
+
+void FileItem::loadInfoLazily()
+{
+    if (m_lazy_info_requested)
+        return;
+
+    if (!m_info_may_be_stale && (m_info->isLoaded() || m_info->isEmptyInfo()))
+        return;
+
+    //only try once, even if the query failed.
+    m_lazy_info_requested = true;
+    FileInfoJob *job = new FileInfoJob(m_info);
+    job->setAutoDelete();
+    job->connect(job, &FileInfoJob::infoUpdated, this, [=]() {
+        m_model->dataChanged(this->firstColumnIndex(), this->lastColumnIndex());
     });
     job->queryAsync();
 }
@@ -676,6 +913,12 @@ void FileItem::clearChildren()
         delete child;
     }
     m_children->clear();
+    m_children_index.clear();
+    m_rows_dirty = false;
+    m_children_loaded = false;
+    qDeleteAll(m_pending_children);
+    m_pending_children.clear();
+    m_waiting_add_queue.clear();
     m_expanded = false;
     m_watcher.reset();
     m_watcher = nullptr;
@@ -28,6 +28,9 @@
 
 #include <QObject>
 #include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QCollatorSortKey>
 
 namespace Peony {
 
@@ -121,6 +124,63 @@ protected:
      */
     FileItem *getChildFromUri(QString uri);
 
+    /*!
+     * \brief rowOfChild
+     * \param child
+     * \return the row of child in m_children, or -1 if child is not a child of this item.
+     * \note
+     * Every child caches its row, the cache is rebuilt lazily once after the children
+     * were prepended or removed from the middle, so the lookup is constant time
+     * in most cases.
+     */
+    int rowOfChild(FileItem *child);
+
+    /*!
+     * \brief appendChild
+     * \param child
+     * \note
+     * Always use appendChild(), prependChild() and removeChild() to modify m_children,
+     * otherwise the uri index and row cache will be out of date.
+     * \see getChildFromUri(), rowOfChild().
+     */
+    void appendChild(FileItem *child);
+    void prependChild(FileItem *child);
+    void removeChild(FileItem *child);
+
+    /*!
+     * \brief normalizedUri
+     * \param uri
+     * \return the decoded uri without trailing slash, which is used as key of uri index.
+     */
+    static QString normalizedUri(const QString &uri);
+
+    /*!
+     * \brief thumbnailWatcher
+     * \return the thumbnail notification channel shared by all items of the model.
+     */
+    std::shared_ptr<FileWatcher> thumbnailWatcher();
+
+    /*!
+     * \brief queueChildInsertion
+     * \param child
+     * <br>
+     * Stage a new child whose info is ready. The staged children are inserted
+     * into model as one contiguous range, either after one frame or once
+     * there are enough of them, so that a large directory or a burst of
+     * created files does not cause a row insertion per child.
+     * </br>
+     * \see flushPendingChildren().
+     */
+    void queueChildInsertion(FileItem *child);
+    /*!
+     * \brief flushPendingChildren
+     * <br>
+     * Insert all the staged children immediately. Call this before telling
+     * the model that children finding is finished.
+     * </br>
+     */
+    void flushPendingChildren();
+
     /*!
      * \brief updateInfoSync
      * <br>
@@ -141,20 +201,122 @@ protected:
      */
     void updateInfoAsync();
 
+    /*!
+     * \brief loadInfoLazily
+     * <br>
+     * Complete the info which is filled partially by a fast path enumerator,
+     * this is called when the item is going to be shown.
+     * </br>
+     * \see FileInfo::isLoaded(), FileEnumerator::setAcceptPartialInfo().
+     */
+    void loadInfoLazily();
+
+    /*!
+     * \brief loadChildrenFromCache
+     * \return true if the children were loaded from DirectoryListingCache.
+     * <br>
+     * The cached children are shown immediately and monitored as usual. If the
+     * directory turns out to be modified after the listing was taken, a new
+     * enumeration is started and its diff is applied, see onListingModifiedTimeQueried(). The children infos are refreshed lazily
+     * when they are shown.
+     * </br>
+     * \see DirectoryListingCache.
+     */
+    bool loadChildrenFromCache();
+    /*!
+     * \brief onListingModifiedTimeQueried
+     * \param modifiedTime, 0 if the directory could not be accessed.
+     * <br>
+     * The modified time is taken from the async info query of the directory. The
+     * listing loaded from cache is revalidated here, and the time is kept for the
+     * listing cached when the item is deleted.
+     * </br>
+     */
+    void onListingModifiedTimeQueried(quint64 modifiedTime);
+    /*!
+     * \brief setupChildrenWatcher
+     * start monitoring the children changes after the children were found.
+     */
+    void setupChildrenWatcher();
+
 private:
+    /*!
+     * \brief The SortKeys struct
+     * <br>
+     * The keys FileItemProxyFilterSortModel::lessThan() compares, computed
+     * from the display name once instead of in every comparison.
+     * They are out of date once the info's name serial changed.
+     * </br>
+     * \see FileInfo::nameSerial(), FileItemProxyFilterSortModel::prepareSortKeys().
+     */
+    struct SortKeys {
+        bool valid = false;
+        quint32 nameSerial = 0;
+        bool isFolder = false;
+        QString displayName;
+        QString caseFoldedName;
+        //display name without any "(n)" suffix, and the number of last suffix.
+        QString duplicateBaseName;
+        int duplicateNumber = 0;
+        //only computed when sort by QCollator.
+        std::shared_ptr<QCollatorSortKey> collatorKey;
+    };
+
     FileItem *m_parent = nullptr;
     std::shared_ptr<Peony::FileInfo> m_info;
     QVector<FileItem*> *m_children = nullptr;
 
+    /*!
+     * \brief m_children_index
+     * normalized uri to child item, see normalizedUri().
+     */
+    QHash<QString, FileItem*> m_children_index;
+    QString m_normalized_uri;
+
+    /*!
+     * \brief m_row
+     * cached row of this item in parent's children,
+     * it is only valid when parent's m_rows_dirty is false.
+     */
+    int m_row = -1;
+    bool m_rows_dirty = false;
+
+    SortKeys m_sort_keys;
+
     FileItemModel *m_model = nullptr;
 
     bool m_expanded = false;
+    bool m_lazy_info_requested = false;
+    bool m_info_may_be_stale = false;
+
+    /*!
+     * \brief m_children_loaded
+     * true if all the children were found, the listing of a root item
+     * is kept in DirectoryListingCache when it is deleted.
+     */
+    bool m_children_loaded = false;
+    quint64 m_listing_modified_time = 0;
+    qint64 m_listing_time = 0;
+
+    /*!
+     * \brief m_cached_listing_unvalidated
+     * true if the children were loaded from cache and the modified time
+     * of directory is not queried yet.
+     */
+    bool m_cached_listing_unvalidated = false;
+    quint64 m_cached_listing_modified_time = 0;
+    qint64 m_cached_listing_snapshot_time = 0;
 
     std::shared_ptr<FileWatcher> m_watcher = nullptr;
-    std::shared_ptr<FileWatcher> m_thumbnail_watcher = nullptr;
 
-    QStringList m_ending_uris;
-    QStringList m_waiting_add_queue;
+    QSet<QString> m_ending_uris;
+    QSet<QString> m_waiting_add_queue;
+
+    /*!
+     * \brief m_pending_children
+     * children staged by queueChildInsertion() but not inserted into m_children yet.
+     */
+    QVector<FileItem*> m_pending_children;
 
 
     /*!
@@ -166,13 +328,6 @@ private:
      * </br>
      */
     int m_async_count = 0;
-
-    /*!
-     * \brief m_backend_enumerator
-     * \note
-     * only used in directory not support monitor.
-     */
-    FileEnumerator *m_backend_enumerator;
 };
 
 }
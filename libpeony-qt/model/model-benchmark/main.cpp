@@ -0,0 +1,171 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2019, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+/*!
+ * model-benchmark
+ * <br>
+ * A headless benchmark of FileItemModel lookups. For every entry count passed
+ * in arguments, it creates a temporary directory with that many files, loads it
+ * into a FileItemModel and measures the average cost of indexFromUri(),
+ * FileItem::firstColumnIndex() and of removing children one by one.
+ * The cost per operation should not grow with the entry count.
+ * </br>
+ * usage: model-benchmark [count ...], default counts are 1000 10000 50000.
+ */
+
+#include <QApplication>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QEventLoop>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QUrl>
+#include <QTextStream>
+
+#include "file-info.h"
+#include "file-item.h"
+#include "file-item-model.h"
+
+static QStringList createEntries(const QString &path, int count)
+{
+    QStringList uris;
+    for (int i = 0; i < count; i++) {
+        QString fileName = QString("%1/file-%2.txt").arg(path).arg(i);
+        QFile file(fileName);
+        file.open(QIODevice::WriteOnly);
+        file.close();
+        uris<<QUrl::fromLocalFile(fileName).toString();
+    }
+    return uris;
+}
+
+static bool waitForRows(Peony::FileItemModel *model, int count)
+{
+    QEventLoop loop;
+    auto check = [=, &loop]() {
+        if (model->rowCount(QModelIndex()) >= count)
+            loop.quit();
+    };
+    QObject::connect(model, &Peony::FileItemModel::rowsInserted, &loop, check);
+    QObject::connect(model, &Peony::FileItemModel::findChildrenFinished, &loop, check);
+    QTimer::singleShot(120000, &loop, &QEventLoop::quit);
+    loop.exec();
+    return model->rowCount(QModelIndex()) >= count;
+}
+
+static double nsPerOp(qint64 ns, int count)
+{
+    return count > 0? double(ns)/count: 0;
+}
+
+static bool runBenchmark(int count, QTextStream &out)
+{
+    QTemporaryDir dir;
+    if (!dir.isValid())
+        return false;
+
+    auto uris = createEntries(dir.path(), count);
+    auto rootUri = QUrl::fromLocalFile(dir.path()).toString();
+
+    Peony::FileItemModel model;
+    auto rootItem = new Peony::FileItem(Peony::FileInfo::fromUri(rootUri), nullptr, &model, &model);
+    model.setRootItem(rootItem);
+    if (!waitForRows(&model, count)) {
+        out<<"loading "<<count<<" entries timeout"<<endl;
+        return false;
+    }
+
+    QElapsedTimer timer;
+    int found = 0;
+
+    timer.start();
+    for (auto uri : uris) {
+        if (model.indexFromUri(uri).isValid())
+            found++;
+    }
+    qint64 uriLookupCost = timer.nsecsElapsed();
+
+    QList<Peony::FileItem *> items;
+    for (int row = 0; row < model.rowCount(QModelIndex()); row++) {
+        items<<model.itemFromIndex(model.index(row, 0, QModelIndex()));
+    }
+
+    timer.restart();
+    for (auto item : items) {
+        item->firstColumnIndex();
+    }
+    qint64 rowLookupCost = timer.nsecsElapsed();
+
+    //simulate a watcher storm, remove every 10th child then look up the rest.
+    int removed = 0;
+    timer.restart();
+    for (int i = 0; i < uris.count(); i += 10) {
+        rootItem->onChildRemoved(uris.at(i));
+        removed++;
+    }
+    qint64 removeCost = timer.nsecsElapsed();
+
+    timer.restart();
+    for (auto uri : uris) {
+        model.indexFromUri(uri);
+    }
+    qint64 relookupCost = timer.nsecsElapsed();
+
+    out<<qSetFieldWidth(12)<<count
+       <<found
+       <<nsPerOp(uriLookupCost, uris.count())
+       <<nsPerOp(rowLookupCost, items.count())
+       <<nsPerOp(removeCost, removed)
+       <<nsPerOp(relookupCost, uris.count())
+       <<qSetFieldWidth(0)<<endl;
+
+    return found == count;
+}
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication a(argc, argv);
+
+    QList<int> counts;
+    for (auto arg : a.arguments().mid(1)) {
+        bool ok = false;
+        int count = arg.toInt(&ok);
+        if (ok && count > 0)
+            counts<<count;
+    }
+    if (counts.isEmpty())
+        counts<<1000<<10000<<50000;
+
+    QTextStream out(stdout);
+    out<<"ns per operation"<<endl;
+    out<<qSetFieldWidth(12)<<"entries"<<"found"<<"uri->index"<<"item->row"<<"remove"<<"re-lookup"<<qSetFieldWidth(0)<<endl;
+
+    bool successed = true;
+    for (auto count : counts) {
+        successed &= runBenchmark(count, out);
+    }
+
+    return successed? 0: 1;
+}
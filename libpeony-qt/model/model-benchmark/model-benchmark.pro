@@ -0,0 +1,23 @@
+#-------------------------------------------------
+#
+# Headless benchmark of FileItemModel.
+#
+#-------------------------------------------------
+
+QT       += core gui widgets
+
+TARGET = model-benchmark
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+CONFIG += link_pkgconfig no_keywords c++11 console
+CONFIG -= app_bundle
+PKGCONFIG += glib-2.0 gio-2.0
+
+include(../../libpeony-qt-header.pri)
+
+LIBS += -L$$PWD/../../ -lpeony
+
+SOURCES += \
+        main.cpp
@@ -5,6 +5,7 @@ INCLUDEPATH += $$PWD
 HEADERS += \
     $$PWD/file-item.h \
     $$PWD/file-item-model.h \
+    $$PWD/directory-listing-cache.h \
     $$PWD/file-item-proxy-filter-sort-model.h \
     $$PWD/file-label-model.h \
     $$PWD/side-bar-abstract-item.h \
@@ -21,6 +22,7 @@ HEADERS += \
 SOURCES += \
     $$PWD/file-item.cpp \
     $$PWD/file-item-model.cpp \
+    $$PWD/directory-listing-cache.cpp \
     $$PWD/file-item-proxy-filter-sort-model.cpp \
     $$PWD/file-label-model.cpp \
     $$PWD/side-bar-abstract-item.cpp \
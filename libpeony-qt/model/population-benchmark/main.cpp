@@ -0,0 +1,344 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+/*!
+ * population-benchmark
+ * <br>
+ * A headless end to end benchmark of directory loading. For every entry count it
+ * generates a synthetic tree, then measures these scenarios:
+ * enumerator: FileEnumerator with info job over every directory of the tree.
+ * model: FileItemModel loading the top level directory.
+ * proxy: same as model, with a FileItemProxyFilterSortModel sorted by name.
+ * </br>
+ * <br>
+ * Every run prints one JSON object per line on stdout, with time to first row,
+ * time to complete, peak RSS and allocations per entry. The allocations are the
+ * count of malloc family calls of the whole process, including worker threads.
+ * With --baseline, the best time to complete of each scenario is compared with
+ * the best one of the same scenario in a previous output, the exit code is 2 if
+ * any of them is slower than the baseline more than --tolerance.
+ * </br>
+ * usage: population-benchmark --entries 1000,10000,100000,1000000 --depth 1 --names short
+ */
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QTemporaryDir>
+#include <QDir>
+#include <QFile>
+#include <QEventLoop>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QTextStream>
+#include <QHash>
+
+#include "file-info.h"
+#include "file-enumerator.h"
+#include "file-item.h"
+#include "file-item-model.h"
+#include "file-item-proxy-filter-sort-model.h"
+#include "directory-listing-cache.h"
+
+#include "synthetic-tree.h"
+#include "benchmark-utils.h"
+
+#include <atomic>
+#include <functional>
+
+#if defined(__GLIBC__)
+#define PEONY_BENCHMARK_COUNT_ALLOCATIONS
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+}
+
+static std::atomic<quint64> global_allocations(0);
+
+extern "C" void *malloc(size_t size) __THROW
+{
+    global_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size) __THROW
+{
+    global_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size) __THROW
+{
+    if (!ptr)
+        global_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+#endif
+
+struct RunResult {
+    qint64 firstRowNs = -1;
+    qint64 completeNs = -1;
+    int rows = 0;
+    bool successed = false;
+};
+
+static quint64 allocationCount()
+{
+#ifdef PEONY_BENCHMARK_COUNT_ALLOCATIONS
+    return global_allocations.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
+
+static void cleanUp()
+{
+    //the listing of root is cached when its item is deleted.
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    Peony::DirectoryListingCache::getInstance()->clear();
+}
+
+static RunResult runEnumerator(const SyntheticTree &tree, bool fastPath, int timeout)
+{
+    RunResult result;
+    QElapsedTimer timer;
+    QEventLoop loop;
+    QTimer guard;
+    guard.setSingleShot(true);
+    QObject::connect(&guard, &QTimer::timeout, &loop, &QEventLoop::quit);
+
+    QStringList pendingUris;
+    pendingUris<<tree.rootUri();
+
+    timer.start();
+    while (!pendingUris.isEmpty()) {
+        auto enumerator = new Peony::FileEnumerator;
+        enumerator->setEnumerateDirectory(pendingUris.takeFirst());
+        enumerator->setEnumerateWithInfoJob();
+        enumerator->setAcceptPartialInfo(fastPath);
+
+        bool successed = false;
+        QObject::connect(enumerator, &Peony::FileEnumerator::childrenUpdated, &loop, [&](const QStringList &uris) {
+            if (!uris.isEmpty() && result.firstRowNs < 0)
+                result.firstRowNs = timer.nsecsElapsed();
+        });
+        QObject::connect(enumerator, &Peony::FileEnumerator::enumerateFinished, &loop, [&](bool finished) {
+            successed = finished;
+            loop.quit();
+        });
+
+        guard.start(timeout);
+        enumerator->enumerateAsync();
+        loop.exec();
+
+        if (!successed) {
+            delete enumerator;
+            return result;
+        }
+
+        for (auto info : enumerator->getChildren()) {
+            result.rows++;
+            if (info->isDir())
+                pendingUris<<info->uri();
+        }
+        delete enumerator;
+    }
+    result.completeNs = timer.nsecsElapsed();
+    result.successed = result.rows == tree.totalEntries();
+    return result;
+}
+
+static RunResult runModel(const SyntheticTree &tree, bool withProxy, int timeout)
+{
+    RunResult result;
+    Peony::FileItemModel model;
+    Peony::FileItemProxyFilterSortModel proxy;
+    QAbstractItemModel *target = &model;
+    if (withProxy) {
+        proxy.setSourceModel(&model);
+        proxy.sort(Peony::FileItemModel::FileName);
+        target = &proxy;
+    }
+
+    QElapsedTimer timer;
+    QEventLoop loop;
+    bool finished = false;
+    int expected = tree.topLevelEntries();
+    auto check = [&]() {
+        int rows = target->rowCount(QModelIndex());
+        if (rows > 0 && result.firstRowNs < 0)
+            result.firstRowNs = timer.nsecsElapsed();
+        if (finished && rows >= expected)
+            loop.quit();
+    };
+    QObject::connect(target, &QAbstractItemModel::rowsInserted, &loop, check);
+    QObject::connect(&model, &Peony::FileItemModel::findChildrenFinished, &loop, [&]() {
+        finished = true;
+        check();
+    });
+    QTimer::singleShot(timeout, &loop, &QEventLoop::quit);
+
+    timer.start();
+    model.setRootUri(tree.rootUri());
+    loop.exec();
+
+    result.rows = target->rowCount(QModelIndex());
+    if (finished && result.rows >= expected) {
+        result.completeNs = timer.nsecsElapsed();
+        result.successed = result.rows == expected;
+    }
+    return result;
+}
+
+//the runs of the same key are compared with each other.
+static const QStringList result_key_fields = {"scenario", "entries", "depth", "names", "fast_path"};
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless benchmark of directory enumeration and model population.");
+    parser.addHelpOption();
+    QCommandLineOption entriesOption("entries", "Comma separated entry counts of trees.", "counts", "1000,10000,100000");
+    QCommandLineOption depthOption("depth", "Directory levels of trees.", "depth", "1");
+    QCommandLineOption fanoutOption("fanout", "Sub directories of every non-leaf directory.", "fanout", "10");
+    QCommandLineOption namesOption("names", "Name style: " + SyntheticTree::nameStyles().join(", ") + ".", "style", "short");
+    QCommandLineOption scenariosOption("scenarios", "Comma separated scenarios: enumerator, model, proxy.", "scenarios", "enumerator,model,proxy");
+    QCommandLineOption repeatOption("repeat", "Runs of every scenario.", "count", "3");
+    QCommandLineOption noFastPathOption("no-fast-path", "Do not use the native local enumerator in enumerator scenario.");
+    QCommandLineOption dirOption("dir", "Directory to generate trees in, default is a temporary one.", "path");
+    QCommandLineOption timeoutOption("timeout", "Timeout of a run in seconds.", "seconds", "600");
+    QCommandLineOption baselineOption("baseline", "Previous output to compare with.", "file");
+    QCommandLineOption toleranceOption("tolerance", "Allowed slow down against baseline, 0.2 means 20%.", "ratio", "0.2");
+    parser.addOptions({entriesOption, depthOption, fanoutOption, namesOption, scenariosOption, repeatOption,
+                       noFastPathOption, dirOption, timeoutOption, baselineOption, toleranceOption});
+    parser.process(a);
+
+    QList<int> counts;
+    for (auto arg : parser.value(entriesOption).split(",")) {
+        bool ok = false;
+        int count = arg.toInt(&ok);
+        if (ok && count > 0)
+            counts<<count;
+    }
+    auto scenarios = parser.value(scenariosOption).split(",");
+    int repeat = qMax(1, parser.value(repeatOption).toInt());
+    int timeout = qMax(1, parser.value(timeoutOption).toInt()) * 1000;
+    bool fastPath = !parser.isSet(noFastPathOption);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QHash<QString, double> bestTimes;
+    bool successed = true;
+    for (auto count : counts) {
+        QTemporaryDir tmpDir(parser.isSet(dirOption)? parser.value(dirOption) + "/peony-benchmark-XXXXXX": QString());
+        if (!tmpDir.isValid()) {
+            err<<"can not create directory for tree"<<endl;
+            return 1;
+        }
+
+        SyntheticTreeOptions options;
+        options.entries = count;
+        options.depth = parser.value(depthOption).toInt();
+        options.fanout = parser.value(fanoutOption).toInt();
+        options.names = parser.value(namesOption);
+        SyntheticTree tree(options);
+        err<<"generating "<<count<<" entries in "<<tmpDir.path()<<endl;
+        if (!tree.create(tmpDir.path())) {
+            err<<"can not generate tree"<<endl;
+            return 1;
+        }
+
+        for (auto scenario : scenarios) {
+            for (int run = 0; run < repeat; run++) {
+                cleanUp();
+                BenchmarkUtils::resetPeakRss();
+                quint64 allocations = allocationCount();
+
+                RunResult result;
+                int entries = tree.topLevelEntries();
+                if (scenario == "enumerator") {
+                    result = runEnumerator(tree, fastPath, timeout);
+                    entries = tree.totalEntries();
+                } else if (scenario == "model") {
+                    result = runModel(tree, false, timeout);
+                } else if (scenario == "proxy") {
+                    result = runModel(tree, true, timeout);
+                } else {
+                    err<<"unknown scenario "<<scenario<<endl;
+                    return 1;
+                }
+
+                allocations = allocationCount() - allocations;
+
+                QJsonObject object;
+                object.insert("scenario", scenario);
+                object.insert("entries", count);
+                object.insert("depth", options.depth);
+                object.insert("names", options.names);
+                object.insert("fast_path", scenario == "enumerator"? fastPath: true);
+                object.insert("run", run);
+                object.insert("rows", result.rows);
+                object.insert("expected_rows", entries);
+                object.insert("successed", result.successed);
+                object.insert("time_to_first_row_ms", result.firstRowNs/1e6);
+                object.insert("time_to_complete_ms", result.completeNs/1e6);
+                object.insert("peak_rss_kb", BenchmarkUtils::peakRssKb());
+#ifdef PEONY_BENCHMARK_COUNT_ALLOCATIONS
+                object.insert("allocations", double(allocations));
+                object.insert("allocations_per_entry", entries > 0? double(allocations)/entries: 0);
+#endif
+                out<<QJsonDocument(object).toJson(QJsonDocument::Compact)<<endl;
+
+                if (!result.successed) {
+                    successed = false;
+                    continue;
+                }
+
+                auto key = BenchmarkUtils::resultKey(object, result_key_fields);
+                double ms = result.completeNs/1e6;
+                if (!bestTimes.contains(key) || ms < bestTimes.value(key))
+                    bestTimes.insert(key, ms);
+            }
+        }
+        cleanUp();
+    }
+
+    if (!successed)
+        return 1;
+
+    if (parser.isSet(baselineOption)) {
+        double tolerance = parser.value(toleranceOption).toDouble();
+        if (!BenchmarkUtils::checkBaseline(bestTimes, parser.value(baselineOption), result_key_fields, tolerance, err))
+            return 2;
+    }
+
+    return 0;
+}
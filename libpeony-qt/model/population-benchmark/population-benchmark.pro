@@ -0,0 +1,28 @@
+#-------------------------------------------------
+#
+# Headless benchmark of directory enumeration and model population.
+#
+#-------------------------------------------------
+
+QT       += core gui widgets
+
+TARGET = population-benchmark
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+CONFIG += link_pkgconfig no_keywords c++11 console
+CONFIG -= app_bundle
+PKGCONFIG += glib-2.0 gio-2.0
+
+include(../../libpeony-qt-header.pri)
+include(../../benchmark/benchmark-utils.pri)
+
+LIBS += -L$$PWD/../../ -lpeony
+
+SOURCES += \
+        main.cpp \
+        synthetic-tree.cpp
+
+HEADERS += \
+        synthetic-tree.h
@@ -0,0 +1,104 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "synthetic-tree.h"
+
+#include <QDir>
+#include <QUrl>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+SyntheticTree::SyntheticTree(const SyntheticTreeOptions &options)
+{
+    m_options = options;
+    m_options.depth = qMax(1, m_options.depth);
+    m_options.fanout = qMax(1, m_options.fanout);
+    if (!nameStyles().contains(m_options.names))
+        m_options.names = "short";
+}
+
+QStringList SyntheticTree::nameStyles()
+{
+    return QStringList()<<"short"<<"long"<<"numbered"<<"unicode"<<"mixed";
+}
+
+QString SyntheticTree::fileName(int index) const
+{
+    if (m_options.names == "long") {
+        return QString("%1-%2.txt").arg(index).arg(QString("a-rather-long-file-name-for-eliding-").repeated(3));
+    } else if (m_options.names == "numbered") {
+        //exercise the duplicated name sort path.
+        return QString("file (%1).txt").arg(index);
+    } else if (m_options.names == "unicode") {
+        return QString("文件-%1-ümlaut-ファイル.txt").arg(index);
+    } else if (m_options.names == "mixed") {
+        static const QStringList suffixes = QStringList()<<".txt"<<".png"<<".jpg"<<".pdf"<<".mp4"<<".docx"<<".tar.gz"<<"";
+        return QString("file-%1%2").arg(index).arg(suffixes.at(index % suffixes.count()));
+    }
+    return QString("f%1").arg(index);
+}
+
+bool SyntheticTree::create(const QString &rootPath)
+{
+    m_root_uri = QUrl::fromLocalFile(rootPath).toString();
+
+    //create the directory levels first.
+    QStringList directories;
+    directories<<rootPath;
+    QStringList currentLevel = directories;
+    int subDirectories = 0;
+    for (int level = 1; level < m_options.depth; level++) {
+        QStringList nextLevel;
+        for (auto parent : currentLevel) {
+            for (int i = 0; i < m_options.fanout; i++) {
+                if (subDirectories >= m_options.entries)
+                    break;
+                QString path = QString("%1/dir-%2").arg(parent).arg(i);
+                if (!QDir().mkdir(path))
+                    return false;
+                nextLevel<<path;
+                subDirectories++;
+                if (parent == rootPath)
+                    m_top_level_entries++;
+            }
+        }
+        directories<<nextLevel;
+        currentLevel = nextLevel;
+    }
+
+    int files = m_options.entries - subDirectories;
+    for (int i = 0; i < files; i++) {
+        const QString &parent = directories.at(i % directories.count());
+        QByteArray path = QString("%1/%2").arg(parent).arg(fileName(i)).toUtf8();
+        int fd = ::open(path.constData(), O_CREAT | O_WRONLY | O_CLOEXEC, 0644);
+        if (fd < 0)
+            return false;
+        ::close(fd);
+        if (parent == rootPath)
+            m_top_level_entries++;
+    }
+
+    m_directory_count = directories.count();
+    m_total_entries = subDirectories + files;
+    return true;
+}
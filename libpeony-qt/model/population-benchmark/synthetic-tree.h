@@ -0,0 +1,91 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef SYNTHETICTREE_H
+#define SYNTHETICTREE_H
+
+#include <QString>
+#include <QStringList>
+
+/*!
+ * \brief The SyntheticTreeOptions struct
+ * <br>
+ * entries is the count of all files and sub directories in the tree.
+ * depth is the count of directory levels, 1 means all the entries are in root.
+ * Every directory which is not in the last level has fanout sub directories,
+ * the files are spread over all the directories evenly.
+ * </br>
+ * \see SyntheticTree::nameStyles().
+ */
+struct SyntheticTreeOptions {
+    int entries = 1000;
+    int depth = 1;
+    int fanout = 10;
+    QString names = "short";
+};
+
+/*!
+ * \brief The SyntheticTree class
+ * <br>
+ * Generates a directory tree of empty files for benchmarks.
+ * </br>
+ */
+class SyntheticTree
+{
+public:
+    explicit SyntheticTree(const SyntheticTreeOptions &options);
+
+    static QStringList nameStyles();
+
+    /*!
+     * \brief create
+     * \param rootPath, an existed empty directory.
+     * \return false if any entry could not be created.
+     */
+    bool create(const QString &rootPath);
+
+    QString rootUri() const {
+        return m_root_uri;
+    }
+    int totalEntries() const {
+        return m_total_entries;
+    }
+    int topLevelEntries() const {
+        return m_top_level_entries;
+    }
+    int directoryCount() const {
+        return m_directory_count;
+    }
+
+protected:
+    QString fileName(int index) const;
+
+private:
+    SyntheticTreeOptions m_options;
+
+    QString m_root_uri;
+    int m_total_entries = 0;
+    int m_top_level_entries = 0;
+    int m_directory_count = 0;
+};
+
+#endif // SYNTHETICTREE_H
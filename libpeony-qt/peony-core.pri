@@ -5,7 +5,9 @@ HEADERS += \
     $$PWD/file-info.h                   \
     $$PWD/file-info-job.h               \
     $$PWD/file-info-manager.h           \
+    $$PWD/mime-type-cache.h             \
     $$PWD/file-enumerator.h             \
+    $$PWD/local-file-enumerator.h       \
     $$PWD/mount-operation.h             \
     $$PWD/file-watcher.h                \
     $$PWD/connect-server-dialog.h       \
@@ -24,7 +26,9 @@ SOURCES += \
     $$PWD/file-info.cpp                 \
     $$PWD/file-info-job.cpp             \
     $$PWD/file-info-manager.cpp         \
+    $$PWD/mime-type-cache.cpp           \
     $$PWD/file-enumerator.cpp           \
+    $$PWD/local-file-enumerator.cpp     \
     $$PWD/mount-operation.cpp           \
     $$PWD/file-watcher.cpp              \
     $$PWD/connect-server-dialog.cpp     \
@@ -33,7 +33,11 @@
 #include "thumbnail/office-thumbnail.h"
 #include "thumbnail/image-pdf-thumbnail.h"
 #include "generic-thumbnailer.h"
+#include "thumbnail-cache.h"
 #include "thumbnail-job.h"
+#include "thumbnail-service-client.h"
+
+#include "file-info-job.h"
 
 #include "global-settings.h"
 
@@ -42,10 +46,39 @@
 #include <QUrl>
 
 #include <QThreadPool>
-#include <QSemaphore>
+#include <QThread>
+#include <QReadWriteLock>
+#include <QDBusConnection>
+#include <QJsonArray>
+
+#include <algorithm>
 
 #include <gio/gdesktopappinfo.h>
 
+//most documents embed a preview, the others wait for OfficeConverter which
+//converts the waiting documents together, at most half of workers do that.
+#ifndef PEONY_THUMBNAIL_OFFICE_JOBS
+#define PEONY_THUMBNAIL_OFFICE_JOBS 4
+#endif
+
+#ifndef PEONY_THUMBNAIL_MEMORY_BUDGET
+#define PEONY_THUMBNAIL_MEMORY_BUDGET 64*1024*1024
+#endif
+
+//evict down to this percentage of budget.
+#ifndef PEONY_THUMBNAIL_EVICTION_TARGET
+#define PEONY_THUMBNAIL_EVICTION_TARGET 90
+#endif
+
+#ifndef PEONY_THUMBNAIL_VIDEO_JOBS
+#define PEONY_THUMBNAIL_VIDEO_JOBS 2
+#endif
+
+//the pixmaps of a themed icon are held by icon theme cache anyway.
+#ifndef PEONY_THUMBNAIL_THEME_ICON_COST
+#define PEONY_THUMBNAIL_THEME_ICON_COST 4096
+#endif
+
 using namespace Peony;
 
 static ThumbnailManager *global_instance = nullptr;
@@ -66,17 +99,33 @@ ThumbnailManager::ThumbnailManager(QObject *parent) : QObject(parent)
 {
     GlobalSettings::getInstance();
 
+    m_max_workers = qMax(1, QThread::idealThreadCount());
     m_thumbnail_thread_pool = new QThreadPool(this);
-    m_thumbnail_thread_pool->setMaxThreadCount(1);
+    m_thumbnail_thread_pool->setMaxThreadCount(m_max_workers);
+
+    m_cache_budget = PEONY_THUMBNAIL_MEMORY_BUDGET;
+    auto settings = GlobalSettings::getInstance();
+    if (settings->isExist(THUMBNAIL_MEMORY_BUDGET)) {
+        qint64 budget = settings->getValue(THUMBNAIL_MEMORY_BUDGET).toLongLong();
+        if (budget > 0)
+            m_cache_budget = budget*1024*1024;
+    }
 
-    m_semaphore = new QSemaphore(1);
+    m_clock.start();
 
     findAtril();
+
+    QDBusConnection::sessionBus().connect(PEONY_THUMBNAILER_SERVICE,
+                                          PEONY_THUMBNAILER_PATH,
+                                          PEONY_THUMBNAILER_INTERFACE,
+                                          "ThumbnailReady",
+                                          this,
+                                          SLOT(onServiceThumbnailReady(QString)));
 }
 
 ThumbnailManager::~ThumbnailManager()
 {
-    delete m_semaphore;
+
 }
 
 ThumbnailManager *ThumbnailManager::getInstance()
@@ -91,12 +140,200 @@ void ThumbnailManager::syncThumbnailPreferences()
     GlobalSettings::getInstance()->forceSync(FORBID_THUMBNAIL_IN_VIEW);
 }
 
-void ThumbnailManager::insertOrUpdateThumbnail(const QString &uri, const QIcon &icon)
+void ThumbnailManager::insertOrUpdateThumbnail(const QString &uri, const QIcon &icon, bool shadow)
 {
-    m_semaphore->acquire();
-    m_hash.remove(uri);
-    m_hash.insert(uri, icon);
-    m_semaphore->release();
+    auto entry = std::make_shared<ThumbnailEntry>();
+    entry->icon = icon;
+    entry->shadow = shadow;
+    entry->cost = iconCost(icon);
+    entry->lastUsed.store(m_use_clock.fetchAndAddRelaxed(1) + 1);
+
+    QWriteLocker locker(&m_cache_lock);
+    auto old = m_hash.value(uri);
+    if (old)
+        m_cache_bytes -= old->cost;
+    m_hash.insert(uri, entry);
+    m_evicted_uris.remove(uri);
+    m_cache_bytes += entry->cost;
+
+    if (m_cache_bytes > m_cache_budget)
+        evictThumbnails();
+}
+
+qint64 ThumbnailManager::iconCost(const QIcon &icon)
+{
+    //a themed icon lists every size of theme, summing them would evict real thumbnails.
+    if (!icon.name().isEmpty())
+        return PEONY_THUMBNAIL_THEME_ICON_COST;
+
+    qint64 cost = 0;
+    for (auto size : icon.availableSizes()) {
+        cost += qint64(size.width()) * size.height() * 4;
+    }
+    //scalable icons are rendered on demand, count them as a normal thumbnail.
+    if (cost == 0)
+        cost = 128 * 128 * 4;
+    return cost;
+}
+
+void ThumbnailManager::evictThumbnails()
+{
+    QVector<QPair<quint64, QString>> stamps;
+    stamps.reserve(m_hash.count());
+    for (auto it = m_hash.constBegin(); it != m_hash.constEnd(); it++) {
+        stamps<<qMakePair(it.value()->lastUsed.load(), it.key());
+    }
+    std::sort(stamps.begin(), stamps.end());
+
+    qint64 target = m_cache_budget / 100 * PEONY_THUMBNAIL_EVICTION_TARGET;
+    for (auto stamp : stamps) {
+        if (m_cache_bytes <= target)
+            break;
+        auto entry = m_hash.take(stamp.second);
+        m_cache_bytes -= entry->cost;
+        m_evicted_uris.insert(stamp.second);
+        m_evictions++;
+    }
+}
+
+void ThumbnailManager::setCacheBudget(qint64 bytes)
+{
+    QWriteLocker locker(&m_cache_lock);
+    m_cache_budget = qMax(qint64(0), bytes);
+    if (m_cache_bytes > m_cache_budget)
+        evictThumbnails();
+}
+
+qint64 ThumbnailManager::cacheBudget()
+{
+    QReadLocker locker(&m_cache_lock);
+    return m_cache_budget;
+}
+
+ThumbnailCacheStatistics ThumbnailManager::cacheStatistics()
+{
+    QReadLocker locker(&m_cache_lock);
+    ThumbnailCacheStatistics statistics;
+    statistics.hits = m_hits.load();
+    statistics.misses = m_misses.load();
+    statistics.evictions = m_evictions;
+    statistics.count = m_hash.count();
+    statistics.bytes = m_cache_bytes;
+    statistics.budget = m_cache_budget;
+    return statistics;
+}
+
+ThumbnailStatistics ThumbnailManager::statistics()
+{
+    m_statistics_mutex.lock();
+    ThumbnailStatistics statistics = m_statistics;
+    m_statistics_mutex.unlock();
+
+    statistics.memory = cacheStatistics();
+    return statistics;
+}
+
+void ThumbnailManager::resetStatistics()
+{
+    m_statistics_mutex.lock();
+    m_statistics = ThumbnailStatistics();
+    m_statistics_mutex.unlock();
+
+    QWriteLocker locker(&m_cache_lock);
+    m_hits.store(0);
+    m_misses.store(0);
+    m_evictions = 0;
+}
+
+void ThumbnailManager::recordDecode(ThumbnailStatistics::MimeClass mimeClass, const QElapsedTimer &timer, bool failed)
+{
+    qint64 usec = timer.nsecsElapsed()/1000;
+    QMutexLocker locker(&m_statistics_mutex);
+    m_statistics.decode[mimeClass].add(usec, failed);
+}
+
+void ThumbnailManager::recordDroppedRequest()
+{
+    QMutexLocker locker(&m_statistics_mutex);
+    m_statistics.droppedRequests++;
+}
+
+QString ThumbnailStatistics::mimeClassName(int mimeClass)
+{
+    switch (mimeClass) {
+    case ImageClass:
+        return "image";
+    case SvgClass:
+        return "svg";
+    case PdfClass:
+        return "pdf";
+    case DjvuClass:
+        return "djvu";
+    case VideoClass:
+        return "video";
+    case OfficeClass:
+        return "office";
+    case DesktopClass:
+        return "desktop";
+    default:
+        return QString();
+    }
+}
+
+static QJsonObject timeStatisticsToJson(const ThumbnailTimeStatistics &statistics)
+{
+    QJsonObject object;
+    object.insert("count", double(statistics.count));
+    object.insert("failures", double(statistics.failures));
+    object.insert("total_ms", statistics.totalUsec/1e3);
+    object.insert("average_ms", statistics.count > 0? statistics.totalUsec/1e3/statistics.count: 0);
+    object.insert("max_ms", statistics.maxUsec/1e3);
+    return object;
+}
+
+static double hitRate(quint64 hits, quint64 misses)
+{
+    return hits + misses > 0? double(hits)/(hits + misses): 0;
+}
+
+QJsonObject ThumbnailStatistics::toJson() const
+{
+    QJsonObject requestsObject;
+    requestsObject.insert("queued", double(requests));
+    requestsObject.insert("merged", double(mergedRequests));
+    requestsObject.insert("dropped", double(droppedRequests));
+    requestsObject.insert("canceled_pending", double(canceledPending));
+    requestsObject.insert("canceled_running", double(canceledRunning));
+    requestsObject.insert("shared", double(sharedRequests));
+
+    QJsonObject decodeObject;
+    for (int i = 0; i < MimeClassCount; i++) {
+        decodeObject.insert(mimeClassName(i), timeStatisticsToJson(decode[i]));
+    }
+
+    QJsonObject diskObject;
+    diskObject.insert("hits", double(diskHits));
+    diskObject.insert("failure_hits", double(diskFailureHits));
+    diskObject.insert("misses", double(diskMisses));
+    diskObject.insert("hit_rate", hitRate(diskHits + diskFailureHits, diskMisses));
+
+    QJsonObject memoryObject;
+    memoryObject.insert("hits", double(memory.hits));
+    memoryObject.insert("misses", double(memory.misses));
+    memoryObject.insert("hit_rate", hitRate(memory.hits, memory.misses));
+    memoryObject.insert("evictions", double(memory.evictions));
+    memoryObject.insert("count", memory.count);
+    memoryObject.insert("bytes", double(memory.bytes));
+    memoryObject.insert("budget", double(memory.budget));
+
+    QJsonObject object;
+    object.insert("requests", requestsObject);
+    object.insert("queue_wait", timeStatisticsToJson(queueWait));
+    object.insert("decode", decodeObject);
+    object.insert("service", timeStatisticsToJson(service));
+    object.insert("disk_cache", diskObject);
+    object.insert("memory_cache", memoryObject);
+    return object;
 }
 
 void ThumbnailManager::setForbidThumbnailInView(bool forbid)
@@ -104,33 +341,273 @@ void ThumbnailManager::setForbidThumbnailInView(bool forbid)
     GlobalSettings::getInstance()->setValue(FORBID_THUMBNAIL_IN_VIEW, forbid);
 }
 
-void ThumbnailManager::createVideFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher)
+QString ThumbnailManager::localPath(const QString &uri)
 {
-    QIcon thumbnail;
+    QUrl url = uri;
+    if (!uri.startsWith("file:///")) {
+        url = FileUtils::getTargetUri(uri);
+    }
 
-    VideoThumbnail videoThumbnail(uri);
-    thumbnail = videoThumbnail.generateThumbnail();
+    if (!url.isLocalFile())
+        return QString();
+    return url.path();
+}
+
+bool ThumbnailManager::loadCachedThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher)
+{
+    auto path = localPath(uri);
+    auto modifiedTime = FileInfo::fromUri(uri)->modifiedTime();
+    if (path.isEmpty() || modifiedTime == 0)
+        return false;
+
+    QImage image = ThumbnailCache::lookup(path, modifiedTime);
+    bool failed = image.isNull() && ThumbnailCache::hasFailed(path, modifiedTime);
+
+    m_statistics_mutex.lock();
+    if (!image.isNull()) {
+        m_statistics.diskHits++;
+    } else if (failed) {
+        m_statistics.diskFailureHits++;
+    } else {
+        m_statistics.diskMisses++;
+    }
+    m_statistics_mutex.unlock();
+
+    if (!image.isNull()) {
+        insertThumbnailImage(uri, image);
+        return true;
+    }
+
+    return failed;
+}
+
+void ThumbnailManager::insertGeneratedThumbnail(const QString &uri, const QImage &image, bool failed, std::shared_ptr<FileWatcher> watcher)
+{
+    auto path = localPath(uri);
+    auto modifiedTime = FileInfo::fromUri(uri)->modifiedTime();
+
+    if (image.isNull()) {
+        if (failed)
+            ThumbnailCache::markFailed(path, modifiedTime);
+        return;
+    }
+
+    ThumbnailCache::store(path, modifiedTime, image);
+    insertThumbnailImage(uri, image);
+}
+
+void ThumbnailManager::insertThumbnailImage(const QString &uri, const QImage &image)
+{
+    //the shadow is painted by delegates.
+    QIcon thumbnail = GenericThumbnailer::generateThumbnailFromImage(image, false);
     if (!thumbnail.isNull()) {
-        insertOrUpdateThumbnail(uri, thumbnail);
-        if (watcher) {
-            watcher->fileChanged(uri);
+        insertOrUpdateThumbnail(uri, thumbnail, !image.hasAlphaChannel());
+        Q_EMIT thumbnailReady(uri);
+    }
+}
+
+bool ThumbnailManager::loadServiceThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher, JobKind kind)
+{
+    auto key = qMakePair(uri, quintptr(watcher.get()));
+    m_cancelable_jobs_mutex.lock();
+    m_cancelable_jobs.insert(key, false);
+    m_service_jobs.insert(key);
+    m_cancelable_jobs_mutex.unlock();
+
+    QElapsedTimer timer;
+    timer.start();
+    QImage image;
+    auto result = ThumbnailServiceClient::requestThumbnail(uri, kind, image);
+
+    m_cancelable_jobs_mutex.lock();
+    bool canceled = m_cancelable_jobs.take(key);
+    m_service_jobs.remove(key);
+    m_cancelable_jobs_mutex.unlock();
+
+    if (result == ThumbnailServiceClient::Unavailable)
+        return false;
+
+    m_statistics_mutex.lock();
+    m_statistics.service.add(timer.nsecsElapsed()/1000, result == ThumbnailServiceClient::Failed);
+    m_statistics_mutex.unlock();
+
+    //the service has saved the thumbnail or the failure marker into disk cache.
+    if (result == ThumbnailServiceClient::Generated && !canceled)
+        insertThumbnailImage(uri, image);
+
+    return true;
+}
+
+QImage ThumbnailManager::generateThumbnailImage(const QString &uri, bool *failed)
+{
+    auto info = FileInfo::fromUri(uri);
+    if (info->mimeType().isEmpty()) {
+        FileInfoJob job(info);
+        job.querySync();
+    }
+
+    QUrl url = uri;
+    if (!uri.startsWith("file:///")) {
+        url = FileUtils::getTargetUri(uri);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QImage image;
+    bool imageFailed = false;
+    if (info->isImagePdfFile()) {
+        ImagePdfThumbnail imagePdfThumbnail(uri);
+        image = imagePdfThumbnail.generateThumbnail();
+        imageFailed = imagePdfThumbnail.failed();
+        recordDecode(ThumbnailStatistics::DjvuClass, timer, imageFailed);
+    } else if (info->isImageFile()) {
+        //svg is rendered as vector, it is not cached.
+        if (!url.path().endsWith(".svg")) {
+            image = GenericThumbnailer::scaledImage(url.path());
+            imageFailed = image.isNull() && QFile::exists(url.path());
+            recordDecode(ThumbnailStatistics::ImageClass, timer, imageFailed);
+        }
+    } else if (info->mimeType().contains("pdf")) {
+        PdfThumbnail pdfThumbnail(url.path());
+        image = pdfThumbnail.generateThumbnail();
+        if (!image.isNull())
+            image = image.convertToFormat(QImage::Format_RGB32);
+        imageFailed = image.isNull();
+        recordDecode(ThumbnailStatistics::PdfClass, timer, imageFailed);
+    } else if (info->isVideoFile()) {
+        VideoThumbnail videoThumbnail(uri);
+        image = videoThumbnail.generateThumbnail();
+        imageFailed = videoThumbnail.failed();
+        recordDecode(ThumbnailStatistics::VideoClass, timer, imageFailed);
+    } else if (info->isOfficeFile()) {
+        OfficeThumbnail officeThumbnail(uri);
+        image = officeThumbnail.generateThumbnail();
+        imageFailed = officeThumbnail.failed();
+        recordDecode(ThumbnailStatistics::OfficeClass, timer, imageFailed);
+    }
+
+    auto path = localPath(uri);
+    auto modifiedTime = info->modifiedTime();
+    if (!path.isEmpty() && modifiedTime != 0) {
+        if (!image.isNull()) {
+            ThumbnailCache::store(path, modifiedTime, image);
+        } else if (imageFailed) {
+            ThumbnailCache::markFailed(path, modifiedTime);
+        }
+    }
+
+    if (failed)
+        *failed = imageFailed;
+    return image;
+}
+
+void ThumbnailManager::markThumbnailFailed(const QString &uri)
+{
+    auto info = FileInfo::fromUri(uri);
+    if (info->mimeType().isEmpty()) {
+        FileInfoJob job(info);
+        job.querySync();
+    }
+
+    auto path = localPath(uri);
+    auto modifiedTime = info->modifiedTime();
+    if (!path.isEmpty() && modifiedTime != 0)
+        ThumbnailCache::markFailed(path, modifiedTime);
+}
+
+void ThumbnailManager::onServiceThumbnailReady(const QString &uri)
+{
+    if (!m_pending_serials.contains(uri) || m_service_ready_uris.contains(uri))
+        return;
+
+    //another client asked for it first, it is on the disk now.
+    //the pending requests stay until it is loaded, in case it is not there.
+    m_service_ready_uris<<uri;
+    QtConcurrent::run(m_thumbnail_thread_pool, [=]() {
+        bool loaded = loadCachedThumbnail(uri, nullptr);
+        QMetaObject::invokeMethod(this, "onServiceThumbnailLoaded", Qt::QueuedConnection,
+                                  Q_ARG(QString, uri),
+                                  Q_ARG(bool, loaded));
+    });
+}
+
+void ThumbnailManager::onServiceThumbnailLoaded(const QString &uri, bool loaded)
+{
+    m_service_ready_uris.remove(uri);
+    if (!loaded)
+        return;
+
+    int removed = 0;
+    for (auto serial : m_pending_serials.values(uri)) {
+        for (int i = 0; i < JobKindCount; i++) {
+            removed += m_pending_requests[i].remove(serial);
         }
     }
+    m_pending_serials.remove(uri);
+
+    QMutexLocker locker(&m_statistics_mutex);
+    m_statistics.sharedRequests += removed;
+}
+
+void ThumbnailManager::createVideFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher)
+{
+    if (loadCachedThumbnail(uri, watcher))
+        return;
+
+    if (loadServiceThumbnail(uri, watcher, VideoJob))
+        return;
+
+    auto key = qMakePair(uri, quintptr(watcher.get()));
+    m_cancelable_jobs_mutex.lock();
+    m_cancelable_jobs.insert(key, false);
+    m_cancelable_jobs_mutex.unlock();
+
+    QElapsedTimer timer;
+    timer.start();
+    VideoThumbnail videoThumbnail(uri);
+    videoThumbnail.setCancelCallback([=]() {
+        return isThumbnailCanceled(uri, watcher);
+    });
+    QImage image = videoThumbnail.generateThumbnail();
+
+    m_cancelable_jobs_mutex.lock();
+    bool canceled = m_cancelable_jobs.take(key);
+    m_cancelable_jobs_mutex.unlock();
+
+    //the item is gone, do not leave a failure marker for an aborted extraction.
+    if (canceled)
+        return;
+
+    recordDecode(ThumbnailStatistics::VideoClass, timer, videoThumbnail.failed());
+
+    insertGeneratedThumbnail(uri, image, videoThumbnail.failed(), watcher);
 
     return;
 }
 
 void ThumbnailManager::createImagePdfFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher)
 {
-    QIcon thumbnail;
+    if (loadCachedThumbnail(uri, watcher))
+        return;
+
+    if (loadServiceThumbnail(uri, watcher))
+        return;
 
-    ImagePdfThumbnail officeThumbnail(uri);
-    thumbnail = officeThumbnail.generateThumbnail();;
+    QElapsedTimer timer;
+    timer.start();
+    ImagePdfThumbnail imagePdfThumbnail(uri);
+    QImage image = imagePdfThumbnail.generateThumbnail();
+    recordDecode(ThumbnailStatistics::DjvuClass, timer, imagePdfThumbnail.failed());
+    if (!image.isNull() || imagePdfThumbnail.failed()) {
+        insertGeneratedThumbnail(uri, image, imagePdfThumbnail.failed(), watcher);
+        return;
+    }
+
+    //ddjvu is not installed.
+    QIcon thumbnail = QIcon::fromTheme("atril");
     if (!thumbnail.isNull()) {
         insertOrUpdateThumbnail(uri, thumbnail);
-        if (watcher) {
-            watcher->fileChanged(uri);
-        }
+        Q_EMIT thumbnailReady(uri);
     }
 
     return;
@@ -138,7 +615,12 @@ void ThumbnailManager::createImagePdfFileThumbnail(const QString &uri, std::shar
 
 void ThumbnailManager::createPdfFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher)
 {
-    QIcon thumbnail;
+    if (loadCachedThumbnail(uri, watcher))
+        return;
+
+    if (loadServiceThumbnail(uri, watcher))
+        return;
+
     QUrl url = uri;
 
     if (!uri.startsWith("file:///")) {
@@ -146,16 +628,16 @@ void ThumbnailManager::createPdfFileThumbnail(const QString &uri, std::shared_pt
         //qDebug()<<url;
     }
 
+    QElapsedTimer timer;
+    timer.start();
     PdfThumbnail pdfThumbnail(url.path());
-    QPixmap pix = pdfThumbnail.generateThumbnail();
+    QImage image = pdfThumbnail.generateThumbnail();
+    recordDecode(ThumbnailStatistics::PdfClass, timer, image.isNull());
 
-    thumbnail = GenericThumbnailer::generateThumbnail(pix, true);
-    if (!thumbnail.isNull()) {
-        insertOrUpdateThumbnail(uri, thumbnail);
-        if (watcher) {
-            watcher->fileChanged(uri);
-        }
-    }
+    //the page is opaque, drop the alpha channel so that it has a shadow as before.
+    if (!image.isNull())
+        image = image.convertToFormat(QImage::Format_RGB32);
+    insertGeneratedThumbnail(uri, image, true, watcher);
 
     return;
 }
@@ -168,36 +650,59 @@ void ThumbnailManager::createImageFileThumbnail(const QString &uri, std::shared_
         //qDebug()<<url;
     }
 
-    QIcon thumbnail = GenericThumbnailer::generateThumbnail(url.path(), true);
-    if (!thumbnail.isNull()) {
-        insertOrUpdateThumbnail(uri, thumbnail);
-        if (watcher) {
-            watcher->fileChanged(uri);
+    //svg is rendered as vector, it is not cached.
+    if (url.path().endsWith(".svg")) {
+        QElapsedTimer timer;
+        timer.start();
+        QIcon thumbnail = GenericThumbnailer::generateThumbnail(url.path(), false);
+        recordDecode(ThumbnailStatistics::SvgClass, timer, thumbnail.isNull());
+        if (!thumbnail.isNull()) {
+            insertOrUpdateThumbnail(uri, thumbnail);
+            Q_EMIT thumbnailReady(uri);
         }
+        return;
     }
 
+    if (loadCachedThumbnail(uri, watcher))
+        return;
+
+    if (loadServiceThumbnail(uri, watcher))
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+    QImage image = GenericThumbnailer::scaledImage(url.path());
+    //a missing file is not a failure, it might be created later.
+    bool failed = image.isNull() && QFile::exists(url.path());
+    recordDecode(ThumbnailStatistics::ImageClass, timer, failed);
+    insertGeneratedThumbnail(uri, image, failed, watcher);
+
     //qApp->processEvents();
     return;
 }
 
 void ThumbnailManager::createOfficeFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher)
 {
-    QIcon thumbnail;
+    if (loadCachedThumbnail(uri, watcher))
+        return;
+
+    if (loadServiceThumbnail(uri, watcher, OfficeJob))
+        return;
 
+    QElapsedTimer timer;
+    timer.start();
     OfficeThumbnail officeThumbnail(uri);
-    thumbnail = officeThumbnail.generateThumbnail();;
-    if (!thumbnail.isNull()) {
-        insertOrUpdateThumbnail(uri, thumbnail);
-        if (watcher) {
-            watcher->fileChanged(uri);
-        }
-    }
+    QImage image = officeThumbnail.generateThumbnail();
+    recordDecode(ThumbnailStatistics::OfficeClass, timer, officeThumbnail.failed());
+    insertGeneratedThumbnail(uri, image, officeThumbnail.failed(), watcher);
 
     return;
 }
 
 void ThumbnailManager::createDesktopFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher)
 {
+    QElapsedTimer timer;
+    timer.start();
     QIcon thumbnail;
     QUrl url = uri;
 
@@ -216,7 +721,7 @@ void ThumbnailManager::createDesktopFileThumbnail(const QString &uri, std::share
 
     if (thumbnail.isNull()) {
         if (string.startsWith("/")) {
-            thumbnail = GenericThumbnailer::generateThumbnail(_icon_string, true);
+            thumbnail = GenericThumbnailer::generateThumbnail(_icon_string, false);
         } else if (string.contains(".")) {
             // try getting themed icon with image suffix.
             string.chop(string.count() - string.lastIndexOf("."));
@@ -250,11 +755,11 @@ void ThumbnailManager::createDesktopFileThumbnail(const QString &uri, std::share
     g_free(_icon_string);
     g_object_unref(_desktop_file);
 
+    recordDecode(ThumbnailStatistics::DesktopClass, timer, thumbnail.isNull());
+
     if (!thumbnail.isNull()) {
         insertOrUpdateThumbnail(uri, thumbnail);
-        if (watcher) {
-            watcher->fileChanged(uri);
-        }
+        Q_EMIT thumbnailReady(uri);
     }
 
     return;
@@ -300,9 +805,7 @@ void ThumbnailManager::createThumbnailInternal(const QString &uri, std::shared_p
             auto icon = GenericThumbnailer::generateThumbnail(info->customIcon());
             if (!icon.isNull()) {
                 insertOrUpdateThumbnail(uri, icon);
-                if (watcher) {
-                    watcher->fileChanged(uri);
-                }
+                Q_EMIT thumbnailReady(uri);
             }
         }
         else if (info->isImagePdfFile())
@@ -337,13 +840,10 @@ void ThumbnailManager::createThumbnailInternal(const QString &uri, std::shared_p
 
 void ThumbnailManager::createThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher, bool force)
 {
-    qDebug() <<"createThumbnail:" <<force<<uri;
     auto thumbnail = tryGetThumbnail(uri);
     if (!thumbnail.isNull()) {
         if (!force) {
-            watcher->thumbnailUpdated(uri);
-            watcher->fileChanged(uri);
-            qDebug() <<"createThumbnail return:" <<uri;
+            Q_EMIT thumbnailReady(uri);
             return;
         }
     }
@@ -383,9 +883,199 @@ void ThumbnailManager::createThumbnail(const QString &uri, std::shared_ptr<FileW
     if (!needThumbnail)
         return;
 
-    auto thumbnailJob = new ThumbnailJob(uri, watcher, this);
-    m_thumbnail_thread_pool->start(thumbnailJob);
-    qDebug() <<"createThumbnail thumbnailJob start:" <<uri;
+    JobKind kind = GenericJob;
+    if (info->customIcon().isEmpty()) {
+        if (info->isVideoFile() && !info->isImageFile() && !info->mimeType().contains("pdf")) {
+            kind = VideoJob;
+        } else if (info->isOfficeFile()) {
+            kind = OfficeJob;
+        }
+    }
+    queueThumbnailRequest(uri, watcher, kind);
+}
+
+void ThumbnailManager::queueThumbnailRequest(const QString &uri, std::shared_ptr<FileWatcher> watcher, JobKind kind)
+{
+    //a file requested again by the same model only needs one job.
+    for (auto serial : m_pending_serials.values(uri)) {
+        for (int i = 0; i < JobKindCount; i++) {
+            auto it = m_pending_requests[i].constFind(serial);
+            if (it != m_pending_requests[i].constEnd() && it.value().watcher.lock() == watcher) {
+                QMutexLocker locker(&m_statistics_mutex);
+                m_statistics.mergedRequests++;
+                return;
+            }
+        }
+    }
+
+    ThumbnailRequest request;
+    request.uri = uri;
+    request.watcher = watcher;
+    request.kind = kind;
+    request.serial = ++m_request_serial;
+    request.queuedTime = m_clock.nsecsElapsed();
+    m_pending_requests[kind].insert(request.serial, request);
+    m_pending_serials.insert(uri, request.serial);
+
+    m_statistics_mutex.lock();
+    m_statistics.requests++;
+    m_statistics_mutex.unlock();
+
+    schedule();
+}
+
+void ThumbnailManager::schedule()
+{
+    ThumbnailRequest request;
+    while (m_running_count < m_max_workers && takeRequest(request)) {
+        m_running_jobs[request.kind]++;
+        m_running_count++;
+
+        m_statistics_mutex.lock();
+        m_statistics.queueWait.add((m_clock.nsecsElapsed() - request.queuedTime)/1000);
+        m_statistics_mutex.unlock();
+
+        auto thumbnailJob = new ThumbnailJob(request.uri, request.watcher.lock(), request.kind);
+        m_thumbnail_thread_pool->start(thumbnailJob);
+    }
+}
+
+bool ThumbnailManager::takeRequest(ThumbnailRequest &request)
+{
+    while (true) {
+        int kind = -1;
+        quint64 serial = 0;
+
+        //visible rows first.
+        for (auto uris : m_visible_uris) {
+            for (auto uri : uris) {
+                for (auto pendingSerial : m_pending_serials.values(uri)) {
+                    for (int i = 0; i < JobKindCount; i++) {
+                        if (m_running_jobs[i] < kindLimit(i, m_max_workers) && m_pending_requests[i].contains(pendingSerial)) {
+                            kind = i;
+                            serial = pendingSerial;
+                            break;
+                        }
+                    }
+                    if (kind >= 0)
+                        break;
+                }
+                if (kind >= 0)
+                    break;
+            }
+            if (kind >= 0)
+                break;
+        }
+
+        //then the earliest request of the kinds which are not busy.
+        if (kind < 0) {
+            for (int i = 0; i < JobKindCount; i++) {
+                if (m_running_jobs[i] >= kindLimit(i, m_max_workers) || m_pending_requests[i].isEmpty())
+                    continue;
+                if (kind < 0 || m_pending_requests[i].firstKey() < serial) {
+                    kind = i;
+                    serial = m_pending_requests[i].firstKey();
+                }
+            }
+        }
+
+        if (kind < 0)
+            return false;
+
+        request = m_pending_requests[kind].take(serial);
+        m_pending_serials.remove(request.uri, serial);
+
+        //drop the requests of destroyed models.
+        if (!request.watcher.expired())
+            return true;
+        recordDroppedRequest();
+    }
+}
+
+int ThumbnailManager::kindLimit(int kind, int maxWorkers)
+{
+    switch (kind) {
+    case VideoJob:
+        return qMin(maxWorkers, PEONY_THUMBNAIL_VIDEO_JOBS);
+    case OfficeJob:
+        return qMin(qMax(1, maxWorkers/2), PEONY_THUMBNAIL_OFFICE_JOBS);
+    default:
+        return maxWorkers;
+    }
+}
+
+void ThumbnailManager::onThumbnailJobFinished(int kind)
+{
+    m_running_jobs[kind]--;
+    m_running_count--;
+    schedule();
+}
+
+void ThumbnailManager::setVisibleUris(QObject *view, const QStringList &uris)
+{
+    if (!m_visible_uris.contains(view)) {
+        connect(view, &QObject::destroyed, this, [=]() {
+            m_visible_uris.remove(view);
+        });
+    }
+    m_visible_uris.insert(view, uris);
+    schedule();
+}
+
+void ThumbnailManager::clearVisibleUris(QObject *view)
+{
+    m_visible_uris.remove(view);
+}
+
+bool ThumbnailManager::isThumbnailCanceled(const QString &uri, std::shared_ptr<FileWatcher> watcher)
+{
+    QMutexLocker locker(&m_cancelable_jobs_mutex);
+    return m_cancelable_jobs.value(qMakePair(uri, quintptr(watcher.get())), false);
+}
+
+void ThumbnailManager::cancelThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher)
+{
+    auto key = qMakePair(uri, quintptr(watcher.get()));
+    m_cancelable_jobs_mutex.lock();
+    auto job = m_cancelable_jobs.find(key);
+    bool running = job != m_cancelable_jobs.end();
+    if (running)
+        job.value() = true;
+
+    //the service cancels all the requests of uri in this process,
+    //so it is told only if no other one is waiting for uri.
+    bool cancelService = m_service_jobs.remove(key);
+    for (auto serviceJob : m_service_jobs) {
+        if (!cancelService)
+            break;
+        if (serviceJob.first == uri)
+            cancelService = false;
+    }
+    m_cancelable_jobs_mutex.unlock();
+
+    //the service replies at once.
+    if (cancelService)
+        ThumbnailServiceClient::cancelThumbnail(uri);
+
+    int canceledPending = 0;
+    for (auto serial : m_pending_serials.values(uri)) {
+        for (int i = 0; i < JobKindCount; i++) {
+            auto it = m_pending_requests[i].find(serial);
+            if (it == m_pending_requests[i].end())
+                continue;
+            auto requestWatcher = it.value().watcher.lock();
+            if (requestWatcher == watcher || !requestWatcher) {
+                m_pending_requests[i].erase(it);
+                m_pending_serials.remove(uri, serial);
+                canceledPending++;
+            }
+        }
+    }
+
+    QMutexLocker locker(&m_statistics_mutex);
+    m_statistics.canceledPending += canceledPending;
+    if (running)
+        m_statistics.canceledRunning++;
 }
 
 void ThumbnailManager::updateDesktopFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher)
@@ -409,24 +1099,56 @@ void ThumbnailManager::updateDesktopFileThumbnail(const QString &uri, std::share
 
 void ThumbnailManager::clearThumbnail()
 {
-    m_semaphore->acquire();
-    if (!m_hash.isEmpty()) {
-        m_hash.clear();
-    }
-    m_semaphore->release();
+    QWriteLocker locker(&m_cache_lock);
+    m_hash.clear();
+    m_evicted_uris.clear();
+    m_cache_bytes = 0;
 }
 
 void ThumbnailManager::releaseThumbnail(const QString &uri)
 {
-    m_semaphore->acquire();
-    m_hash.remove(uri);
-    m_semaphore->release();
+    QWriteLocker locker(&m_cache_lock);
+    auto entry = m_hash.take(uri);
+    if (entry)
+        m_cache_bytes -= entry->cost;
+    m_evicted_uris.remove(uri);
+}
+
+bool ThumbnailManager::hasThumbnail(const QString &uri)
+{
+    QReadLocker locker(&m_cache_lock);
+    return m_hash.contains(uri);
 }
 
 const QIcon ThumbnailManager::tryGetThumbnail(const QString &uri)
 {
-    m_semaphore->acquire();
-    auto icon = m_hash.value(uri);
-    m_semaphore->release();
-    return icon;
+    QReadLocker locker(&m_cache_lock);
+    auto entry = m_hash.value(uri);
+    if (!entry) {
+        m_misses.fetchAndAddRelaxed(1);
+        return QIcon();
+    }
+
+    m_hits.fetchAndAddRelaxed(1);
+    entry->lastUsed.store(m_use_clock.fetchAndAddRelaxed(1) + 1);
+    return entry->icon;
+}
+
+bool ThumbnailManager::thumbnailHasShadow(const QString &uri)
+{
+    QReadLocker locker(&m_cache_lock);
+    auto entry = m_hash.value(uri);
+    return entry && entry->shadow;
+}
+
+bool ThumbnailManager::takeEvictedThumbnail(const QString &uri)
+{
+    {
+        QReadLocker locker(&m_cache_lock);
+        if (!m_evicted_uris.contains(uri))
+            return false;
+    }
+
+    QWriteLocker locker(&m_cache_lock);
+    return m_evicted_uris.remove(uri);
 }
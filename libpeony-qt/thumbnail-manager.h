@@ -28,48 +28,350 @@
 #include "file-info.h"
 
 #include <QHash>
+#include <QSet>
+#include <QMap>
+#include <QPair>
 #include <QIcon>
 #include <QMutex>
+#include <QReadWriteLock>
+#include <QAtomicInteger>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QJsonObject>
 
 class QThreadPool;
-class QSemaphore;
 
 namespace Peony {
 
 class FileWatcher;
 
+/*!
+ * \brief The ThumbnailCacheStatistics struct
+ * counters of the in-memory thumbnail cache, see ThumbnailManager::cacheStatistics().
+ */
+struct ThumbnailCacheStatistics {
+    quint64 hits = 0;
+    quint64 misses = 0;
+    quint64 evictions = 0;
+    int count = 0;
+    qint64 bytes = 0;
+    qint64 budget = 0;
+};
+
+/*!
+ * \brief The ThumbnailTimeStatistics struct
+ * count and elapsed time of a pipeline stage, in microseconds.
+ */
+struct ThumbnailTimeStatistics {
+    quint64 count = 0;
+    quint64 failures = 0;
+    qint64 totalUsec = 0;
+    qint64 maxUsec = 0;
+
+    void add(qint64 usec, bool failed = false) {
+        count++;
+        if (failed)
+            failures++;
+        totalUsec += usec;
+        maxUsec = qMax(maxUsec, usec);
+    }
+};
+
+/*!
+ * \brief The ThumbnailStatistics struct
+ * <br>
+ * Counters of the thumbnail pipeline of this process since it started or
+ * ThumbnailManager::resetStatistics() was called.
+ * queueWait is the time a request waited for a worker, decode is the time
+ * spent on generating thumbnails in process by mime class, service is the
+ * time waited for peony-thumbnailer.
+ * </br>
+ * \see ThumbnailManager::statistics().
+ */
+struct PEONYCORESHARED_EXPORT ThumbnailStatistics {
+    enum MimeClass {
+        ImageClass,
+        SvgClass,
+        PdfClass,
+        DjvuClass,
+        VideoClass,
+        OfficeClass,
+        DesktopClass,
+        MimeClassCount
+    };
+
+    //requests queued, repeated by the same model, and dropped with their models.
+    quint64 requests = 0;
+    quint64 mergedRequests = 0;
+    quint64 droppedRequests = 0;
+    //canceled before or after they were started.
+    quint64 canceledPending = 0;
+    quint64 canceledRunning = 0;
+    //pending requests served by a thumbnail which another client asked for.
+    quint64 sharedRequests = 0;
+
+    quint64 diskHits = 0;
+    quint64 diskFailureHits = 0;
+    quint64 diskMisses = 0;
+
+    ThumbnailTimeStatistics queueWait;
+    ThumbnailTimeStatistics decode[MimeClassCount];
+    ThumbnailTimeStatistics service;
+
+    ThumbnailCacheStatistics memory;
+
+    static QString mimeClassName(int mimeClass);
+    /*!
+     * \brief toJson
+     * \return the statistics with the hit rates and average times, as
+     * a json object which is used by D-Bus query and benchmarks.
+     */
+    QJsonObject toJson() const;
+};
+
+/*!
+ * \brief The ThumbnailManager class
+ * <br>
+ * ThumbnailManager generates thumbnails in its thread pool and keeps them
+ * in memory. The memory cache is bounded by a byte budget counted from the
+ * pixel size of the icons, the least recently used thumbnails are evicted
+ * once it is exceeded. The budget could be set with setCacheBudget() or the
+ * THUMBNAIL_MEMORY_BUDGET setting.
+ * </br>
+ * <br>
+ * tryGetThumbnail() is called in painting, it only takes a read lock, so
+ * readers never wait for each other.
+ * </br>
+ */
 class PEONYCORESHARED_EXPORT ThumbnailManager : public QObject
 {
     friend class ThumbnailJob;
     Q_OBJECT
 public:
+    /*!
+     * \brief The JobKind enum
+     * Generic jobs decode in process, video and office jobs spawn heavy
+     * converters, so they have their own concurrency limits.
+     */
+    enum JobKind {
+        GenericJob,
+        VideoJob,
+        OfficeJob,
+        JobKindCount
+    };
+
     static ThumbnailManager *getInstance();
 
     void setForbidThumbnailInView(bool forbid);
 
-    bool hasThumbnail(const QString &uri) {
-        return !m_hash.values(uri).isEmpty();
-    }
+    bool hasThumbnail(const QString &uri);
 
     void createThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher = nullptr, bool force = false);
     void clearThumbnail();
     void releaseThumbnail(const QString &uri);
     void updateDesktopFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher = nullptr);
     const QIcon tryGetThumbnail(const QString &uri);
+    /*!
+     * \brief thumbnailHasShadow
+     * \param uri
+     * \return true if the thumbnail of uri is an opaque image, which the
+     * delegates decorate with a drop shadow when they paint it.
+     * \see ThumbnailShadow.
+     */
+    bool thumbnailHasShadow(const QString &uri);
+
+    /*!
+     * \brief takeEvictedThumbnail
+     * \param uri
+     * \return true if the thumbnail of uri was evicted from memory. It returns
+     * true only once, the caller should request the thumbnail again, which is
+     * usually loaded from the disk cache.
+     */
+    bool takeEvictedThumbnail(const QString &uri);
+
+    void setCacheBudget(qint64 bytes);
+    qint64 cacheBudget();
+    ThumbnailCacheStatistics cacheStatistics();
+
+    /*!
+     * \brief statistics
+     * \return the counters of thumbnail pipeline, including cacheStatistics().
+     */
+    ThumbnailStatistics statistics();
+    void resetStatistics();
+
+    /*!
+     * \brief setVisibleUris
+     * \param view, the view showing the uris, it is only used as a key.
+     * \param uris, the uris of the rows in view's viewport.
+     * <br>
+     * The pending requests of visible uris are started before the others,
+     * the requests of rows scrolled away wait until nothing visible is pending.
+     * The uris of a view are dropped when it is destroyed.
+     * </br>
+     */
+    void setVisibleUris(QObject *view, const QStringList &uris);
+    void clearVisibleUris(QObject *view);
+
+    /*!
+     * \brief cancelThumbnail
+     * \param uri
+     * \param watcher
+     * remove the pending request of uri from watcher, if it has not been started.
+     * A running video thumbnail job is aborted.
+     */
+    void cancelThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher);
+
+    /*!
+     * \brief generateThumbnailImage
+     * \param uri
+     * \param failed, set to true if the file can not be thumbnailed.
+     * \return the thumbnail image of a picture, pdf, djvu, video or office
+     * file, generated in calling thread.
+     * <br>
+     * The image is saved into the disk cache, but not inserted into the
+     * memory cache. This is used by the worker processes of peony-thumbnailer.
+     * </br>
+     */
+    QImage generateThumbnailImage(const QString &uri, bool *failed = nullptr);
+    /*!
+     * \brief markThumbnailFailed
+     * \param uri
+     * leave a failure marker of uri in the disk cache, peony-thumbnailer
+     * calls it when a worker crashed or timed out on uri.
+     */
+    static void markThumbnailFailed(const QString &uri);
+    /*!
+     * \brief kindLimit
+     * \param kind, a JobKind.
+     * \param maxWorkers, the count of jobs running at most.
+     * \return the count of jobs of kind running at most, peony-thumbnailer
+     * limits its workers in the same way.
+     */
+    static int kindLimit(int kind, int maxWorkers);
 
 Q_SIGNALS:
+    /*!
+     * \brief thumbnailReady
+     * \param uri
+     * the thumbnail of uri was inserted into the memory cache, it might
+     * be emitted in a thumbnail thread. Views update the items of uri.
+     */
+    void thumbnailReady(const QString &uri);
 
 public Q_SLOTS:
     void syncThumbnailPreferences();
 
+protected Q_SLOTS:
+    void onThumbnailJobFinished(int kind);
+    /*!
+     * \brief onServiceThumbnailReady
+     * \param uri
+     * peony-thumbnailer generated uri for any client, the requests of uri
+     * still pending here are served from the disk cache. The thumbnail is
+     * loaded in a thumbnail thread, not to read and decode it in ui thread.
+     */
+    void onServiceThumbnailReady(const QString &uri);
+    /*!
+     * \brief onServiceThumbnailLoaded
+     * \param uri
+     * \param loaded, true if the thumbnail or failure marker of uri was
+     * loaded from the disk cache, then the pending requests of uri are dropped.
+     */
+    void onServiceThumbnailLoaded(const QString &uri, bool loaded);
+
 protected:
-    void insertOrUpdateThumbnail(const QString &uri, const QIcon &icon);
+    void insertOrUpdateThumbnail(const QString &uri, const QIcon &icon, bool shadow = false);
 
 private:
+    /*!
+     * \brief The ThumbnailEntry struct
+     * lastUsed is a stamp of m_use_clock, it is updated under the read lock.
+     */
+    struct ThumbnailEntry {
+        QIcon icon;
+        qint64 cost = 0;
+        bool shadow = false;
+        QAtomicInteger<quint64> lastUsed;
+    };
+
+    /*!
+     * \brief The ThumbnailRequest struct
+     * A request waiting for a worker, serial is the order it was queued in.
+     */
+    struct ThumbnailRequest {
+        QString uri;
+        std::weak_ptr<FileWatcher> watcher;
+        JobKind kind = GenericJob;
+        quint64 serial = 0;
+        qint64 queuedTime = 0;
+    };
+
     explicit ThumbnailManager(QObject *parent = nullptr);
     ~ThumbnailManager();
     void createThumbnailInternal(const QString &uri, std::shared_ptr<FileWatcher> watcher = nullptr, bool force = false);
 
+    /*!
+     * \brief localPath
+     * \return the local path of uri's target, or an empty string if it is not local.
+     */
+    static QString localPath(const QString &uri);
+    /*!
+     * \brief loadCachedThumbnail
+     * \return true if there is a valid thumbnail or failure marker of uri in
+     * ThumbnailCache, the thumbnail is inserted if there is one.
+     */
+    bool loadCachedThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher);
+    /*!
+     * \brief insertGeneratedThumbnail
+     * \param image, the generated thumbnail without decoration.
+     * \param failed, true if a null image means the file can not be thumbnailed.
+     * save the image into ThumbnailCache, and insert its icon.
+     */
+    void insertGeneratedThumbnail(const QString &uri, const QImage &image, bool failed, std::shared_ptr<FileWatcher> watcher);
+    void insertThumbnailImage(const QString &uri, const QImage &image);
+    /*!
+     * \brief loadServiceThumbnail
+     * \return true if peony-thumbnailer handled the request, whether the
+     * thumbnail was generated or not. false if the service is unavailable,
+     * then the thumbnail is generated in process.
+     * \see ThumbnailServiceClient.
+     */
+    bool loadServiceThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher, JobKind kind = GenericJob);
+
+    void queueThumbnailRequest(const QString &uri, std::shared_ptr<FileWatcher> watcher, JobKind kind);
+    /*!
+     * \brief schedule
+     * start pending requests until there is no free worker,
+     * or the kinds of all pending requests reach their limits.
+     */
+    void schedule();
+    bool takeRequest(ThumbnailRequest &request);
+
+    static qint64 iconCost(const QIcon &icon);
+    /*!
+     * \brief evictThumbnails
+     * drop the least recently used thumbnails until the cache is somewhat
+     * below the budget, so that eviction does not happen at every insertion.
+     * \note call it with the write lock held.
+     */
+    void evictThumbnails();
+
+    /*!
+     * \brief isThumbnailCanceled
+     * \return true if cancelThumbnail() was called for uri and watcher after
+     * its running job started. It is polled in the thumbnail thread.
+     */
+    bool isThumbnailCanceled(const QString &uri, std::shared_ptr<FileWatcher> watcher);
+
+    /*!
+     * \brief recordDecode
+     * \param timer, started before the thumbnail was generated.
+     * they are called in thumbnail threads.
+     */
+    void recordDecode(ThumbnailStatistics::MimeClass mimeClass, const QElapsedTimer &timer, bool failed);
+    void recordDroppedRequest();
+
     void createVideFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher);
     void createPdfFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher);
     void createImageFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher);
@@ -80,11 +382,65 @@ private:
     void findAtril();
     void createImagePdfFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher);
 
-    QHash<QString, QIcon> m_hash;
-    //QMutex m_mutex;
+    QHash<QString, std::shared_ptr<ThumbnailEntry>> m_hash;
+    QSet<QString> m_evicted_uris;
+    QReadWriteLock m_cache_lock;
+    qint64 m_cache_bytes = 0;
+    qint64 m_cache_budget = 0;
+
+    QAtomicInteger<quint64> m_use_clock;
+    QAtomicInteger<quint64> m_hits;
+    QAtomicInteger<quint64> m_misses;
+    quint64 m_evictions = 0;
 
     QThreadPool *m_thumbnail_thread_pool;
-    QSemaphore *m_semaphore;
+
+    /*!
+     * \brief m_pending_requests
+     * pending requests of each kind ordered by serial, m_pending_serials
+     * indexes them by uri. They are only touched in main thread.
+     */
+    QMap<quint64, ThumbnailRequest> m_pending_requests[JobKindCount];
+    QMultiHash<QString, quint64> m_pending_serials;
+    quint64 m_request_serial = 0;
+
+    QHash<QObject*, QStringList> m_visible_uris;
+
+    /*!
+     * \brief m_service_ready_uris
+     * the uris generated by peony-thumbnailer for other clients, which are
+     * being loaded from the disk cache.
+     */
+    QSet<QString> m_service_ready_uris;
+
+    /*!
+     * \brief m_cancelable_jobs
+     * the running jobs which can be aborted and whether they were canceled,
+     * keyed by uri and watcher. They are guarded by m_cancelable_jobs_mutex.
+     */
+    QHash<QPair<QString, quintptr>, bool> m_cancelable_jobs;
+    /*!
+     * \brief m_service_jobs
+     * the running jobs waiting for peony-thumbnailer and not canceled. The
+     * service cancels all the requests of uri from this process at once,
+     * so it is told only when the last one of uri is canceled. They are
+     * also guarded by m_cancelable_jobs_mutex.
+     */
+    QSet<QPair<QString, quintptr>> m_service_jobs;
+    QMutex m_cancelable_jobs_mutex;
+
+    /*!
+     * \brief m_statistics
+     * guarded by m_statistics_mutex, except memory which is taken from
+     * cacheStatistics() when queried.
+     */
+    ThumbnailStatistics m_statistics;
+    QMutex m_statistics_mutex;
+    QElapsedTimer m_clock;
+
+    int m_running_jobs[JobKindCount] = {0, 0, 0};
+    int m_running_count = 0;
+    int m_max_workers = 1;
 };
 
 }
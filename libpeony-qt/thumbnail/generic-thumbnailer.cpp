@@ -21,6 +21,7 @@
  */
 
 #include "generic-thumbnailer.h"
+#include "image-icon-engine.h"
 #include <QIcon>
 
 #include <QUrl>
@@ -28,64 +29,137 @@
 #include <QFileInfo>
 #include<QDir>
 #include <QPainter>
+#include <QImageReader>
+#include <QTransform>
+#include <QtEndian>
 #include <QMessageAuthenticationCode>
 #include<QDesktopServices>
 
 extern void qt_blurImage(QImage &blurImage, qreal radius, bool quality, int transposed);
 
-QIcon GenericThumbnailer::generateThumbnail(const QUrl &url, bool shadow, const QSize &size)
-{
-    QIcon icon;
-    QFile file(url.path());
-    if (!file.exists())
-        return icon;
+//the thumbnail width of generateThumbnail().
+#define THUMBNAIL_WIDTH 128
 
-    //skip svg
-    if (url.path().endsWith(".svg")) {
-        if (file.size() < 1024*1024*8)
-            icon.addFile(url.path());
-        return icon;
-    }
+//embedded previews whose aspect ratio differs more than this from the image are letterboxed.
+#define EXIF_PREVIEW_ASPECT_TOLERANCE 0.02
 
-    QImage img(url.path());
+static quint16 readUInt16(const QByteArray &data, int offset, bool bigEndian)
+{
+    if (offset < 0 || offset + 2 > data.size())
+        return 0;
+    auto p = reinterpret_cast<const uchar *>(data.constData()) + offset;
+    return bigEndian? qFromBigEndian<quint16>(p): qFromLittleEndian<quint16>(p);
+}
+
+static quint32 readUInt32(const QByteArray &data, int offset, bool bigEndian)
+{
+    if (offset < 0 || offset + 4 > data.size())
+        return 0;
+    auto p = reinterpret_cast<const uchar *>(data.constData()) + offset;
+    return bigEndian? qFromBigEndian<quint32>(p): qFromLittleEndian<quint32>(p);
+}
 
-    if (img.rect().size().width() > 128) {
-        //scale large size image.
-        if (size.isValid()) {
-            img = img.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-        } else {
-            img = img.scaledToWidth(128, Qt::SmoothTransformation);
+/*!
+ * \brief readExifPreview
+ * \param path, a jpeg file.
+ * \param preview, the embedded jpeg thumbnail of IFD1, if there is one.
+ * \param orientation, the exif orientation of image, 1 if there is none.
+ * \return true if the exif segment was found.
+ * \note only the markers in front of image data are read, the image itself is never loaded.
+ */
+static bool readExifPreview(const QString &path, QByteArray &preview, int &orientation)
+{
+    orientation = 1;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    if (file.read(2) != QByteArray("\xFF\xD8", 2))
+        return false;
+
+    QByteArray tiff;
+    while (!file.atEnd()) {
+        QByteArray marker = file.read(4);
+        if (marker.size() < 4 || uchar(marker.at(0)) != 0xFF)
+            return false;
+        uchar type = uchar(marker.at(1));
+        int length = readUInt16(marker, 2, true) - 2;
+        //start of scan, there is no more metadata.
+        if (type == 0xDA || length < 0)
+            return false;
+        if (type == 0xE1) {
+            QByteArray segment = file.read(length);
+            if (segment.startsWith(QByteArray("Exif\0\0", 6))) {
+                tiff = segment.mid(6);
+                break;
+            }
+        } else if (!file.seek(file.pos() + length)) {
+            return false;
         }
     }
-
-    if (img.hasAlphaChannel()) {
-        //skip shadow
-        icon.addPixmap(QPixmap::fromImage(img));
-        return icon;
+    if (tiff.size() < 8)
+        return false;
+
+    bool bigEndian = tiff.startsWith("MM");
+    if (!bigEndian && !tiff.startsWith("II"))
+        return false;
+
+    //IFD0 holds orientation, IFD1 describes the embedded thumbnail.
+    int ifd0 = readUInt32(tiff, 4, bigEndian);
+    int count = readUInt16(tiff, ifd0, bigEndian);
+    for (int i = 0; i < count; i++) {
+        int entry = ifd0 + 2 + i*12;
+        if (readUInt16(tiff, entry, bigEndian) == 0x0112)
+            orientation = readUInt16(tiff, entry + 8, bigEndian);
     }
+    if (orientation < 1 || orientation > 8)
+        orientation = 1;
+
+    int ifd1 = readUInt32(tiff, ifd0 + 2 + count*12, bigEndian);
+    if (ifd1 <= 0)
+        return true;
+    quint32 offset = 0;
+    quint32 size = 0;
+    count = readUInt16(tiff, ifd1, bigEndian);
+    for (int i = 0; i < count; i++) {
+        int entry = ifd1 + 2 + i*12;
+        quint16 tag = readUInt16(tiff, entry, bigEndian);
+        if (tag == 0x0201)
+            offset = readUInt32(tiff, entry + 8, bigEndian);
+        else if (tag == 0x0202)
+            size = readUInt32(tiff, entry + 8, bigEndian);
+    }
+    if (offset > 0 && size > 0 && offset + size <= quint32(tiff.size()))
+        preview = tiff.mid(offset, size);
 
-    if (shadow) {
-        QPixmap pixmap = QPixmap::fromImage(img);
-        pixmap = pixmap.scaled(img.rect().adjusted(4, 4, -4, -4).size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-
-        QImage newImg(img.size(), QImage::Format_ARGB32);
-        newImg.fill(Qt::transparent);
-        QPainter p(&newImg);
-
-        p.setPen(Qt::transparent);
-        p.setBrush(Qt::gray);
-        p.drawRect(newImg.rect().adjusted(4, 4, -4, -4));
-
-        qt_blurImage(newImg, 4, false, false);
-        p.drawPixmap(newImg.rect().adjusted(4, 4, -4, -4), pixmap);
+    return true;
+}
 
-        p.end();
-        icon.addPixmap(QPixmap::fromImage(newImg));
-    } else {
-        icon.addPixmap(QPixmap::fromImage(img));
+static QImage applyExifOrientation(const QImage &image, int orientation)
+{
+    switch (orientation) {
+    case 2:
+        return image.mirrored(true, false);
+    case 3:
+        return image.mirrored(true, true);
+    case 4:
+        return image.mirrored(false, true);
+    case 5:
+        return image.mirrored(true, false).transformed(QTransform().rotate(270));
+    case 6:
+        return image.transformed(QTransform().rotate(90));
+    case 7:
+        return image.mirrored(true, false).transformed(QTransform().rotate(90));
+    case 8:
+        return image.transformed(QTransform().rotate(270));
+    default:
+        return image;
     }
+}
 
-    return icon;
+QIcon GenericThumbnailer::generateThumbnail(const QUrl &url, bool shadow, const QSize &size)
+{
+    return generateThumbnail(url.path(), shadow, size);
 }
 
 QIcon GenericThumbnailer::generateThumbnail(const QString &path, bool shadow, const QSize &size)
@@ -102,25 +176,72 @@ QIcon GenericThumbnailer::generateThumbnail(const QString &path, bool shadow, co
         return icon;
     }
 
-    QImage img(path);
-    if (img.rect().size().width() > 128) {
-        //scale large size image.
-        if (size.isValid()) {
-            img = img.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-        } else {
-            img = img.scaledToWidth(128, Qt::SmoothTransformation);
+    return generateThumbnailFromImage(scaledImage(path, size), shadow);
+}
+
+QImage GenericThumbnailer::scaledImage(const QString &path, const QSize &size)
+{
+    QImageReader reader(path);
+    reader.setAutoTransform(true);
+    QSize imageSize = reader.size();
+    if (!imageSize.isValid()) {
+        //the format can not tell its size without decoding.
+        QImage img = reader.read();
+        if (img.width() > THUMBNAIL_WIDTH) {
+            if (size.isValid()) {
+                img = img.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+            } else {
+                img = img.scaledToWidth(THUMBNAIL_WIDTH, Qt::SmoothTransformation);
+            }
+        }
+        return img;
+    }
+
+    //the size of reader is the stored one, the orientation is applied after decoding.
+    bool transposed = reader.transformation() & QImageIOHandler::TransformationRotate90;
+    QSize orientedSize = transposed? imageSize.transposed(): imageSize;
+    if (orientedSize.width() <= THUMBNAIL_WIDTH)
+        return reader.read();
+
+    QSize targetSize = size;
+    if (!targetSize.isValid())
+        targetSize = QSize(THUMBNAIL_WIDTH, qMax(1, orientedSize.height() * THUMBNAIL_WIDTH / orientedSize.width()));
+
+    //cameras embed a small preview, use it if it is large enough and not letterboxed.
+    if (reader.format() == "jpeg" || reader.format() == "jpg") {
+        QByteArray previewData;
+        int orientation = 1;
+        if (readExifPreview(path, previewData, orientation) && !previewData.isEmpty()) {
+            QImage preview = applyExifOrientation(QImage::fromData(previewData, "jpeg"), orientation);
+            qreal imageAspect = qreal(orientedSize.width()) / orientedSize.height();
+            if (!preview.isNull()
+                    && preview.width() >= targetSize.width()
+                    && preview.height() >= targetSize.height()
+                    && qAbs(qreal(preview.width()) / preview.height() - imageAspect) <= imageAspect * EXIF_PREVIEW_ASPECT_TOLERANCE) {
+                return preview.scaled(targetSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+            }
         }
     }
 
+    //let the decoder scale, jpeg is scaled in DCT domain and never fully decoded.
+    reader.setScaledSize(transposed? targetSize.transposed(): targetSize);
+    return reader.read();
+}
+
+QIcon GenericThumbnailer::generateThumbnailFromImage(const QImage &img, bool shadow)
+{
+    QIcon icon;
+    if (img.isNull())
+        return icon;
+
+    //this runs in thumbnail threads, do not touch QPixmap here.
     if (img.hasAlphaChannel()) {
         //skip shadow
-        icon.addPixmap(QPixmap::fromImage(img));
-        return icon;
+        return QIcon(new ImageIconEngine(img));
     }
 
     if (shadow) {
-        QPixmap pixmap = QPixmap::fromImage(img);
-        pixmap = pixmap.scaled(img.rect().adjusted(4, 4, -4, -4).size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        QImage scaled = img.scaled(img.rect().adjusted(4, 4, -4, -4).size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
 
         QImage newImg(img.size(), QImage::Format_ARGB32);
         newImg.fill(Qt::transparent);
@@ -131,12 +252,12 @@ QIcon GenericThumbnailer::generateThumbnail(const QString &path, bool shadow, co
         p.drawRect(newImg.rect().adjusted(4, 4, -4, -4));
 
         qt_blurImage(newImg, 4, false, false);
-        p.drawPixmap(newImg.rect().adjusted(4, 4, -4, -4), pixmap);
+        p.drawImage(newImg.rect().adjusted(4, 4, -4, -4), scaled);
 
         p.end();
-        icon.addPixmap(QPixmap::fromImage(newImg));
+        icon = QIcon(new ImageIconEngine(newImg));
     } else {
-        icon.addPixmap(QPixmap::fromImage(img));
+        icon = QIcon(new ImageIconEngine(img));
     }
 
     return icon;
@@ -193,14 +314,6 @@ QString GenericThumbnailer::codeMd5(QString fileName)
     return code.result().toHex();
 }
 
-QString GenericThumbnailer::codeMd5WithModifyTime(QString fileName, quint64 &modifyTime)
-{
-    QString contentText = fileName + QString::number(modifyTime);
-    QMessageAuthenticationCode code(QCryptographicHash::Md5);
-    code.addData(contentText.toUtf8());
-    return code.result().toHex();
-}
-
 QString GenericThumbnailer::cachDir()
 {
     QString location;
@@ -215,17 +328,3 @@ QString GenericThumbnailer::cachDir()
         dir.mkpath(".");
     return location;
 }
-
-QString GenericThumbnailer::thumbnaileCachDir()
-{
-    QString location="/tmp/.cache/peony";
-    location+="/thumbnails";
-
-    QDir dir(location);
-    if(!dir.exists())
-    {
-        dir.mkpath(".");
-    }
-
-    return location;
-}
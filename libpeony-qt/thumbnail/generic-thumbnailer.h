@@ -25,6 +25,7 @@
 
 #include <QObject>
 #include <QSize>
+#include <QImage>
 
 class GenericThumbnailer : public QObject
 {
@@ -33,10 +34,25 @@ public:
     static QIcon generateThumbnail(const QUrl &url, bool shadow = false, const QSize &size = QSize());
     static QIcon generateThumbnail(const QString &path, bool shadow = false, const QSize &size = QSize());
     static QIcon generateThumbnail(const QPixmap &pixmap, bool shadow = true, const QSize &size = QSize());
+    /*!
+     * \brief scaledImage
+     * \return the image of path, scaled as generateThumbnail(path) does.
+     * <br>
+     * The image is decoded at the target size (jpeg is scaled while decoding),
+     * the embedded exif preview of a camera jpeg is used instead if it is large
+     * enough, and the exif orientation is applied.
+     * </br>
+     */
+    static QImage scaledImage(const QString &path, const QSize &size = QSize());
+    /*!
+     * \brief generateThumbnailFromImage
+     * \return the icon of an already scaled image, such as a cached thumbnail.
+     * \note it is safe to call in thread pool, the icon holds the image until it is painted.
+     * \see ImageIconEngine.
+     */
+    static QIcon generateThumbnailFromImage(const QImage &img, bool shadow = true);
     static QString codeMd5(QString fileName);
-    static QString codeMd5WithModifyTime(QString fileName, quint64 &modifyTime);
     static QString cachDir();
-    static QString thumbnaileCachDir();
 private:
     explicit GenericThumbnailer(QObject *parent = nullptr);
 };
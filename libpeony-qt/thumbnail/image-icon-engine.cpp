@@ -0,0 +1,91 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#include "image-icon-engine.h"
+
+#include <QApplication>
+#include <QPainter>
+#include <QStyle>
+#include <QStyleOption>
+
+ImageIconEngine::ImageIconEngine(const QImage &image)
+{
+    m_image = image;
+}
+
+void ImageIconEngine::paint(QPainter *painter, const QRect &rect, QIcon::Mode mode, QIcon::State state)
+{
+    QPixmap pix = pixmap(rect.size() * painter->device()->devicePixelRatioF(), mode, state);
+    painter->drawPixmap(rect, pix);
+}
+
+QPixmap ImageIconEngine::pixmap(const QSize &size, QIcon::Mode mode, QIcon::State state)
+{
+    //converted once, in main thread.
+    if (m_pixmap.isNull() && !m_image.isNull())
+        m_pixmap = QPixmap::fromImage(m_image);
+
+    QPixmap pix = m_pixmap;
+    QSize targetSize = actualSize(size, mode, state);
+    if (!pix.isNull() && targetSize != pix.size())
+        pix = pix.scaled(targetSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+    if (mode != QIcon::Normal && !pix.isNull()) {
+        QStyleOption opt(0);
+        opt.palette = QApplication::palette();
+        pix = QApplication::style()->generatedIconPixmap(mode, pix, &opt);
+    }
+
+    return pix;
+}
+
+QSize ImageIconEngine::actualSize(const QSize &size, QIcon::Mode mode, QIcon::State state)
+{
+    Q_UNUSED(mode)
+    Q_UNUSED(state)
+    QSize imageSize = m_image.size();
+    //never scale up, as QIcon does with pixmaps.
+    if (imageSize.width() > size.width() || imageSize.height() > size.height())
+        imageSize.scale(size, Qt::KeepAspectRatio);
+    return imageSize;
+}
+
+QList<QSize> ImageIconEngine::availableSizes(QIcon::Mode mode, QIcon::State state) const
+{
+    Q_UNUSED(mode)
+    Q_UNUSED(state)
+    QList<QSize> sizes;
+    if (!m_image.isNull())
+        sizes<<m_image.size();
+    return sizes;
+}
+
+QIconEngine *ImageIconEngine::clone() const
+{
+    return new ImageIconEngine(m_image);
+}
+
+QString ImageIconEngine::key() const
+{
+    return QStringLiteral("ImageIconEngine");
+}
@@ -0,0 +1,57 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#ifndef IMAGEICONENGINE_H
+#define IMAGEICONENGINE_H
+
+#include <QIconEngine>
+#include <QImage>
+#include <QPixmap>
+
+/*!
+ * \brief The ImageIconEngine class
+ * <br>
+ * An icon engine holding a QImage. Thumbnails are generated in thread pool,
+ * where QPixmap must not be used, so the icons of thumbnails keep the image
+ * and convert it to pixmap when it is painted in main thread.
+ * </br>
+ * \see GenericThumbnailer::generateThumbnailFromImage().
+ */
+class ImageIconEngine : public QIconEngine
+{
+public:
+    explicit ImageIconEngine(const QImage &image);
+
+    void paint(QPainter *painter, const QRect &rect, QIcon::Mode mode, QIcon::State state) override;
+    QPixmap pixmap(const QSize &size, QIcon::Mode mode, QIcon::State state) override;
+    QSize actualSize(const QSize &size, QIcon::Mode mode, QIcon::State state) override;
+    QList<QSize> availableSizes(QIcon::Mode mode = QIcon::Normal, QIcon::State state = QIcon::Off) const override;
+    QIconEngine *clone() const override;
+    QString key() const override;
+
+private:
+    QImage m_image;
+    QPixmap m_pixmap;
+};
+
+#endif // IMAGEICONENGINE_H
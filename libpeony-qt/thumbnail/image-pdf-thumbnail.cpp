@@ -30,6 +30,7 @@
 #include <QMessageAuthenticationCode>
 #include <QPainter>
 #include <QImageReader>
+#include <QProcess>
 #include <qglobal.h>
 
 ImagePdfThumbnail::ImagePdfThumbnail(const QString &uri)
@@ -51,10 +52,33 @@ ImagePdfThumbnail::~ImagePdfThumbnail()
 
 }
 
-QIcon ImagePdfThumbnail::generateThumbnail()
+QImage ImagePdfThumbnail::generateThumbnail(const QSize &size)
 {
-    //FIXME need support to preview
-    QIcon thumbnailImage = QIcon::fromTheme("atril");
+    QImage thumbnailImage;
+
+    //ddjvu decodes the page at the resolution which fits size, and writes it to stdout.
+    //ddjvu -format=ppm -page=1 -size=128x512 test.djvu
+    QStringList list;
+    list<<"-format=ppm"
+        <<"-page=1"
+        <<QString("-size=%1x%2").arg(size.width()).arg(size.height())
+        <<m_url.path();
+
+    QProcess p;
+    p.start("ddjvu", list);
+    if (!p.waitForStarted()) {
+        return thumbnailImage;
+    }
+
+    if (!p.waitForFinished()) {
+        p.kill();
+        p.waitForFinished();
+        return thumbnailImage;
+    }
+
+    thumbnailImage.loadFromData(p.readAllStandardOutput(), "PPM");
+    m_failed = thumbnailImage.isNull();
+
     return thumbnailImage;
 }
 
@@ -25,7 +25,8 @@
 
 #include "file-info.h"
 #include <QHash>
-#include <QIcon>
+#include <QImage>
+#include <QSize>
 #include <QMutex>
 #include <QUrl>
 
@@ -35,7 +36,20 @@ class ImagePdfThumbnail{
 public:
     explicit ImagePdfThumbnail(const QString &uri);
     ~ImagePdfThumbnail();
-    QIcon generateThumbnail();
+    /*!
+     * \brief generateThumbnail
+     * \param size, the box the first page fits in.
+     * \return the first page rendered by ddjvu at the resolution of size,
+     * or a null image.
+     */
+    QImage generateThumbnail(const QSize &size = QSize(128, 512));
+    /*!
+     * \brief failed
+     * \return true if ddjvu ran but there is no image.
+     */
+    bool failed() {
+        return m_failed;
+    }
 
 private:
     /*
@@ -49,6 +63,7 @@ private:
     * 主要是为了处理修改文件首页的情况
     */
     quint64 m_modifyTime = 0;
+    bool m_failed = false;
 };
 
 #endif // IMAGEPDFTHUMBNAIL_H
@@ -0,0 +1,163 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: renpeijia <renpeijia@kylinos.cn>
+ *
+ */
+
+
+#include "office-converter.h"
+#include "generic-thumbnailer.h"
+
+#include <QFileInfo>
+#include <QDir>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QUrl>
+#include <QDebug>
+
+//the documents converted by one libreoffice process at most.
+#ifndef PEONY_OFFICE_CONVERT_BATCH
+#define PEONY_OFFICE_CONVERT_BATCH 16
+#endif
+
+//the time a document may take, in msec.
+#ifndef PEONY_OFFICE_CONVERT_TIMEOUT
+#define PEONY_OFFICE_CONVERT_TIMEOUT 30000
+#endif
+
+static OfficeConverter *global_instance = nullptr;
+
+OfficeConverter *OfficeConverter::getInstance()
+{
+    static QMutex mutex;
+    QMutexLocker locker(&mutex);
+    if (!global_instance)
+        global_instance = new OfficeConverter;
+    return global_instance;
+}
+
+QImage OfficeConverter::convert(const QString &path, bool *failed)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_queue.contains(path) && !m_converting.contains(path) && !m_results.contains(path))
+        m_queue<<path;
+    m_waiters[path]++;
+
+    while (true) {
+        auto result = m_results.find(path);
+        if (result != m_results.end()) {
+            Result done = result.value();
+            if (--m_waiters[path] == 0) {
+                m_waiters.remove(path);
+                m_results.erase(result);
+            }
+            if (failed)
+                *failed = done.failed;
+            return done.image;
+        }
+
+        if (m_running) {
+            m_condition.wait(&m_mutex);
+            continue;
+        }
+
+        //nobody is converting, this thread converts the whole queue.
+        QStringList batch = takeBatch();
+        m_running = true;
+        locker.unlock();
+
+        auto results = convertBatch(batch);
+
+        locker.relock();
+        m_running = false;
+        for (auto batchPath : batch) {
+            m_converting.remove(batchPath);
+            m_results.insert(batchPath, results.value(batchPath));
+        }
+        m_condition.wakeAll();
+    }
+}
+
+QStringList OfficeConverter::takeBatch()
+{
+    //libreoffice names the output by the file name, so the names in a batch must be unique.
+    QStringList batch;
+    QSet<QString> names;
+    for (auto it = m_queue.begin(); it != m_queue.end() && batch.count() < PEONY_OFFICE_CONVERT_BATCH;) {
+        QString name = QFileInfo(*it).completeBaseName();
+        if (names.contains(name)) {
+            ++it;
+            continue;
+        }
+        names<<name;
+        batch<<*it;
+        m_converting<<*it;
+        it = m_queue.erase(it);
+    }
+    return batch;
+}
+
+QHash<QString, OfficeConverter::Result> OfficeConverter::convertBatch(const QStringList &paths)
+{
+    QHash<QString, Result> results;
+    QTemporaryDir tmpDir;
+    if (!tmpDir.isValid())
+        return results;
+
+    QString profileDir = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/peony/office-profile";
+    QDir().mkpath(profileDir);
+
+    //libreoffice --headless --convert-to png --outdir ./ test1.doc test2.ppt
+    QStringList args;
+    args<<"--headless"
+        <<"--invisible"
+        <<"--norestore"
+        <<"-env:UserInstallation=" + QUrl::fromLocalFile(profileDir).toString()
+        <<"--convert-to"
+        <<"png"
+        <<"--outdir"
+        <<tmpDir.path();
+    args<<paths;
+
+    QProcess p;
+    p.start("libreoffice", args);
+    if (!p.waitForStarted()) {
+        qWarning()<<"libreoffice start failed, or timeout";
+        return results;
+    }
+
+    if (!p.waitForFinished(PEONY_OFFICE_CONVERT_TIMEOUT * paths.count())) {
+        qWarning()<<"libreoffice run failed, or timeout";
+        p.kill();
+        p.waitForFinished();
+        return results;
+    }
+
+    for (auto path : paths) {
+        Result result;
+        QString image = tmpDir.path() + "/" + QFileInfo(path).completeBaseName() + ".png";
+        result.image = GenericThumbnailer::scaledImage(image);
+        result.failed = result.image.isNull();
+        results.insert(path, result);
+    }
+
+    return results;
+}
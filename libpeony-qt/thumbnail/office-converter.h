@@ -0,0 +1,85 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: renpeijia <renpeijia@kylinos.cn>
+ *
+ */
+#ifndef OFFICETHUMBNAIL_H
+
+#ifndef OFFICECONVERTER_H
+#define OFFICECONVERTER_H
+
+#include <QHash>
+#include <QSet>
+#include <QImage>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QStringList>
+
+/*!
+ * \brief The OfficeConverter class
+ * <br>
+ * OfficeConverter renders the first page of documents without an embedded
+ * preview with headless libreoffice. libreoffice converts documents one by
+ * one in a single process, and starting it costs much more than converting
+ * a page. So there is only one converter process at a time, and the
+ * documents requested while it is running are converted together by the
+ * next one, instead of starting a process for each document.
+ * </br>
+ * \note
+ * The converter uses its own libreoffice profile in the cache directory,
+ * so it is neither slowed down by nor forwarded to a running libreoffice
+ * of user.
+ */
+class OfficeConverter
+{
+public:
+    static OfficeConverter *getInstance();
+
+    /*!
+     * \brief convert
+     * \param path, a local document.
+     * \param failed, set to true if libreoffice ran but could not convert the document.
+     * \return the scaled image of first page, or a null image.
+     * \note this blocks until the batch containing path is converted,
+     * do not call it in main thread.
+     */
+    QImage convert(const QString &path, bool *failed = nullptr);
+
+private:
+    struct Result {
+        QImage image;
+        bool failed = false;
+    };
+
+    OfficeConverter() {}
+
+    QStringList takeBatch();
+    QHash<QString, Result> convertBatch(const QStringList &paths);
+
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+
+    QStringList m_queue;
+    QSet<QString> m_converting;
+    QHash<QString, Result> m_results;
+    QHash<QString, int> m_waiters;
+    bool m_running = false;
+};
+
+#endif // OFFICECONVERTER_H
@@ -22,6 +22,7 @@
 
 #include "generic-thumbnailer.h"
 #include "office-thumbnail.h"
+#include "office-converter.h"
 #include "file-utils.h"
 #include <QFileInfo>
 #include <QDebug>
@@ -30,6 +31,7 @@
 #include <QMessageAuthenticationCode>
 #include <QPainter>
 #include <QImageReader>
+#include <private/qzipreader_p.h>
 #include <qglobal.h>
 
 OfficeThumbnail::OfficeThumbnail(const QString &uri)
@@ -53,14 +55,12 @@ OfficeThumbnail::~OfficeThumbnail()
 
 /*
 *函数功能：
-*1、提取office文件的缩略图，利用libreoffice将文件的首页转换为jpg图片，
-* 从而得到缩略图要显示的内容。
-*2、md5值是为了区分同名文件的情况，以及文件的是否修改，如果修改过，重新
-* 生成缩略图。
-*3、将转换后的jpg图片暂时存放到/tmp目录下，该目录时内存文件系统，读写速
-* 度快；只要系统重启，这些转换的图片就会清除，不需要主动删除，这样可以避免
-* 重复进行图片提取，缺点就是会占用一部分内存，由于桌面系统不会长时间运行，
-* 也就避免了文件堆积造成占用内存过高的情况。
+*1、提取office文件的缩略图，OOXML和ODF文件是zip包，大多数在包中保存了首页的预览图
+* (docProps/thumbnail.jpeg，Thumbnails/thumbnail.png)，直接读取，只需要几毫秒。
+*2、没有预览图的文件由OfficeConverter利用libreoffice将首页转换为图片，同时请求的
+* 文件由一个libreoffice进程一起转换，而不是每个文件启动一个进程。
+*3、生成的图片由ThumbnailManager保存到freedesktop标准的缩略图缓存中，缓存以文件的
+* uri和修改时间校验，如果修改过，重新生成缩略图。
 *
 * 性能测试（测试的内容有限，并不能够说明所有问题）：
 * 1、ppt的文件转换一页最慢的需要12s左右，这个时间和文件页数关系不大，但是ppt的
@@ -70,64 +70,34 @@ OfficeThumbnail::~OfficeThumbnail()
 * 页的文件，转换一页消耗的时间也要5s的时间。
 * 3、excel文件暂未测试
 * 4、转pdf的时间消耗，和文件的页数成正比，页数越多，时间消耗越长，时间消耗达到分钟级。
-*
-* 后续优化思路：
-* 1、寻找office的开发api，直接操作文件，避免转换的过程
-* 2、通过并发的提升性能，经过验证libreoffice是单进程处理，不可以并发
 */
-QIcon OfficeThumbnail::generateThumbnail()
+QImage OfficeThumbnail::generateThumbnail()
 {
-    QIcon thumbnailImage;
-    QString md5Name=GenericThumbnailer::codeMd5WithModifyTime(m_url.path(), m_modifyTime);
-    QString thumbnail_dir= GenericThumbnailer::thumbnaileCachDir() + "/" + md5Name;
-    QString fileName = m_url.fileName();
-    qint16 idx = fileName.lastIndexOf(".");
-    QString fileThumbnail=thumbnail_dir + "/" + fileName.left(idx) + ".jpg";
-
-    qDebug()<<"file thumbnail:"<<fileThumbnail;
-    if (!QFile::exists(fileThumbnail)) {
-        //libreoffice --convert-to jpg:writer_jpg_Export test1.doc --outdir ./
-        QStringList list;
-        list<<"--headless"  /*headless和invisible的方式可以避免出现界面以及无用的log信息，速度更快*/
-            <<"--invisible"
-            <<"--convert-to"
-            <<"jpg:writer_jpg_Export"     /*转换格式jpg*/
-            <<m_url.path()                /*要转换的文件*/
-            <<"--outdir"                  /*转换完的jpg文件存在的路径*/
-            <<thumbnail_dir;
-        qDebug()<<"the libreoffice cmd: " << list;
-
-        QProcess p;
-        p.start("libreoffice",list);
+    QImage thumbnailImage = embeddedThumbnail();
+    if (!thumbnailImage.isNull())
+        return thumbnailImage;
 
-        /*
-        * 等待30s超时，30s是默认时间，可以修改
-        */
-        if (!p.waitForStarted()) {
-            qWarning()<<"libreoffice start failed, or timeout";
-            return thumbnailImage;
-        }
+    return OfficeConverter::getInstance()->convert(m_url.path(), &m_failed);
+}
 
-        /*
-        * 等待30s超时，30s是默认时间，可以修改
-        */
-        if (!p.waitForFinished()) {
-            qWarning()<<"libreoffice run failed, or timeout";
-            return thumbnailImage;
-        }
+QImage OfficeThumbnail::embeddedThumbnail()
+{
+    QImage thumbnailImage;
+    QZipReader reader(m_url.path());
+    if (reader.status() != QZipReader::NoError)
+        return thumbnailImage;
 
-        QString err=p.readAllStandardError();
-        QString read=p.readAll();
-        if (!err.isEmpty()) {
-            qWarning()<<"office convert jpg error: " << err;
-            return thumbnailImage;
-        }
+    for (auto entry : reader.fileInfoList()) {
+        //OOXML may also embed a wmf or emf preview, QImage fails to load them.
+        if (!entry.isFile || !(entry.filePath.startsWith("docProps/thumbnail.") || entry.filePath == "Thumbnails/thumbnail.png"))
+            continue;
+        thumbnailImage = QImage::fromData(reader.fileData(entry.filePath));
+        if (!thumbnailImage.isNull())
+            break;
     }
 
-    /*
-     *不知道会不会出现无效的图片的情况，可能需要对这种情况做处理？
-    */
-    thumbnailImage = GenericThumbnailer::generateThumbnail(fileThumbnail, true);
+    if (thumbnailImage.width() > 128)
+        thumbnailImage = thumbnailImage.scaledToWidth(128, Qt::SmoothTransformation);
 
     return thumbnailImage;
 }
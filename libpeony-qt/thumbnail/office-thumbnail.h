@@ -24,7 +24,7 @@
 
 #include "file-info.h"
 #include <QHash>
-#include <QIcon>
+#include <QImage>
 #include <QMutex>
 #include <QUrl>
 
@@ -34,9 +34,26 @@ class OfficeThumbnail{
 public:
     explicit OfficeThumbnail(const QString &uri);
     ~OfficeThumbnail();
-    QIcon generateThumbnail();
+    /*!
+     * \brief generateThumbnail
+     * \return the scaled image of first page, or a null image.
+     * <br>
+     * The preview embedded in OOXML and ODF documents is used if there is one,
+     * otherwise the first page is rendered by OfficeConverter.
+     * </br>
+     */
+    QImage generateThumbnail();
+    /*!
+     * \brief failed
+     * \return true if libreoffice converted the file but there is no image.
+     */
+    bool failed() {
+        return m_failed;
+    }
 
 private:
+    QImage embeddedThumbnail();
+
     /*
     * 提供office文件首页转换为图片的存储路径
     */
@@ -48,6 +65,7 @@ private:
     * 主要是为了处理修改文件首页的情况
     */
     quint64 m_modifyTime = 0;
+    bool m_failed = false;
 };
 
 #endif // OFFICETHUMBNAIL_H
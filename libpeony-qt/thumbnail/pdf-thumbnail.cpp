@@ -40,25 +40,32 @@ PdfThumbnail::~PdfThumbnail() {
     delete pagePrivate;
 }
 
-QPixmap PdfThumbnail::generateThumbnail(unsigned int pageNum) {
+QImage PdfThumbnail::generateThumbnail(unsigned int pageNum, const QSize &size) {
     try {
         if (this->documentPrivate == nullptr || this->documentPrivate->isLocked())
             //throw "pdf document not existed";
             //fix crash issue, change throw to return
-            return QPixmap();
+            return QImage();
         pagePrivate = documentPrivate->page(pageNum);
         if (pagePrivate == nullptr)
             //throw "load pdf page failed";
-            return QPixmap();
-        auto image = pagePrivate->renderToImage(
-                         72 * 2, 72 * 2, 0, 0, pagePrivate->pageSizeF().width() * 2,
-                         pagePrivate->pageSizeF().height() * 2);
+            return QImage();
+
+        //page size is in points, 72 points per inch.
+        QSizeF pageSize = pagePrivate->pageSizeF();
+        if (pageSize.width() <= 0 || pageSize.height() <= 0)
+            return QImage();
+        qreal scale = qMin(size.width() / pageSize.width(), size.height() / pageSize.height());
+
+        documentPrivate->setRenderHint(Poppler::Document::Antialiasing);
+        documentPrivate->setRenderHint(Poppler::Document::TextAntialiasing);
+        auto image = pagePrivate->renderToImage(72 * scale, 72 * scale);
         if (image.isNull())
             //throw "load pdf page image failed";
-            return QPixmap();
-        return QPixmap::fromImage(image);
+            return QImage();
+        return image;
     } catch (char *e) {
         qDebug() << e;
-        return QPixmap();
+        return QImage();
     }
 }
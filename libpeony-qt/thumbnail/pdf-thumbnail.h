@@ -23,7 +23,8 @@
 #ifndef LIBPEONYPREVIEW_PDFTHUMBNAIL_H
 #define LIBPEONYPREVIEW_PDFTHUMBNAIL_H
 
-#include <QPixmap>
+#include <QImage>
+#include <QSize>
 #include <QString>
 #include <poppler-qt5.h>
 
@@ -33,7 +34,15 @@ public:
 
     explicit PdfThumbnail(const QString &url, unsigned int pageNum = 0);
     ~PdfThumbnail();
-    QPixmap generateThumbnail(unsigned int pageNum = 0);
+    /*!
+     * \brief generateThumbnail
+     * \param pageNum
+     * \param size, the box the page fits in.
+     * \return the page rendered at the resolution of size, or a null image.
+     * \note the size of page is read from document, the page is never
+     * rendered larger than the thumbnail.
+     */
+    QImage generateThumbnail(unsigned int pageNum = 0, const QSize &size = QSize(128, 512));
 
 private:
     QString shortUrl;
@@ -0,0 +1,250 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+/*!
+ * thumbnail-benchmark
+ * <br>
+ * A headless benchmark of thumbnail pipeline. It generates a corpus of jpeg,
+ * png, pdf and svg files, then requests their thumbnails through
+ * ThumbnailManager as the views do, and measures these scenarios:
+ * cold: the disk cache is empty, every thumbnail is generated.
+ * warm: the disk cache is filled by a previous run, the memory cache is empty.
+ * </br>
+ * <br>
+ * Every run prints one JSON object per line on stdout, with the time to
+ * complete, thumbnails per second, peak RSS and ThumbnailStatistics of the run.
+ * The thumbnails are generated in process, unless --service is set. With
+ * --baseline, the best time of each scenario is compared with the best one of
+ * the same scenario in a previous output, the exit code is 2 if any of them is
+ * slower than the baseline more than --tolerance.
+ * </br>
+ * usage: thumbnail-benchmark --count 50 --size 2048 --types jpeg,png,pdf,svg
+ */
+
+#include <QApplication>
+#include <QWindow>
+#include <QCommandLineParser>
+#include <QTemporaryDir>
+#include <QDir>
+#include <QFile>
+#include <QEventLoop>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QTextStream>
+#include <QHash>
+#include <QSet>
+#include <QUrl>
+
+#include "file-info.h"
+#include "file-info-job.h"
+#include "file-watcher.h"
+#include "thumbnail-manager.h"
+
+#include "thumbnail-corpus.h"
+#include "benchmark-utils.h"
+
+struct RunResult {
+    qint64 completeNs = -1;
+    int thumbnails = 0;
+    bool successed = false;
+    Peony::ThumbnailStatistics statistics;
+};
+
+static void clearCaches(const QString &cacheHome, bool clearDiskCache)
+{
+    auto manager = Peony::ThumbnailManager::getInstance();
+    manager->clearThumbnail();
+    manager->resetStatistics();
+    if (clearDiskCache)
+        QDir(cacheHome + "/thumbnails").removeRecursively();
+}
+
+static RunResult runPipeline(const QStringList &uris, const QString &rootUri, int timeout)
+{
+    RunResult result;
+    auto manager = Peony::ThumbnailManager::getInstance();
+    //the requests of a destroyed model are dropped, keep the watcher alive in run.
+    auto watcher = std::make_shared<Peony::FileWatcher>(rootUri);
+
+    QElapsedTimer timer;
+    QEventLoop loop;
+    QSet<QString> pendingUris = uris.toSet();
+    auto connection = QObject::connect(manager, &Peony::ThumbnailManager::thumbnailReady, &loop, [&](const QString &uri) {
+        if (pendingUris.remove(uri) && pendingUris.isEmpty())
+            loop.quit();
+    }, Qt::QueuedConnection);
+    QTimer::singleShot(timeout, &loop, &QEventLoop::quit);
+
+    timer.start();
+    for (auto uri : uris) {
+        manager->createThumbnail(uri, watcher);
+    }
+    if (!pendingUris.isEmpty())
+        loop.exec();
+    result.completeNs = timer.nsecsElapsed();
+
+    QObject::disconnect(connection);
+    result.thumbnails = uris.count() - pendingUris.count();
+    result.successed = pendingUris.isEmpty();
+    result.statistics = manager->statistics();
+    return result;
+}
+
+//the runs of the same key are compared with each other.
+static const QStringList result_key_fields = {"scenario", "count", "size", "types", "service"};
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    bool useService = false;
+    for (int i = 1; i < argc; i++) {
+        if (QByteArray(argv[i]) == "--service")
+            useService = true;
+    }
+    if (!useService)
+        qputenv("PEONY_DISABLE_THUMBNAILER", "1");
+
+    //the disk cache of benchmark is isolated from the user's one.
+    QTemporaryDir cacheDir;
+    if (!cacheDir.isValid())
+        return 1;
+    qputenv("XDG_CACHE_HOME", cacheDir.path().toUtf8());
+
+    QApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless benchmark of thumbnail pipeline.");
+    parser.addHelpOption();
+    QCommandLineOption countOption("count", "Files of every type.", "count", "50");
+    QCommandLineOption sizeOption("size", "Longer side of generated pictures in pixels.", "pixels", "2048");
+    QCommandLineOption pagesOption("pages", "Pages of generated pdf files.", "pages", "4");
+    QCommandLineOption typesOption("types", "Comma separated file types: " + ThumbnailCorpus::types().join(", ") + ".", "types", "jpeg,png,pdf,svg");
+    QCommandLineOption scenariosOption("scenarios", "Comma separated scenarios: cold, warm.", "scenarios", "cold,warm");
+    QCommandLineOption repeatOption("repeat", "Runs of every scenario.", "count", "3");
+    QCommandLineOption serviceOption("service", "Generate thumbnails by peony-thumbnailer if it is available.");
+    QCommandLineOption dirOption("dir", "Directory to generate corpus in, default is a temporary one.", "path");
+    QCommandLineOption timeoutOption("timeout", "Timeout of a run in seconds.", "seconds", "600");
+    QCommandLineOption baselineOption("baseline", "Previous output to compare with.", "file");
+    QCommandLineOption toleranceOption("tolerance", "Allowed slow down against baseline, 0.2 means 20%.", "ratio", "0.2");
+    parser.addOptions({countOption, sizeOption, pagesOption, typesOption, scenariosOption, repeatOption,
+                       serviceOption, dirOption, timeoutOption, baselineOption, toleranceOption});
+    parser.process(a);
+
+    ThumbnailCorpusOptions options;
+    options.count = parser.value(countOption).toInt();
+    options.size = parser.value(sizeOption).toInt();
+    options.pages = parser.value(pagesOption).toInt();
+    options.types = parser.value(typesOption).split(",");
+    auto scenarios = parser.value(scenariosOption).split(",");
+    int repeat = qMax(1, parser.value(repeatOption).toInt());
+    int timeout = qMax(1, parser.value(timeoutOption).toInt()) * 1000;
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    //thumbnail jobs are skipped if there is no window.
+    QWindow window;
+
+    QTemporaryDir tmpDir(parser.isSet(dirOption)? parser.value(dirOption) + "/peony-benchmark-XXXXXX": QString());
+    if (!tmpDir.isValid()) {
+        err<<"can not create directory for corpus"<<endl;
+        return 1;
+    }
+
+    ThumbnailCorpus corpus(options);
+    err<<"generating corpus in "<<tmpDir.path()<<endl;
+    if (!corpus.create(tmpDir.path())) {
+        err<<"can not generate corpus"<<endl;
+        return 1;
+    }
+
+    //the mime types are known before thumbnails are requested, as in views.
+    for (auto uri : corpus.uris()) {
+        Peony::FileInfoJob job(Peony::FileInfo::fromUri(uri));
+        job.querySync();
+    }
+
+    QString rootUri = QUrl::fromLocalFile(tmpDir.path()).toString();
+    QHash<QString, double> bestTimes;
+    bool successed = true;
+    for (auto scenario : scenarios) {
+        if (scenario != "cold" && scenario != "warm") {
+            err<<"unknown scenario "<<scenario<<endl;
+            return 1;
+        }
+
+        //fill the disk cache.
+        if (scenario == "warm") {
+            clearCaches(cacheDir.path(), true);
+            runPipeline(corpus.uris(), rootUri, timeout);
+        }
+
+        for (int run = 0; run < repeat; run++) {
+            clearCaches(cacheDir.path(), scenario == "cold");
+            BenchmarkUtils::resetPeakRss();
+
+            auto result = runPipeline(corpus.uris(), rootUri, timeout);
+
+            QJsonObject object;
+            object.insert("scenario", scenario);
+            object.insert("count", options.count);
+            object.insert("size", options.size);
+            object.insert("types", options.types.join(","));
+            object.insert("service", useService);
+            object.insert("run", run);
+            object.insert("files", corpus.uris().count());
+            object.insert("corpus_bytes", double(corpus.totalBytes()));
+            object.insert("thumbnails", result.thumbnails);
+            object.insert("successed", result.successed);
+            object.insert("time_to_complete_ms", result.completeNs/1e6);
+            object.insert("thumbnails_per_second", result.completeNs > 0? result.thumbnails/(result.completeNs/1e9): 0);
+            object.insert("peak_rss_kb", BenchmarkUtils::peakRssKb());
+            object.insert("statistics", result.statistics.toJson());
+            out<<QJsonDocument(object).toJson(QJsonDocument::Compact)<<endl;
+
+            if (!result.successed) {
+                successed = false;
+                continue;
+            }
+
+            auto key = BenchmarkUtils::resultKey(object, result_key_fields);
+            double ms = result.completeNs/1e6;
+            if (!bestTimes.contains(key) || ms < bestTimes.value(key))
+                bestTimes.insert(key, ms);
+        }
+    }
+
+    if (!successed)
+        return 1;
+
+    if (parser.isSet(baselineOption)) {
+        double tolerance = parser.value(toleranceOption).toDouble();
+        if (!BenchmarkUtils::checkBaseline(bestTimes, parser.value(baselineOption), result_key_fields, tolerance, err))
+            return 2;
+    }
+
+    return 0;
+}
@@ -0,0 +1,28 @@
+#-------------------------------------------------
+#
+# Headless benchmark of thumbnail pipeline.
+#
+#-------------------------------------------------
+
+QT       += core gui widgets
+
+TARGET = thumbnail-benchmark
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+CONFIG += link_pkgconfig no_keywords c++11 console
+CONFIG -= app_bundle
+PKGCONFIG += glib-2.0 gio-2.0
+
+include(../../libpeony-qt-header.pri)
+include(../../benchmark/benchmark-utils.pri)
+
+LIBS += -L$$PWD/../../ -lpeony
+
+SOURCES += \
+        main.cpp \
+        thumbnail-corpus.cpp
+
+HEADERS += \
+        thumbnail-corpus.h
@@ -0,0 +1,175 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "thumbnail-corpus.h"
+
+#include <QImage>
+#include <QPainter>
+#include <QPdfWriter>
+#include <QLinearGradient>
+#include <QColor>
+#include <QFile>
+#include <QFileInfo>
+#include <QUrl>
+
+/*!
+ * \brief nextRandom
+ * a linear congruential generator, the corpus is same on every machine.
+ */
+static quint32 nextRandom(quint32 &state)
+{
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+ThumbnailCorpus::ThumbnailCorpus(const ThumbnailCorpusOptions &options)
+{
+    m_options = options;
+    m_options.count = qMax(1, m_options.count);
+    m_options.size = qMax(16, m_options.size);
+    m_options.pages = qMax(1, m_options.pages);
+}
+
+QStringList ThumbnailCorpus::types()
+{
+    return QStringList()<<"jpeg"<<"png"<<"pdf"<<"svg";
+}
+
+bool ThumbnailCorpus::create(const QString &rootPath)
+{
+    m_uris.clear();
+    m_type_uris.clear();
+    m_total_bytes = 0;
+
+    for (auto type : m_options.types) {
+        if (!types().contains(type))
+            return false;
+
+        QString suffix = type == "jpeg"? "jpg": type;
+        for (int i = 0; i < m_options.count; i++) {
+            QString path = QString("%1/%2-%3.%4").arg(rootPath).arg(type).arg(i, 6, 10, QChar('0')).arg(suffix);
+            int seed = i + 1;
+            bool successed = false;
+            if (type == "pdf") {
+                successed = createPdf(path, seed);
+            } else if (type == "svg") {
+                successed = createSvg(path, seed);
+            } else {
+                successed = createPicture(path, type, seed);
+            }
+            if (!successed)
+                return false;
+
+            QString uri = QUrl::fromLocalFile(path).toString();
+            m_uris<<uri;
+            m_type_uris[type]<<uri;
+            m_total_bytes += QFileInfo(path).size();
+        }
+    }
+    return true;
+}
+
+bool ThumbnailCorpus::createPicture(const QString &path, const QString &format, int seed)
+{
+    //landscape and portrait pictures alternately.
+    int width = m_options.size;
+    int height = m_options.size * 3 / 4;
+    if (seed % 2 == 0)
+        qSwap(width, height);
+
+    QImage image(width, height, QImage::Format_RGB32);
+    QPainter painter(&image);
+    QLinearGradient gradient(0, 0, width, height);
+    gradient.setColorAt(0, QColor::fromHsv(seed * 37 % 360, 160, 220));
+    gradient.setColorAt(1, QColor::fromHsv(seed * 91 % 360, 200, 90));
+    painter.fillRect(image.rect(), gradient);
+    painter.end();
+
+    quint32 state = quint32(seed);
+    for (int y = 0; y < height; y++) {
+        auto line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < width; x++) {
+            int noise = int(nextRandom(state) % 33) - 16;
+            line[x] = qRgb(qBound(0, qRed(line[x]) + noise, 255),
+                           qBound(0, qGreen(line[x]) + noise, 255),
+                           qBound(0, qBlue(line[x]) + noise, 255));
+        }
+    }
+
+    return image.save(path, format == "jpeg"? "JPEG": "PNG", format == "jpeg"? 90: -1);
+}
+
+bool ThumbnailCorpus::createPdf(const QString &path, int seed)
+{
+    QPdfWriter writer(path);
+    writer.setPageSize(QPageSize(QPageSize::A4));
+    writer.setResolution(300);
+    writer.setTitle(QFileInfo(path).fileName());
+
+    QPainter painter;
+    if (!painter.begin(&writer))
+        return false;
+
+    quint32 state = quint32(seed);
+    for (int page = 0; page < m_options.pages; page++) {
+        if (page > 0)
+            writer.newPage();
+        QRect rect = painter.viewport();
+        painter.fillRect(QRect(rect.x(), rect.y(), rect.width(), rect.height()/6),
+                         QColor::fromHsv((seed * 37 + page * 50) % 360, 120, 200));
+        QFont font = painter.font();
+        font.setPointSize(10);
+        painter.setFont(font);
+        int lineHeight = painter.fontMetrics().height();
+        for (int y = rect.height()/5; y < rect.height() - lineHeight; y += lineHeight) {
+            QString text;
+            int words = 8 + nextRandom(state) % 6;
+            for (int i = 0; i < words; i++) {
+                text += QString("lorem%1 ").arg(nextRandom(state) % 1000);
+            }
+            painter.drawText(rect.x(), y, text);
+        }
+    }
+
+    return painter.end();
+}
+
+bool ThumbnailCorpus::createSvg(const QString &path, int seed)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    int size = m_options.size;
+    QString svg = QString("<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%1\" height=\"%1\" viewBox=\"0 0 %1 %1\">\n").arg(size);
+    quint32 state = quint32(seed);
+    for (int i = 0; i < 200; i++) {
+        svg += QString("<circle cx=\"%1\" cy=\"%2\" r=\"%3\" fill=\"%4\" fill-opacity=\"0.6\"/>\n")
+                .arg(nextRandom(state) % size)
+                .arg(nextRandom(state) % size)
+                .arg(4 + nextRandom(state) % (size / 8))
+                .arg(QColor::fromHsv(nextRandom(state) % 360, 180, 220).name());
+    }
+    svg += "</svg>\n";
+
+    return file.write(svg.toUtf8()) > 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef THUMBNAILCORPUS_H
+#define THUMBNAILCORPUS_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+
+/*!
+ * \brief The ThumbnailCorpusOptions struct
+ * <br>
+ * count is the count of files of every type, size is the longer side of
+ * generated pictures in pixels. The pdf files have pages of A4 size.
+ * </br>
+ * \see ThumbnailCorpus::types().
+ */
+struct ThumbnailCorpusOptions {
+    int count = 50;
+    int size = 2048;
+    int pages = 4;
+    QStringList types = {"jpeg", "png", "pdf", "svg"};
+};
+
+/*!
+ * \brief The ThumbnailCorpus class
+ * <br>
+ * Generates files of the supported types for thumbnail benchmarks.
+ * The pictures are gradients with deterministic noise, so that they
+ * compress like photos and every run decodes the same data.
+ * </br>
+ */
+class ThumbnailCorpus
+{
+public:
+    explicit ThumbnailCorpus(const ThumbnailCorpusOptions &options);
+
+    static QStringList types();
+
+    /*!
+     * \brief create
+     * \param rootPath, an existed empty directory.
+     * \return false if any file could not be created.
+     */
+    bool create(const QString &rootPath);
+
+    QStringList uris() const {
+        return m_uris;
+    }
+    QStringList uris(const QString &type) const {
+        return m_type_uris.value(type);
+    }
+    qint64 totalBytes() const {
+        return m_total_bytes;
+    }
+
+protected:
+    bool createPicture(const QString &path, const QString &format, int seed);
+    bool createPdf(const QString &path, int seed);
+    bool createSvg(const QString &path, int seed);
+
+private:
+    ThumbnailCorpusOptions m_options;
+
+    QStringList m_uris;
+    QHash<QString, QStringList> m_type_uris;
+    qint64 m_total_bytes = 0;
+};
+
+#endif // THUMBNAILCORPUS_H
@@ -0,0 +1,171 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "thumbnail-cache.h"
+
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QSaveFile>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+
+#include <glib.h>
+
+//bump it when the thumbnailers are improved, so that the old failures are tried again.
+#ifndef PEONY_THUMBNAILER_VERSION
+#define PEONY_THUMBNAILER_VERSION "1"
+#endif
+
+#define NORMAL_THUMBNAIL_SIZE 128
+#define LARGE_THUMBNAIL_SIZE 256
+
+using namespace Peony;
+
+QString ThumbnailCache::thumbnailsDir()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/thumbnails";
+}
+
+QString ThumbnailCache::thumbnailPath(const QString &path, Flavor flavor)
+{
+    QString md5 = QCryptographicHash::hash(canonicalUri(path), QCryptographicHash::Md5).toHex();
+    return thumbnailsDir() + (flavor == Large? "/large/": "/normal/") + md5 + ".png";
+}
+
+QString ThumbnailCache::failureMarkerPath(const QString &path)
+{
+    QString md5 = QCryptographicHash::hash(canonicalUri(path), QCryptographicHash::Md5).toHex();
+    return thumbnailsDir() + "/fail/peony-" PEONY_THUMBNAILER_VERSION "/" + md5 + ".png";
+}
+
+QImage ThumbnailCache::lookup(const QString &path, quint64 modifiedTime)
+{
+    if (path.isEmpty() || modifiedTime == 0)
+        return QImage();
+
+    auto uri = canonicalUri(path);
+    QImage image = readThumbnail(thumbnailPath(path, Normal), uri, modifiedTime);
+    if (!image.isNull())
+        return image;
+
+    image = readThumbnail(thumbnailPath(path, Large), uri, modifiedTime);
+    if (image.width() > NORMAL_THUMBNAIL_SIZE || image.height() > NORMAL_THUMBNAIL_SIZE)
+        image = image.scaled(NORMAL_THUMBNAIL_SIZE, NORMAL_THUMBNAIL_SIZE, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    return image;
+}
+
+bool ThumbnailCache::hasFailed(const QString &path, quint64 modifiedTime)
+{
+    if (path.isEmpty() || modifiedTime == 0)
+        return false;
+
+    auto markerPath = failureMarkerPath(path);
+    if (!QFile::exists(markerPath))
+        return false;
+
+    QImageReader reader(markerPath, "png");
+    return reader.text("Thumb::URI").toUtf8() == canonicalUri(path)
+            && reader.text("Thumb::MTime").toULongLong() == modifiedTime;
+}
+
+bool ThumbnailCache::store(const QString &path, quint64 modifiedTime, const QImage &image)
+{
+    if (path.isEmpty() || modifiedTime == 0 || image.isNull())
+        return false;
+
+    QImage thumbnail = image;
+    if (thumbnail.width() > NORMAL_THUMBNAIL_SIZE || thumbnail.height() > NORMAL_THUMBNAIL_SIZE)
+        thumbnail = thumbnail.scaled(NORMAL_THUMBNAIL_SIZE, NORMAL_THUMBNAIL_SIZE, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+    return writeThumbnail(thumbnailPath(path, Normal), canonicalUri(path), modifiedTime, thumbnail);
+}
+
+bool ThumbnailCache::markFailed(const QString &path, quint64 modifiedTime)
+{
+    if (path.isEmpty() || modifiedTime == 0)
+        return false;
+
+    QImage marker(1, 1, QImage::Format_ARGB32);
+    marker.fill(Qt::transparent);
+    return writeThumbnail(failureMarkerPath(path), canonicalUri(path), modifiedTime, marker);
+}
+
+QByteArray ThumbnailCache::canonicalUri(const QString &path)
+{
+    //the standard requires the same escaping as other thumbnailers, which are mostly glib based.
+    QByteArray uri;
+    char *escaped = g_filename_to_uri(path.toUtf8().constData(), nullptr, nullptr);
+    if (escaped) {
+        uri = escaped;
+        g_free(escaped);
+    }
+    return uri;
+}
+
+QImage ThumbnailCache::readThumbnail(const QString &thumbnailPath, const QByteArray &uri, quint64 modifiedTime)
+{
+    if (uri.isEmpty() || !QFile::exists(thumbnailPath))
+        return QImage();
+
+    //text chunks are in front of image data, validate them before decoding.
+    QImageReader reader(thumbnailPath, "png");
+    if (reader.text("Thumb::URI").toUtf8() != uri)
+        return QImage();
+    if (reader.text("Thumb::MTime").toULongLong() != modifiedTime)
+        return QImage();
+
+    return reader.read();
+}
+
+bool ThumbnailCache::writeThumbnail(const QString &thumbnailPath, const QByteArray &uri, quint64 modifiedTime, const QImage &image)
+{
+    if (uri.isEmpty())
+        return false;
+
+    QDir dir = QFileInfo(thumbnailPath).dir();
+    if (!dir.exists()) {
+        if (!dir.mkpath("."))
+            return false;
+        QFile::setPermissions(dir.path(), QFile::ReadOwner|QFile::WriteOwner|QFile::ExeOwner);
+    }
+
+    QImage thumbnail = image;
+    thumbnail.setText("Thumb::URI", QString::fromUtf8(uri));
+    thumbnail.setText("Thumb::MTime", QString::number(modifiedTime));
+    thumbnail.setText("Software", "Peony");
+
+    //QSaveFile writes to a temporary file and renames it, readers never see a partial thumbnail.
+    QSaveFile file(thumbnailPath);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    file.setPermissions(QFile::ReadOwner|QFile::WriteOwner);
+
+    QImageWriter writer(&file, "png");
+    if (!writer.write(thumbnail)) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
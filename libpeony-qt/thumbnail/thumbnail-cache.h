@@ -0,0 +1,89 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <QString>
+#include <QImage>
+
+namespace Peony {
+
+/*!
+ * \brief The ThumbnailCache class
+ * <br>
+ * ThumbnailCache is the persistent thumbnail storage described by freedesktop's
+ * thumbnail managing standard. The thumbnails are saved as png files in
+ * $XDG_CACHE_HOME/thumbnails/{normal,large}, named by md5 of the file's uri,
+ * and they are shared with other thumbnailers of the system.
+ * </br>
+ * <br>
+ * Every thumbnail carries Thumb::URI and Thumb::MTime, a thumbnail is only
+ * used when both of them match the file. If a file could not be thumbnailed,
+ * a failure marker is saved in fail/peony-<version>, so that it will not be
+ * tried again until it is modified.
+ * </br>
+ * \note
+ * Only local files are cached, all the paths here are local paths.
+ * The methods are reentrant, they could be called in thumbnail threads.
+ */
+class ThumbnailCache
+{
+public:
+    enum Flavor {
+        Normal,
+        Large
+    };
+
+    static QString thumbnailsDir();
+    static QString thumbnailPath(const QString &path, Flavor flavor = Normal);
+    static QString failureMarkerPath(const QString &path);
+
+    /*!
+     * \brief lookup
+     * \param path
+     * \param modifiedTime, file's modified time in seconds.
+     * \return the cached normal size thumbnail, or a null image if there is
+     * no valid one. A large thumbnail is scaled down if there is no normal one.
+     */
+    static QImage lookup(const QString &path, quint64 modifiedTime);
+    static bool hasFailed(const QString &path, quint64 modifiedTime);
+
+    /*!
+     * \brief store
+     * \param path
+     * \param modifiedTime
+     * \param image, it will be scaled down to fit the normal size if it is larger.
+     * \return true if the thumbnail was saved.
+     */
+    static bool store(const QString &path, quint64 modifiedTime, const QImage &image);
+    static bool markFailed(const QString &path, quint64 modifiedTime);
+
+protected:
+    static QByteArray canonicalUri(const QString &path);
+    static QImage readThumbnail(const QString &thumbnailPath, const QByteArray &uri, quint64 modifiedTime);
+    static bool writeThumbnail(const QString &thumbnailPath, const QByteArray &uri, quint64 modifiedTime, const QImage &image);
+};
+
+}
+
+#endif // THUMBNAILCACHE_H
@@ -29,45 +29,33 @@
 #include <QApplication>
 #include <QDebug>
 
-static int runCount = 0;
-static int endCount = 0;
-
-Peony::ThumbnailJob::ThumbnailJob(const QString &uri, const std::shared_ptr<Peony::FileWatcher> watcher, QObject *parent):
+Peony::ThumbnailJob::ThumbnailJob(const QString &uri, const std::shared_ptr<Peony::FileWatcher> watcher, ThumbnailManager::JobKind kind, QObject *parent):
     QObject(parent), QRunnable()
 {
     m_uri = uri;
     m_watcher = watcher;
-    if (watcher) {
-        if (watcher->parent()) {
-            setParent(watcher->parent());
-        }
-    }
+    m_kind = kind;
 
     setAutoDelete(true);
 }
 
 Peony::ThumbnailJob::~ThumbnailJob()
 {
-    endCount++;
-    //qDebug()<<"job end or cancelled. current end"<<endCount<<"current start request:"<<runCount;
+
 }
 
 void Peony::ThumbnailJob::run()
 {
-    if (!parent())
-        return;
+    auto manager = ThumbnailManager::getInstance();
 
     // if all window closed, should not do a thumbnail job.
-    if (qApp->topLevelWindows().count() == 0) {
-        return;
+    // if the model was destroyed, nobody needs this thumbnail.
+    auto strongPtr = m_watcher.lock();
+    if (strongPtr.get() && qApp->topLevelWindows().count() != 0) {
+        manager->createThumbnailInternal(m_uri, strongPtr);
+    } else {
+        manager->recordDroppedRequest();
     }
 
-    runCount++;
-
-    qDebug()<<"job start, current end:"<<endCount<<"current start request:"<<runCount;
-
-    setParent(nullptr);
-    auto strongPtr = m_watcher.lock();
-    if (strongPtr.get())
-        ThumbnailManager::getInstance()->createThumbnailInternal(m_uri, strongPtr);
+    QMetaObject::invokeMethod(manager, "onThumbnailJobFinished", Qt::QueuedConnection, Q_ARG(int, int(m_kind)));
 }
@@ -28,24 +28,38 @@
 #include <memory>
 
 #include "peony-core_global.h"
+#include "thumbnail-manager.h"
 
 namespace Peony {
 
 class FileWatcher;
 
+/*!
+ * \brief The ThumbnailJob class
+ * <br>
+ * A thumbnail job runs in the thread pool of ThumbnailManager, which schedules
+ * the jobs by the visibility of their files and limits the concurrency of
+ * each kind. It tells ThumbnailManager once it is finished.
+ * </br>
+ */
 class PEONYCORESHARED_EXPORT ThumbnailJob : public QObject, public QRunnable
 {
     Q_OBJECT
 public:
-    explicit ThumbnailJob(const QString &uri, const std::shared_ptr<FileWatcher> watcher, QObject *parent = nullptr);
+    explicit ThumbnailJob(const QString &uri, const std::shared_ptr<FileWatcher> watcher, ThumbnailManager::JobKind kind = ThumbnailManager::GenericJob, QObject *parent = nullptr);
     ~ThumbnailJob();
 
+    ThumbnailManager::JobKind kind() {
+        return m_kind;
+    }
+
 public Q_SLOTS:
     void run() override;
 
 private:
     QString m_uri;
     std::weak_ptr<FileWatcher> m_watcher;
+    ThumbnailManager::JobKind m_kind = ThumbnailManager::GenericJob;
 };
 
 }
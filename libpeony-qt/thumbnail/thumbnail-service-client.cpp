@@ -0,0 +1,107 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "thumbnail-service-client.h"
+
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusUnixFileDescriptor>
+#include <QDBusError>
+#include <QAtomicInt>
+#include <QDebug>
+
+#include <sys/mman.h>
+
+//a job of the service may take this long, in msec, the service kills it earlier.
+#ifndef PEONY_THUMBNAILER_CALL_TIMEOUT
+#define PEONY_THUMBNAILER_CALL_TIMEOUT 120000
+#endif
+
+using namespace Peony;
+
+//PEONY_DISABLE_THUMBNAILER forces generating in process, as benchmarks do.
+static QAtomicInt service_unavailable = qEnvironmentVariableIsSet("PEONY_DISABLE_THUMBNAILER");
+
+ThumbnailServiceClient::Result ThumbnailServiceClient::requestThumbnail(const QString &uri, int kind, QImage &image)
+{
+    if (service_unavailable.load())
+        return Unavailable;
+
+    auto connection = QDBusConnection::sessionBus();
+    if (!connection.isConnected() || !(connection.connectionCapabilities() & QDBusConnection::UnixFileDescriptorPassing)) {
+        service_unavailable.store(1);
+        return Unavailable;
+    }
+
+    auto message = QDBusMessage::createMethodCall(PEONY_THUMBNAILER_SERVICE,
+                                                  PEONY_THUMBNAILER_PATH,
+                                                  PEONY_THUMBNAILER_INTERFACE,
+                                                  "Thumbnail");
+    message<<uri<<kind;
+    auto reply = connection.call(message, QDBus::Block, PEONY_THUMBNAILER_CALL_TIMEOUT);
+    if (reply.type() != QDBusMessage::ReplyMessage) {
+        //the service is not installed, do not try to activate it again.
+        if (reply.errorName() == QDBusError::errorString(QDBusError::ServiceUnknown))
+            service_unavailable.store(1);
+        qWarning()<<"thumbnail service error:"<<reply.errorName()<<reply.errorMessage();
+        return Unavailable;
+    }
+
+    //fd, width, height, stride, format, failed
+    auto args = reply.arguments();
+    if (args.count() != 6)
+        return Unavailable;
+
+    auto fd = qdbus_cast<QDBusUnixFileDescriptor>(args.at(0));
+    int width = args.at(1).toInt();
+    int height = args.at(2).toInt();
+    int stride = args.at(3).toInt();
+    auto format = QImage::Format(args.at(4).toInt());
+    bool failed = args.at(5).toBool();
+
+    if (!fd.isValid() || width <= 0 || height <= 0 || stride < width)
+        return failed? Failed: Canceled;
+
+    size_t size = size_t(stride) * size_t(height);
+    void *data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd.fileDescriptor(), 0);
+    if (data == MAP_FAILED)
+        return Unavailable;
+
+    image = QImage(static_cast<const uchar *>(data), width, height, stride, format).copy();
+    munmap(data, size);
+
+    return image.isNull()? Unavailable: Generated;
+}
+
+void ThumbnailServiceClient::cancelThumbnail(const QString &uri)
+{
+    if (service_unavailable.load())
+        return;
+
+    auto message = QDBusMessage::createMethodCall(PEONY_THUMBNAILER_SERVICE,
+                                                  PEONY_THUMBNAILER_PATH,
+                                                  PEONY_THUMBNAILER_INTERFACE,
+                                                  "Cancel");
+    message<<uri;
+    message.setAutoStartService(false);
+    QDBusConnection::sessionBus().send(message);
+}
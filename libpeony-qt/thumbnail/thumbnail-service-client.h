@@ -0,0 +1,78 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef THUMBNAILSERVICECLIENT_H
+#define THUMBNAILSERVICECLIENT_H
+
+#include <QString>
+#include <QImage>
+
+#define PEONY_THUMBNAILER_SERVICE "org.ukui.peony.Thumbnailer"
+#define PEONY_THUMBNAILER_PATH "/org/ukui/peony/Thumbnailer"
+#define PEONY_THUMBNAILER_INTERFACE "org.ukui.peony.Thumbnailer"
+
+namespace Peony {
+
+/*!
+ * \brief The ThumbnailServiceClient class
+ * <br>
+ * ThumbnailServiceClient asks peony-thumbnailer, the thumbnail service shared
+ * by peony and peony-qt-desktop, to generate a thumbnail. The service runs
+ * decoders in worker processes with time and memory limits, generates a
+ * thumbnail requested by several clients once, saves it into ThumbnailCache,
+ * and sends its pixels back through a memfd.
+ * </br>
+ * \note
+ * The calls block, they are made in thumbnail threads. If the service is not
+ * installed or the bus can not pass file descriptors, Unavailable is returned
+ * and the caller generates the thumbnail in process.
+ */
+class ThumbnailServiceClient
+{
+public:
+    enum Result {
+        Unavailable,
+        Generated,
+        Failed,
+        Canceled
+    };
+
+    /*!
+     * \brief requestThumbnail
+     * \param uri
+     * \param kind, the ThumbnailManager::JobKind of uri, the service limits
+     * the jobs of each kind, and converts the office documents together.
+     * \param image, the generated thumbnail.
+     */
+    static Result requestThumbnail(const QString &uri, int kind, QImage &image);
+    /*!
+     * \brief cancelThumbnail
+     * \param uri
+     * tell the service this process does not wait for uri anymore, the
+     * request returns Canceled. It does not block.
+     */
+    static void cancelThumbnail(const QString &uri);
+};
+
+}
+
+#endif // THUMBNAILSERVICECLIENT_H
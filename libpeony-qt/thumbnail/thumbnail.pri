@@ -5,11 +5,28 @@ HEADERS += $$PWD/pdf-thumbnail.h \
     $$PWD/image-pdf-thumbnail.h \
     $$PWD/thumbnail-job.h \
     $$PWD/video-thumbnail.h \
-    $$PWD/office-thumbnail.h
+    $$PWD/office-thumbnail.h \
+    $$PWD/thumbnail-cache.h \
+    $$PWD/video-frame-extractor.h \
+    $$PWD/office-converter.h \
+    $$PWD/image-icon-engine.h \
+    $$PWD/thumbnail-service-client.h
 
 SOURCES += $$PWD/pdf-thumbnail.cpp \
     $$PWD/generic-thumbnailer.cpp \
     $$PWD/image-pdf-thumbnail.cpp \
     $$PWD/thumbnail-job.cpp \
     $$PWD/video-thumbnail.cpp \
-    $$PWD/office-thumbnail.cpp
+    $$PWD/office-thumbnail.cpp \
+    $$PWD/thumbnail-cache.cpp \
+    $$PWD/video-frame-extractor.cpp \
+    $$PWD/office-converter.cpp \
+    $$PWD/image-icon-engine.cpp \
+    $$PWD/thumbnail-service-client.cpp
+
+# decode video thumbnails in process if the libraries are there,
+# otherwise the ffmpeg command is used.
+packagesExist(libavformat libavcodec libavutil libswscale) {
+    PKGCONFIG += libavformat libavcodec libavutil libswscale
+    DEFINES += PEONY_HAVE_LIBAV
+}
@@ -0,0 +1,243 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: renpeijia <renpeijia@kylinos.cn>
+ *
+ */
+
+
+#include "video-frame-extractor.h"
+
+#include <QDebug>
+
+#ifdef PEONY_HAVE_LIBAV
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libswscale/swscale.h>
+}
+#endif
+
+//stop decoding a file whose key frames are too far away from each other.
+#ifndef PEONY_VIDEO_THUMBNAIL_MAX_PACKETS
+#define PEONY_VIDEO_THUMBNAIL_MAX_PACKETS 1024
+#endif
+
+VideoFrameExtractor::VideoFrameExtractor(const QString &path)
+{
+    m_path = path;
+}
+
+bool VideoFrameExtractor::isAvailable()
+{
+#ifdef PEONY_HAVE_LIBAV
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool VideoFrameExtractor::isCanceled()
+{
+    return m_cancel_callback && m_cancel_callback();
+}
+
+#ifdef PEONY_HAVE_LIBAV
+
+static bool initializeLibraries()
+{
+#if LIBAVFORMAT_VERSION_INT < AV_VERSION_INT(58, 9, 100)
+    av_register_all();
+#endif
+    //broken clips are common in a media share, do not flood the terminal.
+    av_log_set_level(AV_LOG_QUIET);
+    return true;
+}
+
+static int interruptCallback(void *data)
+{
+    auto extractor = static_cast<VideoFrameExtractor *>(data);
+    return extractor->isCanceled()? 1: 0;
+}
+
+/*!
+ * \brief framePosition
+ * \param duration, in seconds.
+ * \return the position of thumbnail frame in seconds,
+ * the first frames of a video are often black.
+ * \note keep it the same as VideoThumbnail::videoInfo().
+ */
+static double framePosition(double duration)
+{
+    if (duration <= 0)
+        return 5.0;
+    if (duration >= 3600)
+        return 15.0;
+    if (duration >= 60)
+        return 7.0;
+    if (duration <= 1)
+        return 0.1;
+    if (duration <= 5)
+        return 1.0;
+    if (duration <= 10)
+        return 3.0;
+    return 5.0;
+}
+
+static QImage scaledFrame(AVFrame *frame, AVRational sampleAspectRatio, int width)
+{
+    int displayWidth = frame->width;
+    if (sampleAspectRatio.num > 0 && sampleAspectRatio.den > 0)
+        displayWidth = int(frame->width * av_q2d(sampleAspectRatio));
+    if (displayWidth <= 0 || frame->height <= 0)
+        return QImage();
+
+    int targetWidth = qMin(width, displayWidth);
+    int targetHeight = qMax(1, int(qint64(frame->height) * targetWidth / displayWidth));
+
+    SwsContext *swsContext = sws_getContext(frame->width, frame->height, AVPixelFormat(frame->format),
+                                            targetWidth, targetHeight, AV_PIX_FMT_RGB32,
+                                            SWS_BILINEAR, nullptr, nullptr, nullptr);
+    if (!swsContext)
+        return QImage();
+
+    QImage image(targetWidth, targetHeight, QImage::Format_RGB32);
+    uint8_t *dst[] = {image.bits()};
+    int dstStride[] = {int(image.bytesPerLine())};
+    sws_scale(swsContext, frame->data, frame->linesize, 0, frame->height, dst, dstStride);
+    sws_freeContext(swsContext);
+
+    return image;
+}
+
+QImage VideoFrameExtractor::extractFrame(int width)
+{
+    static bool initialized = initializeLibraries();
+    Q_UNUSED(initialized)
+
+    QImage image;
+
+    AVFormatContext *formatContext = avformat_alloc_context();
+    if (!formatContext)
+        return image;
+    formatContext->interrupt_callback.callback = interruptCallback;
+    formatContext->interrupt_callback.opaque = this;
+
+    //avformat_open_input() frees the context on failure.
+    if (avformat_open_input(&formatContext, m_path.toUtf8().constData(), nullptr, nullptr) < 0) {
+        m_failed = !isCanceled();
+        return image;
+    }
+
+    AVCodecContext *codecContext = nullptr;
+    AVPacket *packet = nullptr;
+    AVFrame *frame = nullptr;
+    int streamIndex = -1;
+    AVStream *stream = nullptr;
+    const AVCodec *codec = nullptr;
+
+    if (avformat_find_stream_info(formatContext, nullptr) < 0)
+        goto finish;
+
+    for (unsigned int i = 0; i < formatContext->nb_streams; i++) {
+        auto candidate = formatContext->streams[i];
+        //skip the cover art, it is not a frame of the video.
+        if (candidate->codecpar->codec_type == AVMEDIA_TYPE_VIDEO
+                && !(candidate->disposition & AV_DISPOSITION_ATTACHED_PIC)) {
+            streamIndex = int(i);
+            break;
+        }
+    }
+    if (streamIndex < 0)
+        goto finish;
+
+    stream = formatContext->streams[streamIndex];
+    codec = avcodec_find_decoder(stream->codecpar->codec_id);
+    if (!codec)
+        goto finish;
+
+    codecContext = avcodec_alloc_context3(codec);
+    if (!codecContext || avcodec_parameters_to_context(codecContext, stream->codecpar) < 0)
+        goto finish;
+    //thumbnail jobs already run in parallel.
+    codecContext->thread_count = 1;
+    if (avcodec_open2(codecContext, codec, nullptr) < 0)
+        goto finish;
+
+    if (formatContext->duration != AV_NOPTS_VALUE) {
+        double position = framePosition(double(formatContext->duration) / AV_TIME_BASE);
+        int64_t timestamp = av_rescale_q(int64_t(position * AV_TIME_BASE), AV_TIME_BASE_Q, stream->time_base);
+        if (stream->start_time != AV_NOPTS_VALUE)
+            timestamp += stream->start_time;
+        //land on the key frame before position, so the first decoded frame is the one we need.
+        if (av_seek_frame(formatContext, streamIndex, timestamp, AVSEEK_FLAG_BACKWARD) >= 0)
+            avcodec_flush_buffers(codecContext);
+    }
+
+    packet = av_packet_alloc();
+    frame = av_frame_alloc();
+    if (!packet || !frame)
+        goto finish;
+
+    for (int count = 0; count < PEONY_VIDEO_THUMBNAIL_MAX_PACKETS && image.isNull(); count++) {
+        if (isCanceled())
+            goto finish;
+
+        int ret = av_read_frame(formatContext, packet);
+        if (ret < 0) {
+            //drain the frames buffered in decoder.
+            avcodec_send_packet(codecContext, nullptr);
+        } else if (packet->stream_index != streamIndex) {
+            av_packet_unref(packet);
+            continue;
+        } else {
+            avcodec_send_packet(codecContext, packet);
+            av_packet_unref(packet);
+        }
+
+        if (avcodec_receive_frame(codecContext, frame) == 0) {
+            image = scaledFrame(frame, av_guess_sample_aspect_ratio(formatContext, stream, frame), width);
+            av_frame_unref(frame);
+            break;
+        }
+
+        if (ret < 0)
+            break;
+    }
+
+finish:
+    if (image.isNull() && !isCanceled())
+        m_failed = true;
+
+    av_frame_free(&frame);
+    av_packet_free(&packet);
+    avcodec_free_context(&codecContext);
+    avformat_close_input(&formatContext);
+
+    return image;
+}
+
+#else
+
+QImage VideoFrameExtractor::extractFrame(int width)
+{
+    Q_UNUSED(width)
+    return QImage();
+}
+
+#endif
@@ -0,0 +1,83 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: renpeijia <renpeijia@kylinos.cn>
+ *
+ */
+
+
+#ifndef VIDEOFRAMEEXTRACTOR_H
+#define VIDEOFRAMEEXTRACTOR_H
+
+#include <QString>
+#include <QImage>
+#include <functional>
+
+/*!
+ * \brief The VideoFrameExtractor class
+ * <br>
+ * VideoFrameExtractor decodes one frame of a video with libavformat and
+ * libavcodec in process. The file is opened once, the extractor seeks to
+ * the key frame before a position chosen by the duration, and the decoded
+ * frame is scaled directly into a QImage.
+ * </br>
+ * \note
+ * The libraries are optional, isAvailable() returns false if peony was built
+ * without them, and VideoThumbnail falls back to the ffmpeg command.
+ */
+class VideoFrameExtractor
+{
+public:
+    typedef std::function<bool()> CancelCallback;
+
+    explicit VideoFrameExtractor(const QString &path);
+
+    static bool isAvailable();
+
+    /*!
+     * \brief setCancelCallback
+     * \param callback, polled while the file is read and decoded,
+     * the extraction is aborted once it returns true.
+     */
+    void setCancelCallback(const CancelCallback &callback) {
+        m_cancel_callback = callback;
+    }
+
+    /*!
+     * \brief extractFrame
+     * \param width, the width of image, the height keeps the display aspect ratio.
+     * \return the frame, or a null image if failed or canceled.
+     */
+    QImage extractFrame(int width);
+
+    /*!
+     * \brief failed
+     * \return true if the file was read but there is no frame to decode.
+     */
+    bool failed() {
+        return m_failed;
+    }
+    bool isCanceled();
+
+private:
+    QString m_path;
+    CancelCallback m_cancel_callback;
+    bool m_failed = false;
+};
+
+#endif // VIDEOFRAMEEXTRACTOR_H
@@ -30,6 +30,7 @@
 #include <QMessageAuthenticationCode>
 #include <QPainter>
 #include <QImageReader>
+#include <QTemporaryDir>
 #include <qglobal.h>
 
 VideoThumbnail::VideoThumbnail(const QString &uri)
@@ -126,63 +127,75 @@ QMap<QString, QString> VideoThumbnail::videoInfo()
     return map;
 }
 
+QImage VideoThumbnail::generateThumbnail()
+{
+    if (!VideoFrameExtractor::isAvailable())
+        return generateThumbnailByCommand();
+
+    VideoFrameExtractor extractor(m_url.path());
+    extractor.setCancelCallback(m_cancel_callback);
+    QImage thumbnailImage = extractor.extractFrame(128);
+    m_failed = extractor.failed();
+
+    return thumbnailImage;
+}
+
 /*
 * 函数功能：
-* 通过ffmpeg从视频文件中提取出缩略图显示的图片，该图片存放到tmp目录下，不会主动删除，
-* tmp是内存文件系统，系统重启会自动清除图片
+* 没有libavformat时的回退方式。
+* 通过ffmpeg从视频文件中提取出缩略图显示的图片，该图片先输出到临时目录，读取后删除，
+* 由ThumbnailManager保存到freedesktop标准的缩略图缓存中。
 *
 * 性能测试：
 * 转化性能和文件大小以及视频文件格式有关。在V10上面测试ffmpeg不支持mpeg格式的视频文件
 * 这个可能和解码器的配置有关，可以通过视频格式转换后,再提取图片，效率很低，暂时未实现。
 *
-* 后续优化方式：
-* 通过调用ffpmeg的api实现视频格式转换和图片文件提取，需要验证性能的提升情况。
 */
-QIcon VideoThumbnail::generateThumbnail()
+QImage VideoThumbnail::generateThumbnailByCommand()
 {
-    QIcon thumbnailImage;
-    QString thumbnail= GenericThumbnailer::thumbnaileCachDir();
-    QString md5Name=GenericThumbnailer::codeMd5WithModifyTime(m_url.path(), m_modifyTime);
-    QString fileThumbnail=thumbnail+"/"+md5Name;
-
-    if (!QFile::exists(fileThumbnail)) {
-        QMap<QString, QString> map=  videoInfo();
-        QString pos=map.value("Pos");
-
-        //ffmpeg -i ./kofar-bi-amirica.mp4 -y -ss 10.0 -vframes 1 -f image2 -s 128x128 thumbnail
-        QStringList list;
-        list<<"-i"<<m_url.path()     /*Input File Name*/
-           <<"-y"                    /*Overwrite*/
-           <<"-ss"<<pos              /* seeks in this position*/
-           <<"-vframes"<<"1"         /* Num Frames */
-           <<"-f"<<"image2"          /* file format.  */
-           <<"-s"<<"128x128"         /*<<"-vf"<<scal*/
-           <<fileThumbnail; /*output file Name */
-        qDebug()<<"the ffmpeg cmd: " << list;
-
-        QProcess p;
-        p.start("ffmpeg",list);
-
-        if (!p.waitForStarted()) {
-            return thumbnailImage;
-        }
+    QImage thumbnailImage;
+    QTemporaryDir tmpDir;
+    if (!tmpDir.isValid())
+        return thumbnailImage;
+    QString fileThumbnail=tmpDir.path()+"/thumbnail.png";
+
+    QMap<QString, QString> map=  videoInfo();
+    QString pos=map.value("Pos");
+
+    //ffmpeg -i ./kofar-bi-amirica.mp4 -y -ss 10.0 -vframes 1 -f image2 -s 128x128 thumbnail
+    QStringList list;
+    list<<"-i"<<m_url.path()     /*Input File Name*/
+       <<"-y"                    /*Overwrite*/
+       <<"-ss"<<pos              /* seeks in this position*/
+       <<"-vframes"<<"1"         /* Num Frames */
+       <<"-f"<<"image2"          /* file format.  */
+       <<"-s"<<"128x128"         /*<<"-vf"<<scal*/
+       <<fileThumbnail; /*output file Name */
+    qDebug()<<"the ffmpeg cmd: " << list;
 
-        if (!p.waitForFinished()) {
-            return thumbnailImage;
-        }
+    QProcess p;
+    p.start("ffmpeg",list);
 
-        QString err=p.readAllStandardError();
-        QString read=p.readAll();
-        if (err.contains("not contain any stream")) {
-            qWarning()<<"get video image failed.";
-            return thumbnailImage;
-        }
+    if (!p.waitForStarted()) {
+        return thumbnailImage;
+    }
+
+    if (!p.waitForFinished()) {
+        return thumbnailImage;
+    }
+
+    //ffmpeg ran, if there is still no image, the file can not be thumbnailed.
+    m_failed = true;
+
+    QString err=p.readAllStandardError();
+    QString read=p.readAll();
+    if (err.contains("not contain any stream")) {
+        qWarning()<<"get video image failed.";
+        return thumbnailImage;
     }
 
-    /*
-     *不知道会不会出现无效的图片的情况，可能需要对这种情况做处理
-    */
-    thumbnailImage = GenericThumbnailer::generateThumbnail(fileThumbnail, true);
+    thumbnailImage.load(fileThumbnail);
+    m_failed = thumbnailImage.isNull();
 
     return thumbnailImage;
 }
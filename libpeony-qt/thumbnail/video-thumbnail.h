@@ -24,8 +24,9 @@
 #define VIDEOTHUMBNAIL_H
 
 #include "file-info.h"
+#include "video-frame-extractor.h"
 #include <QHash>
-#include <QIcon>
+#include <QImage>
 #include <QMutex>
 #include <QUrl>
 
@@ -35,12 +36,40 @@ class VideoThumbnail{
 public:
     explicit VideoThumbnail(const QString &uri);
     ~VideoThumbnail();
-    QIcon generateThumbnail();
+    /*!
+     * \brief setCancelCallback
+     * \param callback, polled while the frame is being extracted, only
+     * the in process extractor can be canceled.
+     * \see VideoFrameExtractor::setCancelCallback().
+     */
+    void setCancelCallback(const VideoFrameExtractor::CancelCallback &callback) {
+        m_cancel_callback = callback;
+    }
+    /*!
+     * \brief generateThumbnail
+     * \return the extracted frame, or a null image.
+     * <br>
+     * The frame is decoded in process by VideoFrameExtractor if peony is built
+     * with libavformat and libavcodec, otherwise by the ffmpeg command.
+     * </br>
+     */
+    QImage generateThumbnail();
+    /*!
+     * \brief failed
+     * \return true if the video was read but no frame could be extracted,
+     * a null image caused by a missing ffmpeg or cancellation is not a failure.
+     */
+    bool failed() {
+        return m_failed;
+    }
 
 private:
     QMap<QString, QString> videoInfo();
+    QImage generateThumbnailByCommand();
+    VideoFrameExtractor::CancelCallback m_cancel_callback;
     QUrl m_url;
     quint64 m_modifyTime = 0;
+    bool m_failed = false;
 };
 
 #endif // VIDEOTHUMBNAIL_H
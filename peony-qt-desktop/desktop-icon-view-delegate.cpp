@@ -32,6 +32,7 @@
 #include "icon-view-delegate.h"
 #include "clipboard-utils.h"
 #include "desktop-item-model.h"
+#include "thumbnail-shadow.h"
 
 #include <QPushButton>
 #include <QWidget>
@@ -139,7 +140,7 @@ void DesktopIconViewDelegate::paint(QPainter *painter, const QStyleOptionViewIte
     auto text = opt.text;
     opt.text = nullptr;
 
-    style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, opt.widget);
+    ThumbnailShadow::paintItem(painter, opt, index.data(DesktopItemModel::UriRole).toString(), opt.widget);
 
     opt.text = text;
 
@@ -25,6 +25,7 @@
 
 #include "desktop-icon-view-delegate.h"
 #include "desktop-icon-view.h"
+#include "thumbnail-shadow.h"
 
 #include <QPainter>
 #include <QStyle>
@@ -117,7 +118,7 @@ void DesktopIndexWidget::paintEvent(QPaintEvent *e)
 
     // draw icon
     opt.text = nullptr;
-    QApplication::style()->drawControl(QStyle::CE_ItemViewItem, &opt, &p, m_delegate->getView());
+    ThumbnailShadow::paintItem(&p, opt, m_index.data(Qt::UserRole).toString(), m_delegate->getView());
 
     p.save();
     p.translate(0, 5 + m_delegate->getView()->iconSize().height() + 5);
@@ -64,7 +64,7 @@ DesktopItemModel::DesktopItemModel(QObject *parent)
 
     m_thumbnail_watcher = std::make_shared<FileWatcher>("thumbnail:///, this");
 
-    connect(m_thumbnail_watcher.get(), &FileWatcher::fileChanged, this, [=](const QString &uri) {
+    connect(ThumbnailManager::getInstance(), &ThumbnailManager::thumbnailReady, this, [=](const QString &uri) {
         for (auto info : m_files) {
             if (info->uri() == uri) {
                 auto index = indexFromUri(uri);
@@ -450,6 +450,10 @@ QVariant DesktopItemModel::data(const QModelIndex &index, int role) const
         if (!thumbnail.isNull()) {
             return thumbnail;
         }
+        //the thumbnail was evicted from memory, load it again since it is shown.
+        if (ThumbnailManager::getInstance()->takeEvictedThumbnail(info->uri())) {
+            ThumbnailManager::getInstance()->createThumbnail(info->uri(), m_thumbnail_watcher);
+        }
         return QIcon::fromTheme(info->iconName(), QIcon::fromTheme("text-x-generic"));
     }
     case UriRole:
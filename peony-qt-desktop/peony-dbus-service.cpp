@@ -24,6 +24,9 @@
 #include "peony-dbus-service.h"
 #include <QDBusConnection>
 #include <QDBusConnectionInterface>
+#include <QJsonDocument>
+
+#include "thumbnail-manager.h"
 
 #include <QDebug>
 using namespace Peony;
@@ -58,3 +61,9 @@ int PeonyDbusService::ReloadSecurityConfig()
 
     return 0;
 }
+
+QString PeonyDbusService::GetThumbnailStatistics()
+{
+    auto statistics = ThumbnailManager::getInstance()->statistics();
+    return QJsonDocument(statistics.toJson()).toJson(QJsonDocument::Compact);
+}
@@ -36,6 +36,7 @@
 接口：org.ukui.peony
 方法：GetSecurityConfigPath()//获取安全配置文件存放路径
      ReloadSecurityConfig()// 重新加载安全配置
+     GetThumbnailStatistics()//获取缩略图统计信息，json格式
 */
 
 namespace Peony {
@@ -56,6 +57,7 @@ public:
 public Q_SLOTS:
     QString GetSecurityConfigPath();
     int ReloadSecurityConfig();
+    QString GetThumbnailStatistics();
 
 private:
     DesktopIconView *m_desktopIconView = nullptr;
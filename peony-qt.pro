@@ -2,9 +2,13 @@ TEMPLATE = subdirs
 
 SUBDIRS = src libpeony-qt \ # plugin #libpeony-qt/test \ #plugin-iface
     #libpeony-qt/model/model-test \
+    #libpeony-qt/model/model-benchmark \
+    #libpeony-qt/model/population-benchmark \
+    #libpeony-qt/thumbnail/thumbnail-benchmark \
     #libpeony-qt/file-operation/file-operation-test \
     #peony-qt-plugin-test \
-    peony-qt-desktop
+    peony-qt-desktop \
+    peony-thumbnailer
 
 CONFIG += debug_and_release
 CONFIG(release,debug|release){
@@ -14,3 +18,4 @@ CONFIG(release,debug|release){
 src.depends = libpeony-qt
 peony-qt-plugin-test.depends = libpeony-qt
 peony-qt-desktop.depends = libpeony-qt
+peony-thumbnailer.depends = libpeony-qt
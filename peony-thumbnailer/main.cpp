@@ -0,0 +1,50 @@
+/*
+ * Peony-Qt
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "thumbnailer-service.h"
+#include "thumbnailer-worker.h"
+
+#include <QApplication>
+
+/*!
+ * peony-thumbnailer
+ * the thumbnail service activated by D-Bus.
+ * peony-thumbnailer --worker [--office]
+ * a worker process started by the service, an office worker
+ * converts office documents without the memory limit.
+ */
+int main(int argc, char *argv[])
+{
+    //no window is shown, but the thumbnailers use QImage, QIcon and gsettings.
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+    app.setApplicationName("peony-thumbnailer");
+
+    if (app.arguments().contains("--worker"))
+        return Peony::runThumbnailerWorker(!app.arguments().contains("--office"));
+
+    Peony::ThumbnailerService service;
+    if (!service.registerService())
+        return 0;
+
+    return app.exec();
+}
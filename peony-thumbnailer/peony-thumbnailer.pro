@@ -0,0 +1,35 @@
+#-------------------------------------------------
+#
+# The thumbnail service shared by peony and peony-qt-desktop.
+#
+#-------------------------------------------------
+
+QT       += core gui widgets dbus concurrent
+
+include(../common.pri)
+
+TARGET = peony-thumbnailer
+TEMPLATE = app
+QMAKE_CXXFLAGS += -Werror=return-type -Werror=return-local-addr -Werror=uninitialized -Werror=unused-label
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../libpeony-qt/libpeony-qt-header.pri)
+INCLUDEPATH += ../libpeony-qt/thumbnail
+
+PKGCONFIG += gio-2.0 glib-2.0 gio-unix-2.0
+CONFIG += c++11 link_pkgconfig no_keywords
+
+LIBS += -L$$PWD/../libpeony-qt/ -lpeony
+
+SOURCES += \
+    main.cpp \
+    thumbnailer-service.cpp \
+    thumbnailer-worker.cpp
+
+HEADERS += \
+    thumbnailer-service.h \
+    thumbnailer-worker.h
+
+target.path = /usr/bin
+!isEmpty(target.path): INSTALLS += target
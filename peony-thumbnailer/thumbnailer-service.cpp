@@ -0,0 +1,461 @@
+/*
+ * Peony-Qt
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "thumbnailer-service.h"
+#include "thumbnail-service-client.h"
+#include "thumbnail-manager.h"
+
+#include <QDBusConnection>
+#include <QDBusConnectionInterface>
+#include <QCoreApplication>
+#include <QThread>
+#include <QTimer>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QDebug>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+//a job is killed after this, in msec.
+#ifndef PEONY_THUMBNAILER_JOB_TIMEOUT
+#define PEONY_THUMBNAILER_JOB_TIMEOUT 60000
+#endif
+
+//the service quits after it has nothing to do for this long, in msec.
+#ifndef PEONY_THUMBNAILER_IDLE_TIMEOUT
+#define PEONY_THUMBNAILER_IDLE_TIMEOUT 30000
+#endif
+
+using namespace Peony;
+
+ThumbnailerService::ThumbnailerService(QObject *parent) : QObject(parent)
+{
+    m_max_workers = qMax(1, QThread::idealThreadCount());
+    m_clock.start();
+
+    m_idle_timer = new QTimer(this);
+    m_idle_timer->setSingleShot(true);
+    m_idle_timer->setInterval(PEONY_THUMBNAILER_IDLE_TIMEOUT);
+    connect(m_idle_timer, &QTimer::timeout, qApp, &QCoreApplication::quit);
+    m_idle_timer->start();
+}
+
+ThumbnailerService::~ThumbnailerService()
+{
+    for (auto worker : m_workers) {
+        worker->process->kill();
+        worker->process->waitForFinished();
+        delete worker;
+    }
+}
+
+bool ThumbnailerService::registerService()
+{
+    auto connection = QDBusConnection::sessionBus();
+    if (!connection.registerService(PEONY_THUMBNAILER_SERVICE)) {
+        qWarning()<<"peony-thumbnailer is already running";
+        return false;
+    }
+    return connection.registerObject(PEONY_THUMBNAILER_PATH, this, QDBusConnection::ExportAllSlots|QDBusConnection::ExportAllSignals);
+}
+
+QDBusUnixFileDescriptor ThumbnailerService::Thumbnail(const QString &uri, int kind, int &width, int &height, int &stride, int &format, bool &failed)
+{
+    Q_UNUSED(width)
+    Q_UNUSED(height)
+    Q_UNUSED(stride)
+    Q_UNUSED(format)
+    Q_UNUSED(failed)
+
+    //replied in finishJob().
+    setDelayedReply(true);
+
+    m_requests++;
+    if (!m_waiters.contains(uri)) {
+        m_queue<<uri;
+        m_queued_times.insert(uri, m_clock.nsecsElapsed());
+        m_kinds.insert(uri, kind >= 0 && kind < ThumbnailManager::JobKindCount? kind: ThumbnailManager::GenericJob);
+    } else {
+        m_merged_requests++;
+    }
+    m_waiters[uri]<<message();
+
+    updateIdleTimer();
+    schedule();
+
+    return QDBusUnixFileDescriptor();
+}
+
+void ThumbnailerService::Cancel(const QString &uri)
+{
+    auto it = m_waiters.find(uri);
+    if (it == m_waiters.end())
+        return;
+
+    QString client = message().service();
+    for (auto waiter = it.value().begin(); waiter != it.value().end();) {
+        if (waiter->service() == client) {
+            m_canceled_requests++;
+            reply(*waiter, QImage(), false);
+            waiter = it.value().erase(waiter);
+        } else {
+            ++waiter;
+        }
+    }
+
+    //a running job goes on, its thumbnail is saved for later.
+    if (it.value().isEmpty() && m_queue.removeOne(uri)) {
+        m_waiters.erase(it);
+        m_queued_times.remove(uri);
+        m_kinds.remove(uri);
+    }
+
+    updateIdleTimer();
+}
+
+QString ThumbnailerService::Statistics()
+{
+    auto timeStatisticsToJson = [](const ThumbnailTimeStatistics &statistics) {
+        QJsonObject object;
+        object.insert("count", double(statistics.count));
+        object.insert("failures", double(statistics.failures));
+        object.insert("average_ms", statistics.count > 0? statistics.totalUsec/1e3/statistics.count: 0);
+        object.insert("max_ms", statistics.maxUsec/1e3);
+        return object;
+    };
+
+    QJsonObject object;
+    object.insert("requests", double(m_requests));
+    object.insert("merged", double(m_merged_requests));
+    object.insert("canceled", double(m_canceled_requests));
+    object.insert("timeouts", double(m_timeouts));
+    object.insert("crashes", double(m_crashes));
+    object.insert("pending", m_queue.count());
+    object.insert("workers", m_workers.count());
+    object.insert("queue_wait", timeStatisticsToJson(m_queue_wait));
+    object.insert("job", timeStatisticsToJson(m_job));
+    return QJsonDocument(object).toJson(QJsonDocument::Compact);
+}
+
+void ThumbnailerService::schedule()
+{
+    int runningJobs[ThumbnailManager::JobKindCount] = {0, 0, 0};
+    int workerCount = 0;
+    for (auto worker : m_workers) {
+        if (worker == m_office_worker)
+            continue;
+        workerCount++;
+        if (!worker->uris.isEmpty())
+            runningJobs[worker->kind]++;
+    }
+
+    //the office documents are left to the office worker.
+    for (auto it = m_queue.begin(); it != m_queue.end();) {
+        int kind = m_kinds.value(*it);
+        if (kind == ThumbnailManager::OfficeJob || runningJobs[kind] >= ThumbnailManager::kindLimit(kind, m_max_workers)) {
+            ++it;
+            continue;
+        }
+
+        Worker *idleWorker = nullptr;
+        for (auto worker : m_workers) {
+            if (worker != m_office_worker && worker->uris.isEmpty()) {
+                idleWorker = worker;
+                break;
+            }
+        }
+        if (!idleWorker) {
+            if (workerCount >= m_max_workers)
+                break;
+            idleWorker = startWorker();
+            if (!idleWorker)
+                break;
+            workerCount++;
+        }
+
+        QString uri = *it;
+        it = m_queue.erase(it);
+        runningJobs[kind]++;
+        startJobs(idleWorker, QStringList()<<uri, kind);
+    }
+
+    //a new batch is not started until the running one is done, the documents
+    //queued meanwhile are converted together by the next one.
+    if (m_office_worker && !m_office_worker->uris.isEmpty())
+        return;
+
+    QStringList batch;
+    int officeLimit = ThumbnailManager::kindLimit(ThumbnailManager::OfficeJob, m_max_workers);
+    for (auto it = m_queue.begin(); it != m_queue.end() && batch.count() < officeLimit;) {
+        if (m_kinds.value(*it) == ThumbnailManager::OfficeJob) {
+            batch<<*it;
+            it = m_queue.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (batch.isEmpty())
+        return;
+
+    if (!m_office_worker)
+        m_office_worker = startWorker(true);
+    if (!m_office_worker) {
+        //try again when the queue changes.
+        m_queue = batch + m_queue;
+        return;
+    }
+    startJobs(m_office_worker, batch, ThumbnailManager::OfficeJob);
+}
+
+/*!
+ * \brief ThumbnailerService::startJobs
+ * <br>
+ * A single uri is sent as a line. Several uris are sent as a line
+ * "BATCH count" followed by the uris, the worker generates them concurrently.
+ * </br>
+ */
+void ThumbnailerService::startJobs(Worker *worker, const QStringList &uris, int kind)
+{
+    for (auto uri : uris) {
+        m_queue_wait.add((m_clock.nsecsElapsed() - m_queued_times.take(uri))/1000);
+    }
+
+    worker->uris = uris;
+    worker->kind = kind;
+    worker->elapsed.start();
+    worker->buffer.clear();
+    if (uris.count() > 1)
+        worker->process->write(QString("BATCH %1\n").arg(uris.count()).toUtf8());
+    for (auto uri : uris) {
+        worker->process->write(uri.toUtf8() + "\n");
+    }
+    worker->timer->start(PEONY_THUMBNAILER_JOB_TIMEOUT * uris.count());
+}
+
+ThumbnailerService::Worker *ThumbnailerService::startWorker(bool office)
+{
+    auto worker = new Worker;
+    worker->process = new QProcess(this);
+    worker->process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    connect(worker->process, &QProcess::readyReadStandardOutput, this, &ThumbnailerService::onWorkerReadyRead);
+    connect(worker->process, static_cast<void(QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
+            this, &ThumbnailerService::onWorkerFinished);
+
+    worker->timer = new QTimer(this);
+    worker->timer->setSingleShot(true);
+    worker->timer->setInterval(PEONY_THUMBNAILER_JOB_TIMEOUT);
+    connect(worker->timer, &QTimer::timeout, this, &ThumbnailerService::onJobTimeout);
+
+    QStringList args;
+    args<<"--worker";
+    if (office)
+        args<<"--office";
+    worker->process->start(QCoreApplication::applicationFilePath(), args);
+    if (!worker->process->waitForStarted()) {
+        qWarning()<<"can not start thumbnail worker";
+        worker->process->deleteLater();
+        worker->timer->deleteLater();
+        delete worker;
+        return nullptr;
+    }
+
+    m_workers<<worker;
+    return worker;
+}
+
+void ThumbnailerService::removeWorker(Worker *worker)
+{
+    m_workers.removeOne(worker);
+    if (worker == m_office_worker)
+        m_office_worker = nullptr;
+    worker->timer->stop();
+    worker->timer->deleteLater();
+    worker->process->disconnect(this);
+    worker->process->kill();
+    worker->process->deleteLater();
+    delete worker;
+}
+
+ThumbnailerService::Worker *ThumbnailerService::workerOf(QObject *object)
+{
+    for (auto worker : m_workers) {
+        if (worker->process == object || worker->timer == object)
+            return worker;
+    }
+    return nullptr;
+}
+
+/*!
+ * \brief ThumbnailerService::onWorkerReadyRead
+ * <br>
+ * A worker answers a uri with one of the lines:
+ * "OK width height stride format" followed by the pixels,
+ * "FAILED" if the file can not be thumbnailed,
+ * "NONE" if there is no thumbnailer for it, such as a missing ffmpeg.
+ * </br>
+ */
+void ThumbnailerService::onWorkerReadyRead()
+{
+    auto worker = workerOf(sender());
+    if (!worker)
+        return;
+
+    worker->buffer.append(worker->process->readAllStandardOutput());
+    bool answered = false;
+    while (!worker->uris.isEmpty()) {
+        int lineEnd = worker->buffer.indexOf('\n');
+        if (lineEnd < 0)
+            break;
+
+        auto header = QString::fromUtf8(worker->buffer.left(lineEnd)).split(' ');
+        QImage image;
+        bool failed = header.first() == "FAILED";
+        int answerSize = lineEnd + 1;
+        if (header.first() == "OK" && header.count() == 5) {
+            int width = header.at(1).toInt();
+            int height = header.at(2).toInt();
+            int stride = header.at(3).toInt();
+            auto format = QImage::Format(header.at(4).toInt());
+            int size = stride * height;
+            if (worker->buffer.size() - answerSize < size)
+                break;
+            auto data = reinterpret_cast<const uchar *>(worker->buffer.constData()) + answerSize;
+            image = QImage(data, width, height, stride, format).copy();
+            answerSize += size;
+        }
+
+        QString uri = worker->uris.takeFirst();
+        worker->buffer.remove(0, answerSize);
+        m_job.add(worker->elapsed.nsecsElapsed()/1000, failed);
+        answered = true;
+
+        finishJob(uri, image, failed);
+    }
+
+    if (!answered)
+        return;
+
+    if (worker->uris.isEmpty()) {
+        worker->buffer.clear();
+        worker->timer->stop();
+    }
+    schedule();
+}
+
+void ThumbnailerService::onWorkerFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    auto worker = workerOf(sender());
+    if (!worker)
+        return;
+
+    QStringList uris = worker->uris;
+    qint64 usec = worker->elapsed.nsecsElapsed()/1000;
+    removeWorker(worker);
+
+    //crashed, or ran out of the memory limit.
+    for (auto uri : uris) {
+        m_crashes++;
+        m_job.add(usec, true);
+        qWarning()<<"thumbnail worker exited on"<<uri<<exitCode<<exitStatus;
+        ThumbnailManager::markThumbnailFailed(uri);
+        finishJob(uri, QImage(), true);
+    }
+
+    schedule();
+}
+
+void ThumbnailerService::onJobTimeout()
+{
+    auto worker = workerOf(sender());
+    if (!worker)
+        return;
+
+    QStringList uris = worker->uris;
+    qint64 usec = worker->elapsed.nsecsElapsed()/1000;
+    removeWorker(worker);
+
+    for (auto uri : uris) {
+        m_timeouts++;
+        m_job.add(usec, true);
+        qWarning()<<"thumbnail worker timed out on"<<uri;
+        ThumbnailManager::markThumbnailFailed(uri);
+        finishJob(uri, QImage(), true);
+    }
+
+    schedule();
+}
+
+void ThumbnailerService::finishJob(const QString &uri, const QImage &image, bool failed)
+{
+    m_kinds.remove(uri);
+    auto waiters = m_waiters.take(uri);
+    for (auto waiter : waiters) {
+        reply(waiter, image, failed);
+    }
+
+    if (!image.isNull()) {
+        Q_EMIT ThumbnailReady(uri);
+    } else if (failed) {
+        Q_EMIT ThumbnailFailed(uri);
+    }
+
+    updateIdleTimer();
+}
+
+void ThumbnailerService::reply(const QDBusMessage &message, const QImage &image, bool failed)
+{
+    //an empty memfd is sent for a null image, an invalid descriptor can not be marshalled.
+    int fd = memfd_create("peony-thumbnail", MFD_CLOEXEC);
+    if (fd < 0) {
+        QDBusConnection::sessionBus().send(message.createErrorReply(QDBusError::Failed, "can not create memfd"));
+        return;
+    }
+
+    int size = image.isNull()? 0: image.bytesPerLine() * image.height();
+    if (size > 0 && write(fd, image.constBits(), size) != size) {
+        close(fd);
+        QDBusConnection::sessionBus().send(message.createErrorReply(QDBusError::Failed, "can not write memfd"));
+        return;
+    }
+
+    auto reply = message.createReply();
+    reply<<QVariant::fromValue(QDBusUnixFileDescriptor(fd))
+         <<image.width()
+         <<image.height()
+         <<int(image.bytesPerLine())
+         <<int(image.format())
+         <<failed;
+    QDBusConnection::sessionBus().send(reply);
+
+    //QDBusUnixFileDescriptor holds a duplicate.
+    close(fd);
+}
+
+void ThumbnailerService::updateIdleTimer()
+{
+    if (m_waiters.isEmpty()) {
+        m_idle_timer->start();
+    } else {
+        m_idle_timer->stop();
+    }
+}
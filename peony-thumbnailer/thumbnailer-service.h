@@ -0,0 +1,164 @@
+/*
+ * Peony-Qt
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef THUMBNAILERSERVICE_H
+#define THUMBNAILERSERVICE_H
+
+#include <QObject>
+#include <QDBusContext>
+#include <QDBusMessage>
+#include <QDBusUnixFileDescriptor>
+#include <QProcess>
+#include <QHash>
+#include <QImage>
+#include <QStringList>
+#include <QElapsedTimer>
+
+#include "thumbnail-manager.h"
+
+class QTimer;
+
+/*
+名称：org.ukui.peony.Thumbnailer
+对象路径：/org/ukui/peony/Thumbnailer
+接口：org.ukui.peony.Thumbnailer
+方法：Thumbnail(uri, kind)//生成缩略图，kind为ThumbnailManager::JobKind，返回像素所在的memfd及宽、高、行字节数、格式、是否失败
+     Cancel(uri)//调用者不再等待uri的缩略图
+     Statistics()//获取服务的统计信息，json格式
+信号：ThumbnailReady(uri)
+     ThumbnailFailed(uri)
+*/
+
+namespace Peony {
+
+/*!
+ * \brief The ThumbnailerService class
+ * <br>
+ * ThumbnailerService is the thumbnail service shared by peony and
+ * peony-qt-desktop. The requests of the same uri from all clients are
+ * merged into one job, and the jobs are run by worker processes, so a
+ * crash of decoder does not take down the clients.
+ * </br>
+ * <br>
+ * A worker runs one job at a time with a memory limit, and it is killed
+ * if the job takes too long. The video jobs are limited as ThumbnailManager
+ * does. The office documents are sent to a dedicated worker in batches, so
+ * its OfficeConverter converts them with one libreoffice process, and no
+ * two libreoffice processes of the service share the converter profile. A crashed or killed job leaves a failure
+ * marker in the disk cache, so it is not tried again until the file changes.
+ * The pixels are sent to every waiting client through a memfd, and the
+ * completion is also broadcasted by ThumbnailReady() and ThumbnailFailed().
+ * </br>
+ * \note
+ * The service is activated by D-Bus, and quits after it is idle for a while.
+ * \see ThumbnailServiceClient, ThumbnailManager::generateThumbnailImage().
+ */
+class ThumbnailerService : public QObject, protected QDBusContext
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.ukui.peony.Thumbnailer")
+
+public:
+    explicit ThumbnailerService(QObject *parent = nullptr);
+    ~ThumbnailerService();
+
+    bool registerService();
+
+Q_SIGNALS:
+    void ThumbnailReady(const QString &uri);
+    void ThumbnailFailed(const QString &uri);
+
+public Q_SLOTS:
+    QDBusUnixFileDescriptor Thumbnail(const QString &uri, int kind, int &width, int &height, int &stride, int &format, bool &failed);
+    void Cancel(const QString &uri);
+    QString Statistics();
+
+private Q_SLOTS:
+    void onWorkerReadyRead();
+    void onWorkerFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void onJobTimeout();
+
+private:
+    struct Worker {
+        QProcess *process = nullptr;
+        QTimer *timer = nullptr;
+        /*!
+         * \brief uris
+         * the uris sent to worker, they are answered in order.
+         */
+        QStringList uris;
+        int kind = ThumbnailManager::GenericJob;
+        QByteArray buffer;
+        QElapsedTimer elapsed;
+    };
+
+    void schedule();
+    void startJobs(Worker *worker, const QStringList &uris, int kind);
+    Worker *startWorker(bool office = false);
+    void removeWorker(Worker *worker);
+    Worker *workerOf(QObject *object);
+    /*!
+     * \brief finishJob
+     * reply all waiters of uri, and broadcast the completion.
+     */
+    void finishJob(const QString &uri, const QImage &image, bool failed);
+    void reply(const QDBusMessage &message, const QImage &image, bool failed);
+    void updateIdleTimer();
+
+    /*!
+     * \brief m_waiters
+     * the method calls waiting for each pending or running uri.
+     */
+    QHash<QString, QList<QDBusMessage>> m_waiters;
+    QStringList m_queue;
+    QHash<QString, qint64> m_queued_times;
+    QHash<QString, int> m_kinds;
+
+    QList<Worker *> m_workers;
+    int m_max_workers = 1;
+    /*!
+     * \brief m_office_worker
+     * the worker converting office documents, it is not counted in m_max_workers
+     * as it waits for libreoffice most of the time.
+     */
+    Worker *m_office_worker = nullptr;
+
+    QTimer *m_idle_timer = nullptr;
+
+    /*!
+     * \brief m_statistics
+     * jobs of the service, failures of job are the failed thumbnails,
+     * timeouts and crashes are also counted separately.
+     */
+    quint64 m_requests = 0;
+    quint64 m_merged_requests = 0;
+    quint64 m_canceled_requests = 0;
+    quint64 m_timeouts = 0;
+    quint64 m_crashes = 0;
+    ThumbnailTimeStatistics m_queue_wait;
+    ThumbnailTimeStatistics m_job;
+    QElapsedTimer m_clock;
+};
+
+}
+
+#endif // THUMBNAILERSERVICE_H
@@ -0,0 +1,114 @@
+/*
+ * Peony-Qt
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "thumbnailer-worker.h"
+#include "thumbnail-manager.h"
+
+#include <QFile>
+#include <QImage>
+#include <QFuture>
+#include <QtConcurrent>
+#include <QDebug>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#ifndef PEONY_THUMBNAILER_MEMORY_LIMIT
+#define PEONY_THUMBNAILER_MEMORY_LIMIT 512*1024*1024
+#endif
+
+using namespace Peony;
+
+/*!
+ * \brief generateAnswer
+ * \return the answer of uri described in ThumbnailerService::onWorkerReadyRead().
+ */
+static QByteArray generateAnswer(const QString &uri)
+{
+    bool failed = false;
+    QImage image = ThumbnailManager::getInstance()->generateThumbnailImage(uri, &failed);
+    if (image.isNull())
+        return failed? "FAILED\n": "NONE\n";
+
+    image = image.convertToFormat(image.hasAlphaChannel()? QImage::Format_ARGB32: QImage::Format_RGB32);
+    QByteArray answer = QString("OK %1 %2 %3 %4\n").arg(image.width())
+            .arg(image.height())
+            .arg(image.bytesPerLine())
+            .arg(int(image.format())).toUtf8();
+    answer.append(reinterpret_cast<const char *>(image.constBits()), image.bytesPerLine() * image.height());
+    return answer;
+}
+
+int Peony::runThumbnailerWorker(bool limitMemory)
+{
+    //only the soft limit is lowered, so a child can raise it again.
+    struct rlimit limit;
+    if (limitMemory && getrlimit(RLIMIT_DATA, &limit) == 0) {
+        if (limit.rlim_max == RLIM_INFINITY || limit.rlim_max > PEONY_THUMBNAILER_MEMORY_LIMIT)
+            limit.rlim_cur = PEONY_THUMBNAILER_MEMORY_LIMIT;
+        else
+            limit.rlim_cur = limit.rlim_max;
+        if (setrlimit(RLIMIT_DATA, &limit) != 0)
+            qWarning()<<"can not limit the memory of thumbnail worker";
+    }
+
+    //keep the answers away from the libraries printing to stdout.
+    int answerFd = dup(STDOUT_FILENO);
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+
+    QFile input;
+    QFile output;
+    if (!input.open(stdin, QIODevice::ReadOnly) || !output.open(answerFd, QIODevice::WriteOnly, QFileDevice::AutoCloseHandle))
+        return -1;
+
+    //the manager is created in main thread, before the batches use it.
+    ThumbnailManager::getInstance();
+    while (true) {
+        QByteArray line = input.readLine();
+        if (line.isEmpty())
+            break;
+        QString uri = QString::fromUtf8(line).trimmed();
+        if (uri.isEmpty())
+            continue;
+
+        if (!uri.startsWith("BATCH ")) {
+            output.write(generateAnswer(uri));
+            output.flush();
+            continue;
+        }
+
+        //the office documents generated at the same time are converted together
+        //by OfficeConverter, the answers are still written in order.
+        int count = uri.mid(6).toInt();
+        QList<QFuture<QByteArray>> answers;
+        for (int i = 0; i < count; i++) {
+            QString batchUri = QString::fromUtf8(input.readLine()).trimmed();
+            answers<<QtConcurrent::run(generateAnswer, batchUri);
+        }
+        for (auto answer : answers) {
+            output.write(answer.result());
+        }
+        output.flush();
+    }
+
+    return 0;
+}
@@ -0,0 +1,52 @@
+/*
+ * Peony-Qt
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef THUMBNAILERWORKER_H
+#define THUMBNAILERWORKER_H
+
+namespace Peony {
+
+/*!
+ * \brief runThumbnailerWorker
+ * \return the exit code of worker process.
+ * <br>
+ * A worker reads uris from stdin, one per line, generates their thumbnails
+ * with ThumbnailManager::generateThumbnailImage(), and writes the answers
+ * described in ThumbnailerService::onWorkerReadyRead() to stdout. It exits
+ * when stdin is closed.
+ * </br>
+ * <br>
+ * A line "BATCH count" is followed by count uris, which are generated
+ * concurrently, so that the office documents among them are converted by
+ * one libreoffice process. They are answered in order.
+ * </br>
+ * \param limitMemory, whether the data segment of worker is limited.
+ * \note
+ * The data segment of a decoding worker is limited, a decoder which allocates
+ * too much fails or crashes the worker instead of the service. The office
+ * worker is not limited, as libreoffice started by it needs much more.
+ */
+int runThumbnailerWorker(bool limitMemory = true);
+
+}
+
+#endif // THUMBNAILERWORKER_H